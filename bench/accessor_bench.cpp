@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "graphics/geometry/accessor.hpp"
+
+using namespace gfx::geometry;
+
+struct Vertex
+{
+    f32 pos[3];
+    f32 normal[3];
+    f32 uv[2];
+};
+
+static constexpr usize VERTEX_COUNT = 4 * 1024 * 1024;
+static constexpr u32 ITERATIONS = 10;
+
+template<typename F>
+static f64 measure(F &&func)
+{
+    f64 best = 1e30;
+    for (u32 i = 0; i < ITERATIONS; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        func();
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<f64, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+static void report(const char *name, f64 scalarMs, f64 kernelMs)
+{
+    std::cout << name << ": scalar " << scalarMs << " ms, kernel " << kernelMs
+              << " ms (" << scalarMs / kernelMs << "x)" << std::endl;
+}
+
+int main()
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<f32> dist(-1.0f, 1.0f);
+
+    std::vector<Vertex> vertices(VERTEX_COUNT);
+
+    std::vector<f32> positions(VERTEX_COUNT * 3);
+    for (auto &p : positions) {
+        p = dist(rng);
+    }
+
+    std::vector<i16> normals(VERTEX_COUNT * 4);
+    for (auto &n : normals) {
+        n = static_cast<i16>(dist(rng) * 32767.0f);
+    }
+
+    std::vector<u16> uvs(VERTEX_COUNT * 2);
+    for (auto &uv : uvs) {
+        uv = static_cast<u16>((dist(rng) * 0.5f + 0.5f) * 65535.0f);
+    }
+
+    std::vector<u16> indices16(VERTEX_COUNT * 3);
+    for (usize i = 0; i < indices16.size(); i++) {
+        indices16[i] = static_cast<u16>(rng());
+    }
+    std::vector<u32> indices(indices16.size());
+
+    std::cout << "AVX2: " << (hasAVX2() ? "yes" : "no") << std::endl;
+
+    AccessorView posView;
+    posView.data = reinterpret_cast<const u8 *>(positions.data());
+    posView.count = VERTEX_COUNT;
+    posView.components = 3;
+    posView.componentType = ComponentType::F32;
+
+    f64 scalar = measure([&] {
+        for (usize i = 0; i < VERTEX_COUNT; i++) {
+            memcpy(vertices[i].pos, &positions[i * 3], sizeof(f32) * 3);
+        }
+    });
+    f64 kernel = measure([&] {
+        readFloats(posView, 3, vertices.data()->pos, sizeof(Vertex));
+    });
+    report("float3 position", scalar, kernel);
+
+    AccessorView normalView;
+    normalView.data = reinterpret_cast<const u8 *>(normals.data());
+    normalView.count = VERTEX_COUNT;
+    normalView.stride = sizeof(i16) * 4;
+    normalView.components = 3;
+    normalView.componentType = ComponentType::I16;
+    normalView.normalized = true;
+
+    scalar = measure([&] {
+        for (usize i = 0; i < VERTEX_COUNT; i++) {
+            for (u32 c = 0; c < 3; c++) {
+                vertices[i].normal[c] = std::max(normals[i * 4 + c] / 32767.0f, -1.0f);
+            }
+        }
+    });
+    kernel = measure([&] {
+        readFloats(normalView, 3, vertices.data()->normal, sizeof(Vertex));
+    });
+    report("strided snorm16 normal", scalar, kernel);
+
+    AccessorView uvView;
+    uvView.data = reinterpret_cast<const u8 *>(uvs.data());
+    uvView.count = VERTEX_COUNT;
+    uvView.components = 2;
+    uvView.componentType = ComponentType::U16;
+    uvView.normalized = true;
+
+    scalar = measure([&] {
+        for (usize i = 0; i < VERTEX_COUNT; i++) {
+            vertices[i].uv[0] = uvs[i * 2] / 65535.0f;
+            vertices[i].uv[1] = uvs[i * 2 + 1] / 65535.0f;
+        }
+    });
+    kernel = measure([&] {
+        readFloats(uvView, 2, vertices.data()->uv, sizeof(Vertex));
+    });
+    report("unorm16 uv", scalar, kernel);
+
+    AccessorView indexView;
+    indexView.data = reinterpret_cast<const u8 *>(indices16.data());
+    indexView.count = indices16.size();
+    indexView.componentType = ComponentType::U16;
+
+    scalar = measure([&] {
+        for (usize i = 0; i < indices16.size(); i++) {
+            indices[i] = indices16[i];
+        }
+    });
+    kernel = measure([&] {
+        readIndices(indexView, indices.data());
+    });
+    report("u16 index widening", scalar, kernel);
+
+    return 0;
+}
\ No newline at end of file
@@ -80,7 +80,8 @@ void BindlessManager::init(Device &device)
         VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT,
 
         VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
-        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+        VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT
     };
 
     VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
@@ -238,6 +239,39 @@ u32 BindlessManager::addTexture(
     return handle;
 }
 
+void BindlessManager::updateTexture(
+    u32 id,
+    const Image &image,
+    VkSampler sampler
+)
+{
+    if (image.getImageView() == VK_NULL_HANDLE) {
+        throw std::runtime_error("Image view is not created.");
+    }
+
+    if (sampler == VK_NULL_HANDLE) {
+        sampler = m_device->getDefaultSampler();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (
+        id >= m_resources.size() ||
+        !m_resources[id].isUsed ||
+        m_resources[id].type != ResourceType::TEXTURE
+    ) {
+        return;
+    }
+
+    m_resources[id].imageView = image.getImageView();
+    m_resources[id].sampler = sampler;
+
+    if (!m_resources[id].isDirty) {
+        m_resources[id].isDirty = true;
+        m_dirtyResources.push_back(id);
+    }
+}
+
 void BindlessManager::removeResource(u32 id)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
@@ -253,6 +287,54 @@ void BindlessManager::removeResource(u32 id)
     m_resources[id].range = 0;
 }
 
+void BindlessManager::replaceBuffer(VkBuffer oldBuffer, VkBuffer newBuffer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (u32 id = 0; id < m_resources.size(); id++) {
+        ResourceSlot &slot = m_resources[id];
+
+        if (
+            !slot.isUsed ||
+            slot.type == ResourceType::TEXTURE ||
+            slot.buffer != oldBuffer
+        ) {
+            continue;
+        }
+
+        slot.buffer = newBuffer;
+
+        if (!slot.isDirty) {
+            slot.isDirty = true;
+            m_dirtyResources.push_back(id);
+        }
+    }
+}
+
+void BindlessManager::replaceImageView(VkImageView oldView, VkImageView newView)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (u32 id = 0; id < m_resources.size(); id++) {
+        ResourceSlot &slot = m_resources[id];
+
+        if (
+            !slot.isUsed ||
+            slot.type != ResourceType::TEXTURE ||
+            slot.imageView != oldView
+        ) {
+            continue;
+        }
+
+        slot.imageView = newView;
+
+        if (!slot.isDirty) {
+            slot.isDirty = true;
+            m_dirtyResources.push_back(id);
+        }
+    }
+}
+
 void BindlessManager::update()
 {
     std::lock_guard<std::mutex> lock(m_mutex);
@@ -265,6 +347,10 @@ void BindlessManager::update()
     std::vector<VkDescriptorBufferInfo> bufferInfos;
     std::vector<VkDescriptorImageInfo> imageInfos;
 
+    // Writes point into these, so they must not reallocate.
+    bufferInfos.reserve(m_dirtyResources.size() * 2);
+    imageInfos.reserve(m_dirtyResources.size());
+
     for (u32 index : m_dirtyResources) {
         auto &resource = m_resources[index];
 
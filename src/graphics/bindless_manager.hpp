@@ -51,14 +51,31 @@ public:
         VkSampler sampler = VK_NULL_HANDLE
     );
 
+    // Points an existing texture slot at another image. The slot must not
+    // be used by any frame still in flight.
+    void updateTexture(
+        u32 id,
+        const Image &image,
+        VkSampler sampler = VK_NULL_HANDLE
+    );
+
     void removeResource(u32 id);
 
+    // Repoint every slot that uses `oldBuffer` or `oldView`, e.g. after
+    // the defragmenter moved a resource. Same rules as updateTexture().
+    void replaceBuffer(VkBuffer oldBuffer, VkBuffer newBuffer);
+    void replaceImageView(VkImageView oldView, VkImageView newView);
+
     void update();
 
 public:
     VkDescriptorSetLayout getDescriptorSetLayout() const { return m_descriptorSetLayout; }
     VkDescriptorSet getDescriptorSet() const { return m_descriptorSet; }
 
+    // IDs are unique across bindings; shaders index the binding's array
+    // with this instead.
+    u32 getIndex(u32 id) const { return m_resources[id].arrayIndex; }
+
 private:
     Device *m_device = nullptr;
 
@@ -97,7 +114,7 @@ private:
     u32 m_nextTextureIndex = 0;
 
     static constexpr u32 MAX_UBOS = 64;
-    static constexpr u32 MAX_SSBOS = 64;
+    static constexpr u32 MAX_SSBOS = 256;
     static constexpr u32 MAX_TEXTURES = 256;
 
     static constexpr u32 UBO_BINDING = 0;
@@ -113,4 +130,4 @@ private:
 
 };
 
-} // namespace gfx
+} // namespace gfx
\ No newline at end of file
@@ -8,15 +8,30 @@ void Buffer::init(
     Device &device,
     VkDeviceSize size,
     VkBufferUsageFlags usage,
-    VmaMemoryUsage memoryUsage
+    VmaMemoryUsage memoryUsage,
+    HostAccess hostAccess
 )
 {
     m_device = &device;
     m_size = size;
+    m_usage = usage;
 
     VmaAllocationCreateInfo allocInfo{};
     allocInfo.usage = memoryUsage;
 
+    switch (hostAccess) {
+        case HostAccess::None:
+            break;
+        case HostAccess::SequentialWrite:
+            allocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                VMA_ALLOCATION_CREATE_MAPPED_BIT;
+            break;
+        case HostAccess::Random:
+            allocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT |
+                VMA_ALLOCATION_CREATE_MAPPED_BIT;
+            break;
+    }
+
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = size;
@@ -35,14 +50,36 @@ void Buffer::init(
     );
 
     vk::check(res, "Failed to create buffer!");
+
+    m_device->getMemoryBudget().track(m_allocation, MemoryBudget::getBufferCategory(usage));
+
+    VkMemoryPropertyFlags memoryProperties = 0;
+    vmaGetAllocationMemoryProperties(m_device->getAllocator(), m_allocation, &memoryProperties);
+    m_isHostVisible = memoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+    if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+        VkBufferDeviceAddressInfo addressInfo{};
+        addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+        addressInfo.buffer = m_buffer;
+
+        m_deviceAddress = vkGetBufferDeviceAddress(m_device->getDevice(), &addressInfo);
+    }
+
+    if (hostAccess != HostAccess::None) {
+        m_data = allocationInfo.pMappedData;
+        m_isMapped = true;
+        m_isPersistent = true;
+    }
 }
 
 void Buffer::destroy()
 {
-    if (m_isMapped) {
+    if (m_isMapped && !m_isPersistent) {
         unmap();
     }
 
+    m_device->getMemoryBudget().untrack(m_allocation);
+
     vmaDestroyBuffer(
         m_device->getAllocator(),
         m_buffer,
@@ -50,6 +87,19 @@ void Buffer::destroy()
     );
 }
 
+void Buffer::deferDestroy()
+{
+    if (!m_buffer) {
+        return;
+    }
+
+    m_device->deferDestroy([buffer = *this]() mutable {
+        buffer.destroy();
+    });
+
+    *this = Buffer{};
+}
+
 void *Buffer::map()
 {
     if (m_isMapped) {
@@ -70,7 +120,7 @@ void *Buffer::map()
 
 void Buffer::unmap()
 {
-    if (!m_isMapped) {
+    if (!m_isMapped || m_isPersistent) {
         return;
     }
 
@@ -78,4 +128,41 @@ void Buffer::unmap()
     m_isMapped = false;
 }
 
+void Buffer::upload(const void *data, VkDeviceSize size, VkDeviceSize offset)
+{
+    if (offset + size > m_size) {
+        throw std::runtime_error("Buffer size is too small for upload data.");
+    }
+
+    if (m_isHostVisible) {
+        u8 *mappedData = static_cast<u8 *>(map());
+        memcpy(mappedData + offset, data, size);
+        flush(offset, size);
+        unmap();
+        return;
+    }
+
+    StagingAllocation staging = m_device->getStagingPool().allocate(size);
+    memcpy(staging.data, data, size);
+
+    VkCommandBuffer cmd = m_device->beginSingleTimeCommands();
+
+    VkBufferCopy region{ staging.offset, offset, size };
+    vkCmdCopyBuffer(cmd, staging.buffer, m_buffer, 1, &region);
+
+    m_device->endSingleTimeCommands(cmd);
+}
+
+void Buffer::flush(VkDeviceSize offset, VkDeviceSize size)
+{
+    VkResult res = vmaFlushAllocation(m_device->getAllocator(), m_allocation, offset, size);
+    vk::check(res, "Failed to flush buffer!");
+}
+
+void Buffer::invalidate(VkDeviceSize offset, VkDeviceSize size)
+{
+    VkResult res = vmaInvalidateAllocation(m_device->getAllocator(), m_allocation, offset, size);
+    vk::check(res, "Failed to invalidate buffer!");
+}
+
 } // namespace gfx
\ No newline at end of file
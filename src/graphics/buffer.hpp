@@ -17,6 +17,15 @@ class Buffer
 {
 
 public:
+    // How the host touches the memory. Anything but None keeps the buffer
+    // mapped for its whole lifetime, so map() and unmap() cost nothing.
+    enum class HostAccess
+    {
+        None,
+        SequentialWrite,    // memcpy style writes only, never reads
+        Random              // Reads, e.g. readback
+    };
+
     Buffer() = default;
     ~Buffer() = default;
 
@@ -24,14 +33,28 @@ public:
         Device &device,
         VkDeviceSize size,
         VkBufferUsageFlags usage,
-        VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_AUTO
+        VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_AUTO,
+        HostAccess hostAccess = HostAccess::None
     );
 
     void destroy();
 
+    // destroy() once the frames in flight are done with the buffer.
+    void deferDestroy();
+
     void *map();
     void unmap();
 
+    // Needed around host access to non-coherent memory: flush after
+    // writing, invalidate before reading. No-ops on coherent memory.
+    void flush(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+    void invalidate(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+    // Host visible buffers are written directly; others go through the
+    // device staging pool and need transfer destination usage. Returns
+    // once the data is in place.
+    void upload(const void *data, VkDeviceSize size, VkDeviceSize offset = 0);
+
     template<typename T>
     void uploadData(const T *data, u32 count);
 
@@ -42,30 +65,35 @@ public:
     VkBuffer getBuffer() const { return m_buffer; }
     VmaAllocation getAllocation() const { return m_allocation; }
     VkDeviceSize getSize() const { return m_size; }
+    VkBufferUsageFlags getUsage() const { return m_usage; }
+
+    // For buffer_reference pointers in shaders; 0 unless the buffer was
+    // created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT.
+    VkDeviceAddress getDeviceAddress() const { return m_deviceAddress; }
+    bool isPersistentlyMapped() const { return m_isPersistent; }
 
 private:
+    friend class Defragmenter;
+
     Device *m_device = nullptr;
 
     VkBuffer m_buffer = VK_NULL_HANDLE;
     VmaAllocation m_allocation = VK_NULL_HANDLE;
     VkDeviceSize m_size = 0;
+    VkBufferUsageFlags m_usage = 0;
+    VkDeviceAddress m_deviceAddress = 0;
 
     void *m_data = nullptr;
     bool m_isMapped = false;
+    bool m_isPersistent = false;
+    bool m_isHostVisible = false;
 
 };
 
 template<typename T>
 void Buffer::uploadData(const T *data, u32 count)
 {
-    VkDeviceSize size = sizeof(T) * count;
-    if (size > m_size) {
-        throw std::runtime_error("Buffer size is too small for upload data.");
-    }
-
-    void *mappedData = map();
-    memcpy(mappedData, data, size);
-    unmap();
+    upload(data, sizeof(T) * count);
 }
 
 template<typename T>
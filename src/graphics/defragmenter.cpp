@@ -0,0 +1,402 @@
+#include "defragmenter.hpp"
+#include "device.hpp"
+#include "buffer.hpp"
+#include "image.hpp"
+#include "bindless_manager.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace gfx
+{
+
+void Defragmenter::init(Device &device, const DefragmenterOptions &options)
+{
+    m_device = &device;
+    m_options = options;
+
+    m_commandPool = vk::createCommandPool(
+        device.getDevice(),
+        device.getQueueFamilyIndices().graphicsFamily.value(),
+        VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+    );
+    m_commandBuffer = vk::createCommandBuffer(device.getDevice(), m_commandPool);
+}
+
+void Defragmenter::destroy()
+{
+    if (m_passValue) {
+        m_device->wait(m_passValue);
+        endPass();
+    }
+
+    if (m_context) {
+        vmaEndDefragmentation(m_device->getAllocator(), m_context, nullptr);
+        m_context = VK_NULL_HANDLE;
+    }
+
+    vkDestroyCommandPool(m_device->getDevice(), m_commandPool, nullptr);
+    m_commandPool = VK_NULL_HANDLE;
+    m_commandBuffer = VK_NULL_HANDLE;
+
+    m_resources.clear();
+}
+
+void Defragmenter::update()
+{
+    m_frame++;
+
+    if (m_passValue) {
+        if (!m_device->isComplete(m_passValue)) {
+            return;
+        }
+
+        endPass();
+        if (!m_context) {
+            return;
+        }
+    }
+
+    if (!m_context) {
+        bool isCheckFrame = m_frame % m_options.checkInterval == 0;
+        if (!m_isRequested && !(isCheckFrame && isFragmented())) {
+            return;
+        }
+
+        m_isRequested = false;
+
+        VmaDefragmentationInfo info{};
+        info.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+        info.maxBytesPerPass = m_options.maxBytesPerPass;
+        info.maxAllocationsPerPass = m_options.maxAllocationsPerPass;
+
+        VkResult res = vmaBeginDefragmentation(m_device->getAllocator(), &info, &m_context);
+        vk::check(res, "Failed to begin defragmentation");
+    }
+
+    runPass();
+}
+
+void Defragmenter::addBuffer(Buffer &buffer)
+{
+    m_resources[buffer.getAllocation()] = { &buffer, nullptr };
+}
+
+void Defragmenter::addImage(Image &image)
+{
+    m_resources[image.getAllocation()] = { nullptr, &image };
+}
+
+void Defragmenter::removeBuffer(const Buffer &buffer)
+{
+    removeAllocation(buffer.getAllocation());
+}
+
+void Defragmenter::removeImage(const Image &image)
+{
+    removeAllocation(image.getAllocation());
+}
+
+void Defragmenter::removeAllocation(VmaAllocation allocation)
+{
+    for (u32 i = 0; m_passValue && i < m_pass.moveCount; i++) {
+        const VmaDefragmentationMove &move = m_pass.pMoves[i];
+
+        // The allocation has to outlive the pass that moves it, since VMA
+        // releases its old memory when the pass ends.
+        if (
+            move.srcAllocation == allocation &&
+            move.operation == VMA_DEFRAGMENTATION_MOVE_OPERATION_COPY
+        ) {
+            m_device->wait(m_passValue);
+            endPass();
+        }
+    }
+
+    m_resources.erase(allocation);
+}
+
+bool Defragmenter::isFragmented() const
+{
+    VmaTotalStatistics stats{};
+    vmaCalculateStatistics(m_device->getAllocator(), &stats);
+
+    const VmaStatistics &total = stats.total.statistics;
+
+    // A single block cannot be compacted into fewer.
+    if (total.blockCount < 2 || total.blockBytes == 0) {
+        return false;
+    }
+
+    VkDeviceSize unused = total.blockBytes - total.allocationBytes;
+    return static_cast<f64>(unused) / static_cast<f64>(total.blockBytes) > m_options.threshold;
+}
+
+bool Defragmenter::isMovable(const Resource &resource) const
+{
+    if (resource.buffer) {
+        VkBufferUsageFlags transfer =
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+        return !resource.buffer->m_isMapped &&
+            (resource.buffer->m_usage & transfer) == transfer;
+    }
+
+    const Image &image = *resource.image;
+
+    VkImageUsageFlags transfer =
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    return !image.m_sparse &&
+        (image.m_usage & transfer) == transfer &&
+        image.m_samples == VK_SAMPLE_COUNT_1_BIT &&
+        image.m_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+void Defragmenter::runPass()
+{
+    m_pass = {};
+    VkResult res = vmaBeginDefragmentationPass(m_device->getAllocator(), m_context, &m_pass);
+
+    if (res == VK_SUCCESS) {
+        finish();
+        return;
+    }
+
+    if (res != VK_INCOMPLETE) {
+        vk::check(res, "Failed to begin defragmentation pass");
+    }
+
+    vkResetCommandPool(m_device->getDevice(), m_commandPool, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    res = vkBeginCommandBuffer(m_commandBuffer, &beginInfo);
+    vk::check(res, "Failed to begin defragmentation command buffer");
+
+    Retired retired;
+    VkCommandBuffer cmd = m_commandBuffer;
+
+    // Frames recorded earlier may still write what is copied here.
+    VkMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.memoryBarrierCount = 1;
+    dependencyInfo.pMemoryBarriers = &barrier;
+
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+
+    for (u32 i = 0; i < m_pass.moveCount; i++) {
+        VmaDefragmentationMove &move = m_pass.pMoves[i];
+
+        auto it = m_resources.find(move.srcAllocation);
+        if (it == m_resources.end() || !isMovable(it->second)) {
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            continue;
+        }
+
+        VmaAllocationInfo info{};
+        vmaGetAllocationInfo(m_device->getAllocator(), move.srcAllocation, &info);
+
+        if (it->second.buffer) {
+            moveBuffer(cmd, *it->second.buffer, move.dstTmpAllocation, retired);
+        } else {
+            moveImage(cmd, *it->second.image, move.dstTmpAllocation, retired);
+        }
+
+        m_movedCount++;
+        m_movedBytes += info.size;
+    }
+
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+
+    res = vkEndCommandBuffer(cmd);
+    vk::check(res, "Failed to end defragmentation command buffer");
+
+    // Submitted ahead of the frame on the same queue, so the last barrier
+    // covers the frame's reads of the new resources.
+    u64 inFlightValue = m_device->getSubmittedValue();
+    m_passValue = m_device->submit(cmd);
+
+    // A pending frame must not see descriptors of resources that are not
+    // copied yet, and the texture slots cannot be rewritten while in use.
+    m_device->wait(inFlightValue);
+    m_device->getBindlessManager().update();
+
+    // Frames in flight may still use the old handles.
+    m_device->deferDestroy([device = m_device->getDevice(), retired]() {
+        for (VkImageView view : retired.views) {
+            vkDestroyImageView(device, view, nullptr);
+        }
+
+        for (VkImage image : retired.images) {
+            vkDestroyImage(device, image, nullptr);
+        }
+
+        for (VkBuffer buffer : retired.buffers) {
+            vkDestroyBuffer(device, buffer, nullptr);
+        }
+    });
+}
+
+void Defragmenter::endPass()
+{
+    m_passValue = 0;
+
+    // Moved allocations keep their handle and now point at the new memory.
+    VkResult res = vmaEndDefragmentationPass(m_device->getAllocator(), m_context, &m_pass);
+
+    if (res == VK_SUCCESS) {
+        finish();
+    }
+}
+
+void Defragmenter::finish()
+{
+    VmaDefragmentationStats stats{};
+    vmaEndDefragmentation(m_device->getAllocator(), m_context, &stats);
+    m_context = VK_NULL_HANDLE;
+
+    std::cout << "Defragmentation: " << m_movedCount << " allocations, "
+              << stats.bytesFreed << " bytes freed" << std::endl;
+}
+
+void Defragmenter::moveBuffer(
+    VkCommandBuffer cmd,
+    Buffer &buffer,
+    VmaAllocation dstAllocation,
+    Retired &retired
+)
+{
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = buffer.m_size;
+    bufferInfo.usage = buffer.m_usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer newBuffer;
+    VkResult res = vkCreateBuffer(m_device->getDevice(), &bufferInfo, nullptr, &newBuffer);
+    vk::check(res, "Failed to create defragmentation buffer");
+
+    res = vmaBindBufferMemory(m_device->getAllocator(), dstAllocation, newBuffer);
+    vk::check(res, "Failed to bind defragmentation buffer");
+
+    VkBufferCopy region{ 0, 0, buffer.m_size };
+    vkCmdCopyBuffer(cmd, buffer.m_buffer, newBuffer, 1, &region);
+
+    m_device->getBindlessManager().replaceBuffer(buffer.m_buffer, newBuffer);
+    retired.buffers.push_back(buffer.m_buffer);
+
+    buffer.m_buffer = newBuffer;
+
+    if (buffer.m_deviceAddress) {
+        VkBufferDeviceAddressInfo addressInfo{};
+        addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+        addressInfo.buffer = newBuffer;
+
+        buffer.m_deviceAddress = vkGetBufferDeviceAddress(m_device->getDevice(), &addressInfo);
+    }
+}
+
+void Defragmenter::moveImage(
+    VkCommandBuffer cmd,
+    Image &image,
+    VmaAllocation dstAllocation,
+    Retired &retired
+)
+{
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.flags = image.m_createFlags;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = { image.m_width, image.m_height, 1 };
+    imageInfo.mipLevels = image.m_mipLevels;
+    imageInfo.arrayLayers = image.m_arrayLayers;
+    imageInfo.format = image.m_format;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = image.m_usage;
+    imageInfo.samples = image.m_samples;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkImage newImage;
+    VkResult res = vkCreateImage(m_device->getDevice(), &imageInfo, nullptr, &newImage);
+    vk::check(res, "Failed to create defragmentation image");
+
+    res = vmaBindImageMemory(m_device->getAllocator(), dstAllocation, newImage);
+    vk::check(res, "Failed to bind defragmentation image");
+
+    VkImage oldImage = image.m_image;
+    VkImageView oldView = image.m_imageView;
+
+    image.transitionLayout(
+        cmd,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        VK_PIPELINE_STAGE_2_COPY_BIT
+    );
+
+    image.m_image = newImage;
+    image.m_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    image.transitionLayout(
+        cmd,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_2_NONE,
+        VK_PIPELINE_STAGE_2_COPY_BIT
+    );
+
+    std::vector<VkImageCopy> regions(image.m_mipLevels);
+    for (u32 level = 0; level < image.m_mipLevels; level++) {
+        VkImageCopy &region = regions[level];
+        region.srcSubresource.aspectMask = image.m_aspectFlags;
+        region.srcSubresource.mipLevel = level;
+        region.srcSubresource.layerCount = image.m_arrayLayers;
+        region.dstSubresource = region.srcSubresource;
+        region.extent = {
+            std::max(image.m_width >> level, 1u),
+            std::max(image.m_height >> level, 1u),
+            1
+        };
+    }
+
+    vkCmdCopyImage(
+        cmd,
+        oldImage,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        newImage,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<u32>(regions.size()),
+        regions.data()
+    );
+
+    image.transitionLayout(
+        cmd,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_2_COPY_BIT,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
+    );
+
+    retired.images.push_back(oldImage);
+
+    if (oldView) {
+        image.createImageView(image.m_aspectFlags);
+        m_device->getBindlessManager().replaceImageView(oldView, image.m_imageView);
+        retired.views.push_back(oldView);
+    }
+}
+
+} // namespace gfx
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "core/types.hpp"
+
+namespace gfx
+{
+
+class Device;
+class Buffer;
+class Image;
+
+struct DefragmenterOptions
+{
+    // Frames between fragmentation checks while idle.
+    u32 checkInterval = 600;
+
+    // Share of the memory in VMA blocks that is unused before a
+    // defragmentation starts.
+    f32 threshold = 0.25f;
+
+    // Bounds of one pass; at most one pass is in flight at a time.
+    VkDeviceSize maxBytesPerPass = 16ull << 20;
+    u32 maxAllocationsPerPass = 64;
+};
+
+// Compacts VMA blocks with incremental defragmentation passes. Only
+// resources added here are moved: their owner must keep the Buffer or
+// Image at a fixed address and remove it before destroying it. A moved
+// resource gets a new handle and view, and bindless descriptors pointing
+// at the old ones are rewritten.
+//
+// Each pass copies on the graphics queue ahead of the frame without
+// waiting for the copies. The bindless set is shared by every frame, so
+// its descriptors are only rewritten once the frames already in flight
+// finished. The old handles are destroyed through Device::deferDestroy,
+// and VMA releases the old memory on the first update after the copies
+// finished, so a pass spans at least one frame.
+class Defragmenter
+{
+
+public:
+    Defragmenter() = default;
+    ~Defragmenter() = default;
+
+    void init(Device &device, const DefragmenterOptions &options = {});
+    void destroy();
+
+    // Called by Device::beginFrame before recording starts.
+    void update();
+
+    // Moving copies on the device, so resources need transfer source and
+    // destination usage. Host mapped buffers and images outside the shader
+    // read layout are skipped.
+    void addBuffer(Buffer &buffer);
+    void addImage(Image &image);
+
+    // Waits for the pass in flight when it moves the resource.
+    void removeBuffer(const Buffer &buffer);
+    void removeImage(const Image &image);
+
+    // Starts defragmenting on the next update, regardless of the
+    // threshold.
+    void request() { m_isRequested = true; }
+
+public:
+    bool isActive() const { return m_context != VK_NULL_HANDLE; }
+    u32 getMovedCount() const { return m_movedCount; }
+    VkDeviceSize getMovedBytes() const { return m_movedBytes; }
+
+private:
+    struct Resource
+    {
+        Buffer *buffer = nullptr;
+        Image *image = nullptr;
+    };
+
+    Device *m_device = nullptr;
+    DefragmenterOptions m_options;
+
+    std::unordered_map<VmaAllocation, Resource> m_resources;
+
+    VmaDefragmentationContext m_context = VK_NULL_HANDLE;
+    u64 m_frame = 0;
+
+    VkCommandPool m_commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer m_commandBuffer = VK_NULL_HANDLE;
+
+    VmaDefragmentationPassMoveInfo m_pass{};
+
+    // Timeline value of the pass in flight, 0 when there is none.
+    u64 m_passValue = 0;
+    bool m_isRequested = false;
+
+    u32 m_movedCount = 0;
+    VkDeviceSize m_movedBytes = 0;
+
+    // Handles replaced during a pass, destroyed once no frame uses them.
+    struct Retired
+    {
+        std::vector<VkBuffer> buffers;
+        std::vector<VkImage> images;
+        std::vector<VkImageView> views;
+    };
+
+    bool isFragmented() const;
+    bool isMovable(const Resource &resource) const;
+
+    void runPass();
+    void endPass();
+    void finish();
+
+    void removeAllocation(VmaAllocation allocation);
+
+    void moveBuffer(
+        VkCommandBuffer cmd,
+        Buffer &buffer,
+        VmaAllocation dstAllocation,
+        Retired &retired
+    );
+
+    void moveImage(
+        VkCommandBuffer cmd,
+        Image &image,
+        VmaAllocation dstAllocation,
+        Retired &retired
+    );
+
+};
+
+} // namespace gfx
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "deletion_queue.hpp"
+
+namespace gfx
+{
+
+void DeletionQueue::push(std::function<void()> destroy)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.push_back({ 0, std::move(destroy) });
+}
+
+void DeletionQueue::seal(u64 key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (usize i = m_sealedCount; i < m_entries.size(); i++) {
+        m_entries[i].key = key;
+    }
+
+    m_sealedCount = m_entries.size();
+}
+
+void DeletionQueue::flush(u64 key)
+{
+    // Run outside the lock, since destroy calls may defer more work.
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        while (m_sealedCount > 0 && m_entries.front().key <= key) {
+            ready.push_back(std::move(m_entries.front().destroy));
+            m_entries.pop_front();
+            m_sealedCount--;
+        }
+    }
+
+    for (auto &destroy : ready) {
+        destroy();
+    }
+}
+
+} // namespace gfx
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "core/types.hpp"
+
+namespace gfx
+{
+
+// Destroy calls waiting for the GPU to finish with what they release.
+// Entries are keyed by seal(), e.g. with the timeline value of the next
+// frame submitted after them; flush() runs the entries whose key is done.
+class DeletionQueue
+{
+
+public:
+    DeletionQueue() = default;
+    ~DeletionQueue() = default;
+
+    // Safe from any thread.
+    void push(std::function<void()> destroy);
+
+    // Keys every entry pushed since the last call with `key`. Keys must
+    // not decrease.
+    void seal(u64 key);
+
+    // Runs every sealed entry keyed `key` or lower, in push order.
+    void flush(u64 key);
+
+public:
+    bool isEmpty() const { return m_entries.empty(); }
+
+private:
+    struct Entry
+    {
+        u64 key = 0;
+        std::function<void()> destroy;
+    };
+
+    std::deque<Entry> m_entries;
+    usize m_sealedCount = 0;
+    std::mutex m_mutex;
+
+};
+
+} // namespace gfx
\ No newline at end of file
@@ -1,5 +1,4 @@
 #include "depth_buffer.hpp"
-#include "image.hpp"
 #include "device.hpp"
 
 namespace gfx
@@ -10,42 +9,39 @@ void DepthBuffer::init(Device &device, u32 width, u32 height)
     m_device = &device;
     m_format = findDepthFormat();
 
-    m_image.init(
-        device,
-        width,
-        height,
-        m_format,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-        VK_IMAGE_ASPECT_DEPTH_BIT | (
-            hasStencilComponent(m_format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0
-        ),
-        1,
-        VK_SAMPLE_COUNT_1_BIT,
-        VMA_MEMORY_USAGE_GPU_ONLY
+    // Cleared and discarded within the frame, so it stays transient and
+    // spans every pass.
+    RenderTargetDesc desc;
+    desc.width = width;
+    desc.height = height;
+    desc.format = m_format;
+    desc.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    desc.aspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT | (
+        hasStencilComponent(m_format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0
     );
+
+    m_target = device.getRenderTargetAllocator().add(desc);
 }
 
 void DepthBuffer::destroy()
 {
-    m_image.destroy();
+    m_device->getRenderTargetAllocator().remove(m_target);
+    m_target = ~0u;
 }
 
 void DepthBuffer::resize(u32 width, u32 height)
 {
-    m_image.destroy();
-    m_image.init(
-        *m_device,
-        width,
-        height,
-        m_format,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-        VK_IMAGE_ASPECT_DEPTH_BIT | (
-            hasStencilComponent(m_format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0
-        ),
-        1,
-        VK_SAMPLE_COUNT_1_BIT,
-        VMA_MEMORY_USAGE_GPU_ONLY
-    );
+    m_device->getRenderTargetAllocator().resize(m_target, width, height);
+}
+
+VkImage DepthBuffer::getImage() const
+{
+    return m_device->getRenderTargetAllocator().getImage(m_target).getImage();
+}
+
+VkImageView DepthBuffer::getImageView() const
+{
+    return m_device->getRenderTargetAllocator().getImage(m_target).getImageView();
 }
 
 VkFormat DepthBuffer::findDepthFormat()
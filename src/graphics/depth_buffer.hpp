@@ -3,7 +3,6 @@
 #include <vulkan/vulkan.h>
 
 #include "core/types.hpp"
-#include "image.hpp"
 
 namespace gfx
 {
@@ -23,13 +22,14 @@ public:
 
 public:
     VkFormat getFormat() const { return m_format; }
-    VkImage getImage() const { return m_image.getImage(); }
-    VkImageView getImageView() const { return m_image.getImageView(); }
+    VkImage getImage() const;
+    VkImageView getImageView() const;
 
 private:
     Device *m_device = nullptr;
 
-    Image m_image;
+    // Render target of the device's allocator.
+    u32 m_target = ~0u;
     VkFormat m_format = VK_FORMAT_UNDEFINED;
 
 private:
@@ -17,11 +17,19 @@ void Device::init(
     m_surface = vk::createSurface(window.get(), m_instance);
     
     m_physicalDevice = vk::pickPhysicalDevice(m_instance, m_surface);
-    m_device = vk::createLogicalDevice(m_physicalDevice, m_surface);
+    m_features = vk::queryDeviceFeatures(m_physicalDevice);
+    m_device = vk::createLogicalDevice(m_physicalDevice, m_surface, m_features);
+
+    if (m_features.meshShader) {
+        m_cmdDrawMeshTasks = reinterpret_cast<PFN_vkCmdDrawMeshTasksEXT>(
+            vkGetDeviceProcAddr(m_device, "vkCmdDrawMeshTasksEXT")
+        );
+    }
 
     m_queueFamilyIndices = vk::findQueueFamilies(m_physicalDevice, m_surface);
     m_graphicsQueue = vk::getGraphicsQueue(m_device, m_queueFamilyIndices);
     m_presentQueue = vk::getPresentQueue(m_device, m_queueFamilyIndices);
+    m_timeline = vk::createTimelineSemaphore(m_device);
 
     u32 width = m_window->getWidth();
     u32 height = m_window->getHeight();
@@ -41,24 +49,41 @@ void Device::init(
         );
     }
 
-    m_allocator = vk::createAllocator(m_instance, m_device, m_physicalDevice);
+    m_allocator = vk::createAllocator(m_instance, m_device, m_physicalDevice, m_features);
+    m_memoryBudget.init(*this);
+    m_stagingPool.init(*this);
+    m_renderTargetAllocator.init(*this);
     m_depthBuffer.init(*this, width, height);
+    m_renderTargetAllocator.build();
 
-    m_defaultSampler = createSampler(
+    m_samplerCache.init(*this);
+    m_defaultSampler = getSampler(
         VK_FILTER_LINEAR,
         VK_FILTER_LINEAR,
         VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER
     );
 
     m_bindlessManager.init(*this);
+    m_defragmenter.init(*this);
+    m_downsampler.init(*this);
+    m_frameAllocator.init(*this);
 }
 
 void Device::destroy()
 {
+    m_deletionQueue.seal(m_submittedValue);
+    m_deletionQueue.flush(U64_MAX);
+
+    m_frameAllocator.destroy();
+    m_downsampler.destroy();
+    m_defragmenter.destroy();
     m_bindlessManager.destroy();
-    vkDestroySampler(m_device, m_defaultSampler, nullptr);
+    m_samplerCache.destroy();
 
     m_depthBuffer.destroy();
+    m_renderTargetAllocator.destroy();
+    m_stagingPool.destroy();
+    m_memoryBudget.destroy();
     vmaDestroyAllocator(m_allocator);
 
     for (auto frame : m_frames) {
@@ -66,6 +91,7 @@ void Device::destroy()
     }
 
     m_swapchain.destroy();
+    vkDestroySemaphore(m_device, m_timeline, nullptr);
 
     vkDestroyDevice(m_device, nullptr);
     vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
@@ -76,7 +102,16 @@ void Device::destroy()
 
 VkCommandBuffer Device::beginFrame()
 {
-    m_swapchain.beginFrame(m_currentFrame);
+    wait(m_frames[m_currentFrame].timelineValue);
+    m_deletionQueue.flush(getCompletedValue());
+
+    // The frame that last used this partition has finished.
+    m_frameAllocator.reset(m_currentFrame);
+
+    m_memoryBudget.update();
+
+    // Moves resources while nothing is recorded against them yet.
+    m_defragmenter.update();
 
     auto [imageIndex, image] = m_swapchain.acquireNextImage(m_currentFrame);
     m_imageIndex = imageIndex;
@@ -221,7 +256,20 @@ void Device::endFrame()
     VkResult res = vkEndCommandBuffer(frame.commandBuffer);
     vk::check(res, "Failed to end command buffer");
 
-    m_swapchain.submit(m_currentFrame, frame.commandBuffer, m_graphicsQueue);
+    m_frameAllocator.flush();
+
+    VkSemaphoreSubmitInfo imageWait{};
+    imageWait.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    imageWait.semaphore = m_swapchain.getImageSemaphore(m_currentFrame);
+    imageWait.stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    VkSemaphoreSubmitInfo renderSignal{};
+    renderSignal.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    renderSignal.semaphore = m_swapchain.getRenderSemaphore(m_currentFrame);
+    renderSignal.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    frame.timelineValue = submit(frame.commandBuffer, { imageWait }, { renderSignal });
+    m_deletionQueue.seal(frame.timelineValue);
 
     m_swapchain.present(m_currentFrame, m_presentQueue);
     if (m_swapchain.isOutOfDate()) {
@@ -266,14 +314,7 @@ void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer)
     VkResult res = vkEndCommandBuffer(commandBuffer);
     vk::check(res, "Failed to end single time command buffer");
 
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    res = vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vk::check(res, "Failed to submit single time command buffer");
-    vkQueueWaitIdle(m_graphicsQueue);
+    wait(submit(commandBuffer));
 
     vkFreeCommandBuffers(
         m_device,
@@ -283,16 +324,113 @@ void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer)
     );
 }
 
-VkSampler Device::createSampler(
+u64 Device::submit(
+    VkCommandBuffer commandBuffer,
+    const std::vector<VkSemaphoreSubmitInfo> &waits,
+    const std::vector<VkSemaphoreSubmitInfo> &signals
+)
+{
+    std::lock_guard<std::mutex> lock(m_submitMutex);
+
+    u64 value = m_submittedValue + 1;
+
+    std::vector<VkSemaphoreSubmitInfo> signalInfos = signals;
+
+    VkSemaphoreSubmitInfo timelineSignal{};
+    timelineSignal.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    timelineSignal.semaphore = m_timeline;
+    timelineSignal.value = value;
+    timelineSignal.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    signalInfos.push_back(timelineSignal);
+
+    VkCommandBufferSubmitInfo commandBufferInfo{};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+    commandBufferInfo.commandBuffer = commandBuffer;
+
+    VkSubmitInfo2 submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+    submitInfo.waitSemaphoreInfoCount = static_cast<u32>(waits.size());
+    submitInfo.pWaitSemaphoreInfos = waits.data();
+    submitInfo.commandBufferInfoCount = 1;
+    submitInfo.pCommandBufferInfos = &commandBufferInfo;
+    submitInfo.signalSemaphoreInfoCount = static_cast<u32>(signalInfos.size());
+    submitInfo.pSignalSemaphoreInfos = signalInfos.data();
+
+    m_stagingPool.submit(value);
+
+    VkResult res = vkQueueSubmit2(m_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+    vk::check(res, "Failed to submit command buffer");
+
+    m_submittedValue = value;
+    return value;
+}
+
+u64 Device::bindSparse(const VkBindSparseInfo &bindInfo)
+{
+    std::lock_guard<std::mutex> lock(m_submitMutex);
+
+    u64 value = m_submittedValue + 1;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &value;
+
+    VkBindSparseInfo info = bindInfo;
+    info.pNext = &timelineInfo;
+    info.signalSemaphoreCount = 1;
+    info.pSignalSemaphores = &m_timeline;
+
+    VkResult res = vkQueueBindSparse(m_graphicsQueue, 1, &info, VK_NULL_HANDLE);
+    vk::check(res, "Failed to bind sparse memory");
+
+    m_submittedValue = value;
+    return value;
+}
+
+void Device::wait(u64 value)
+{
+    if (isComplete(value)) {
+        return;
+    }
+
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &m_timeline;
+    waitInfo.pValues = &value;
+
+    VkResult res = vkWaitSemaphores(m_device, &waitInfo, U64_MAX);
+    vk::check(res, "Failed to wait for timeline semaphore");
+}
+
+bool Device::isComplete(u64 value)
+{
+    // The cached value only grows, so most polls skip the query.
+    return value <= m_completedValue || value <= getCompletedValue();
+}
+
+u64 Device::getCompletedValue()
+{
+    u64 value = 0;
+    VkResult res = vkGetSemaphoreCounterValue(m_device, m_timeline, &value);
+    vk::check(res, "Failed to query timeline semaphore");
+
+    // Another thread may have stored a newer value meanwhile.
+    u64 completed = m_completedValue;
+    while (value > completed && !m_completedValue.compare_exchange_weak(completed, value)) {
+    }
+
+    return value;
+}
+
+VkSampler Device::getSampler(
     VkFilter magFilter,
     VkFilter minFilter,
     VkSamplerAddressMode addressMode,
     f32 maxAnisotropy
 )
 {
-    VkPhysicalDeviceProperties properties{};
-    vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
-
     VkSamplerCreateInfo samplerInfo{};
     samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
     samplerInfo.magFilter = magFilter;
@@ -301,25 +439,52 @@ VkSampler Device::createSampler(
     samplerInfo.addressModeV = addressMode;
     samplerInfo.addressModeW = addressMode;
     samplerInfo.anisotropyEnable = VK_TRUE;
-    samplerInfo.maxAnisotropy = maxAnisotropy > 0.0f ? 
-        maxAnisotropy : properties.limits.maxSamplerAnisotropy;
+    samplerInfo.maxAnisotropy = maxAnisotropy > 0.0f ?
+        maxAnisotropy : m_samplerCache.getMaxAnisotropy();
     samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
     samplerInfo.unnormalizedCoordinates = VK_FALSE;
     samplerInfo.compareEnable = VK_FALSE;
     samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
     samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
 
-    VkSampler sampler;
-    VkResult res = vkCreateSampler(m_device, &samplerInfo, nullptr, &sampler);
-    
-    vk::check(res, "Failed to create texture sampler");
-
-    return sampler;
+    return m_samplerCache.getSampler(samplerInfo);
 }
 
 void Device::waitIdle()
 {
     vkDeviceWaitIdle(m_device);
+
+    m_deletionQueue.seal(m_submittedValue);
+    m_deletionQueue.flush(U64_MAX);
+}
+
+void Device::deferDestroy(std::function<void()> destroy)
+{
+    // Sealed with the value of the next frame submit in endFrame().
+    m_deletionQueue.push(std::move(destroy));
+}
+
+bool Device::isFormatSupported(VkFormat format, VkFormatFeatureFlags features) const
+{
+    if (vk::isBlockCompressed(format) && !m_features.textureCompressionBC) {
+        return false;
+    }
+
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &properties);
+
+    return (properties.optimalTilingFeatures & features) == features;
+}
+
+void Device::drawMeshTasks(
+    VkCommandBuffer cmd,
+    u32 groupCountX,
+    u32 groupCountY,
+    u32 groupCountZ
+) const
+{
+    m_cmdDrawMeshTasks(cmd, groupCountX, groupCountY, groupCountZ);
 }
 
 void Device::recreateSwapchain()
@@ -336,6 +501,7 @@ void Device::recreateSwapchain()
 
     m_swapchain.recreate(width, height);
     m_depthBuffer.resize(width, height);
+    m_renderTargetAllocator.build();
 }
 
 } // namespace gfx
\ No newline at end of file
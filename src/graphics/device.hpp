@@ -2,7 +2,10 @@
 
 #include <vulkan/vulkan.h>
 
+#include <atomic>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "core/types.hpp"
 #include "core/window/window.hpp"
@@ -10,7 +13,15 @@
 #include "utils/init.hpp"
 #include "swapchain.hpp"
 #include "depth_buffer.hpp"
+#include "render_target_allocator.hpp"
 #include "bindless_manager.hpp"
+#include "downsampler.hpp"
+#include "sampler_cache.hpp"
+#include "frame_allocator.hpp"
+#include "staging_pool.hpp"
+#include "memory_budget.hpp"
+#include "defragmenter.hpp"
+#include "deletion_queue.hpp"
 
 namespace gfx
 {
@@ -33,43 +44,100 @@ public:
     VkCommandBuffer beginFrame();
     void endFrame();
 
+    // The end call waits only for its own submit.
     VkCommandBuffer beginSingleTimeCommands();
     void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 
-    VkSampler createSampler(
+    // Every submit to the graphics queue signals the device timeline
+    // semaphore with the next value, and returns that value. Submits run
+    // in order, so reaching a value means every earlier submit finished.
+    // Also hands the staging allocations this thread made so far to this
+    // submit.
+    u64 submit(
+        VkCommandBuffer commandBuffer,
+        const std::vector<VkSemaphoreSubmitInfo> &waits = {},
+        const std::vector<VkSemaphoreSubmitInfo> &signals = {}
+    );
+
+    // vkQueueBindSparse on the graphics queue; `bindInfo` must not signal
+    // semaphores of its own. Later submits wait for the returned value to
+    // use the bound memory.
+    u64 bindSparse(const VkBindSparseInfo &bindInfo);
+
+    // Blocks until the timeline reached `value`.
+    void wait(u64 value);
+    bool isComplete(u64 value);
+    u64 getCompletedValue();
+
+    // Shared through the sampler cache; never destroy the result. A
+    // `maxAnisotropy` of 0 uses the device limit.
+    VkSampler getSampler(
         VkFilter magFilter,
         VkFilter minFilter,
         VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT,
         f32 maxAnisotropy = 1.0f
     );
 
+    // Also runs every deferred destroy.
     void waitIdle();
 
+    // Runs `destroy` once the next frame submit, and so every frame
+    // recorded so far, has finished on the GPU. Resources in use by frames
+    // in flight can be released without waitIdle().
+    void deferDestroy(std::function<void()> destroy);
+
+    // Optimal tiling features; compressed formats also need the matching
+    // device feature enabled.
+    bool isFormatSupported(VkFormat format, VkFormatFeatureFlags features) const;
+
+    // Only valid when getFeatures().meshShader is set.
+    void drawMeshTasks(
+        VkCommandBuffer cmd,
+        u32 groupCountX,
+        u32 groupCountY = 1,
+        u32 groupCountZ = 1
+    ) const;
+
 public:
     VkInstance getInstance() const { return m_instance; }
     VkPhysicalDevice getPhysicalDevice() const { return m_physicalDevice; }
     VkDevice getDevice() const { return m_device; }
+    const vk::DeviceFeatures &getFeatures() const { return m_features; }
 
     VkSurfaceKHR getSurface() const { return m_surface; }
     Swapchain &getSwapchain() { return m_swapchain; }
 
     VmaAllocator getAllocator() const { return m_allocator; }
 
+    RenderTargetAllocator &getRenderTargetAllocator() { return m_renderTargetAllocator; }
     DepthBuffer &getDepthBuffer() { return m_depthBuffer; }
     VkFormat getDepthFormat() const { return m_depthBuffer.getFormat(); }
 
     VkSampler getDefaultSampler() const { return m_defaultSampler; }
 
+    SamplerCache &getSamplerCache() { return m_samplerCache; }
     BindlessManager &getBindlessManager() { return m_bindlessManager; }
+    Downsampler &getDownsampler() { return m_downsampler; }
+    FrameAllocator &getFrameAllocator() { return m_frameAllocator; }
+    StagingPool &getStagingPool() { return m_stagingPool; }
+    MemoryBudget &getMemoryBudget() { return m_memoryBudget; }
+    Defragmenter &getDefragmenter() { return m_defragmenter; }
+
+    VkSemaphore getTimeline() const { return m_timeline; }
+    u64 getSubmittedValue() const { return m_submittedValue; }
 
     VkQueue getGraphicsQueue() const { return m_graphicsQueue; }
     VkQueue getPresentQueue() const { return m_presentQueue; }
+    const vk::QueueFamilyIndices &getQueueFamilyIndices() const { return m_queueFamilyIndices; }
 
 private:
     struct FrameData
     {
         VkCommandPool commandPool = VK_NULL_HANDLE;
         VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+        // Timeline value of the last frame submitted from this slot.
+        u64 timelineValue = 0;
     };
 
 private:
@@ -78,15 +146,23 @@ private:
     VkInstance m_instance = VK_NULL_HANDLE;
     VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
     VkDevice m_device = VK_NULL_HANDLE;
+    vk::DeviceFeatures m_features;
 
     VkSurfaceKHR m_surface = VK_NULL_HANDLE;
     Swapchain m_swapchain;
     VmaAllocator m_allocator = VK_NULL_HANDLE;
+    MemoryBudget m_memoryBudget;
+    RenderTargetAllocator m_renderTargetAllocator;
     DepthBuffer m_depthBuffer;
 
+    SamplerCache m_samplerCache;
     VkSampler m_defaultSampler = VK_NULL_HANDLE;
 
     BindlessManager m_bindlessManager;
+    Downsampler m_downsampler;
+    FrameAllocator m_frameAllocator;
+    StagingPool m_stagingPool;
+    Defragmenter m_defragmenter;
 
     vk::QueueFamilyIndices m_queueFamilyIndices;
     VkQueue m_graphicsQueue = VK_NULL_HANDLE;
@@ -94,10 +170,21 @@ private:
 
     VkDebugUtilsMessengerEXT m_debugMessenger = VK_NULL_HANDLE;
 
+    PFN_vkCmdDrawMeshTasksEXT m_cmdDrawMeshTasks = nullptr;
+
     std::array<FrameData, MAX_FRAMES_IN_FLIGHT> m_frames;
     u32 m_currentFrame = 0;
     u32 m_imageIndex = 0;
 
+    VkSemaphore m_timeline = VK_NULL_HANDLE;
+    std::atomic<u64> m_submittedValue = 0;
+    std::atomic<u64> m_completedValue = 0;
+
+    // Signal values must grow in queue order.
+    std::mutex m_submitMutex;
+
+    DeletionQueue m_deletionQueue;
+
 private:
     void recreateSwapchain();
 
@@ -0,0 +1,409 @@
+#include "downsampler.hpp"
+#include "device.hpp"
+#include "image.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace gfx
+{
+
+namespace
+{
+
+constexpr u32 LEVELS_BINDING = 0;
+constexpr u32 LEVEL6_BINDING = 1;
+constexpr u32 COUNTERS_BINDING = 2;
+
+// Storage images cannot be sRGB; those are written through a UNORM view
+// and encoded in the shader.
+VkFormat getStorageFormat(VkFormat format, bool &srgb)
+{
+    srgb = true;
+
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            return VK_FORMAT_B8G8R8A8_UNORM;
+        case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+            return VK_FORMAT_A8B8G8R8_UNORM_PACK32;
+        default:
+            srgb = false;
+            return format;
+    }
+}
+
+} // namespace
+
+void Downsampler::init(Device &device)
+{
+    m_device = &device;
+
+    // Levels are accessed without a format qualifier, so one shader
+    // covers every color format.
+    if (!device.getFeatures().storageImageWithoutFormat) {
+        std::cout << "Compute mip generation disabled: formatless storage images not supported" << std::endl;
+        return;
+    }
+
+    std::vector<VkDescriptorPoolSize> poolSizes = {
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_TARGETS * (MAX_LEVELS + 1)},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MAX_TARGETS}
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    poolInfo.maxSets = MAX_TARGETS;
+    poolInfo.poolSizeCount = static_cast<u32>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    VkResult res = vkCreateDescriptorPool(
+        device.getDevice(),
+        &poolInfo,
+        nullptr,
+        &m_descriptorPool
+    );
+
+    vk::check(res, "Failed to create downsampler descriptor pool.");
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings = {
+        {
+            LEVELS_BINDING,
+            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            MAX_LEVELS,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            nullptr
+        },
+        {
+            LEVEL6_BINDING,
+            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            1,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            nullptr
+        },
+        {
+            COUNTERS_BINDING,
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            1,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            nullptr
+        }
+    };
+
+    // Short chains leave the upper levels and level 6 unbound.
+    std::vector<VkDescriptorBindingFlags> bindingFlags = {
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+        0
+    };
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = static_cast<u32>(bindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<u32>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    layoutInfo.pNext = &bindingFlagsInfo;
+
+    res = vkCreateDescriptorSetLayout(
+        device.getDevice(),
+        &layoutInfo,
+        nullptr,
+        &m_descriptorSetLayout
+    );
+
+    vk::check(res, "Failed to create downsampler descriptor set layout.");
+
+    const char *shader = device.getFeatures().subgroupQuadCompute
+        ? "assets/shaders/spd.comp.spv"
+        : "assets/shaders/spd_shared.comp.spv";
+
+    m_pipeline = Pipeline::Builder(device)
+        .setShader(shader, VK_SHADER_STAGE_COMPUTE_BIT)
+        .addDescriptorSetLayout(m_descriptorSetLayout)
+        .addPushConstantRange({
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .offset = 0,
+            .size = sizeof(PushConstants)
+        })
+        .build();
+
+    m_enabled = true;
+}
+
+void Downsampler::destroy()
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    m_pipeline.destroy();
+
+    vkDestroyDescriptorSetLayout(
+        m_device->getDevice(),
+        m_descriptorSetLayout,
+        nullptr
+    );
+
+    vkDestroyDescriptorPool(
+        m_device->getDevice(),
+        m_descriptorPool,
+        nullptr
+    );
+
+    m_enabled = false;
+}
+
+bool Downsampler::isSupported(VkFormat format, u32 width, u32 height) const
+{
+    if (!m_enabled || std::max(width, height) > MAX_DIMENSION) {
+        return false;
+    }
+
+    if (vk::isBlockCompressed(format)) {
+        return false;
+    }
+
+    // Depth formats have no storage support; depth pyramids use a color
+    // format such as R32_SFLOAT.
+    bool srgb;
+    return m_device->isFormatSupported(
+        getStorageFormat(format, srgb),
+        VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT
+    );
+}
+
+bool Downsampler::isSupported(const Image &image) const
+{
+    return image.getMipLevels() > 1 &&
+        (image.getUsage() & VK_IMAGE_USAGE_STORAGE_BIT) &&
+        isSupported(image.getFormat(), image.getWidth(), image.getHeight());
+}
+
+Downsampler::Target Downsampler::createTarget(Image &image)
+{
+    if (!isSupported(image)) {
+        throw std::runtime_error("Image does not support compute mip generation!");
+    }
+
+    Target target;
+    target.image = &image;
+
+    VkFormat format = getStorageFormat(image.getFormat(), target.srgb);
+    u32 levelCount = std::min(image.getMipLevels(), MAX_LEVELS);
+
+    for (u32 level = 0; level < levelCount; level++) {
+        VkImageViewUsageCreateInfo usageInfo{};
+        usageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO;
+        usageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT;
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.pNext = &usageInfo;
+        viewInfo.image = image.getImage();
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        viewInfo.format = format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = level;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = image.getArrayLayers();
+
+        VkImageView view;
+        VkResult res = vkCreateImageView(
+            m_device->getDevice(),
+            &viewInfo,
+            nullptr,
+            &view
+        );
+
+        vk::check(res, "Failed to create downsampler image view!");
+
+        target.views.push_back(view);
+    }
+
+    target.counters.init(
+        *m_device,
+        sizeof(u32) * image.getArrayLayers(),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+    );
+
+    VkCommandBuffer cmd = m_device->beginSingleTimeCommands();
+    vkCmdFillBuffer(cmd, target.counters.getBuffer(), 0, VK_WHOLE_SIZE, 0);
+    m_device->endSingleTimeCommands(cmd);
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_descriptorSetLayout;
+
+    VkResult res = vkAllocateDescriptorSets(
+        m_device->getDevice(),
+        &allocInfo,
+        &target.descriptorSet
+    );
+
+    vk::check(res, "Failed to allocate downsampler descriptor set.");
+
+    std::vector<VkDescriptorImageInfo> imageInfos(levelCount);
+    for (u32 level = 0; level < levelCount; level++) {
+        imageInfos[level].imageView = target.views[level];
+        imageInfos[level].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    }
+
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = target.counters.getBuffer();
+    bufferInfo.offset = 0;
+    bufferInfo.range = VK_WHOLE_SIZE;
+
+    std::vector<VkWriteDescriptorSet> writes;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = target.descriptorSet;
+    write.dstBinding = LEVELS_BINDING;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    write.descriptorCount = levelCount;
+    write.pImageInfo = imageInfos.data();
+    writes.push_back(write);
+
+    if (levelCount > 6) {
+        write.dstBinding = LEVEL6_BINDING;
+        write.descriptorCount = 1;
+        write.pImageInfo = &imageInfos[6];
+        writes.push_back(write);
+    }
+
+    write.dstBinding = COUNTERS_BINDING;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.descriptorCount = 1;
+    write.pImageInfo = nullptr;
+    write.pBufferInfo = &bufferInfo;
+    writes.push_back(write);
+
+    vkUpdateDescriptorSets(
+        m_device->getDevice(),
+        static_cast<u32>(writes.size()),
+        writes.data(),
+        0,
+        nullptr
+    );
+
+    return target;
+}
+
+void Downsampler::destroyTarget(Target &target)
+{
+    vkFreeDescriptorSets(
+        m_device->getDevice(),
+        m_descriptorPool,
+        1,
+        &target.descriptorSet
+    );
+
+    for (VkImageView view : target.views) {
+        vkDestroyImageView(m_device->getDevice(), view, nullptr);
+    }
+
+    target.counters.destroy();
+    target.views.clear();
+    target.descriptorSet = VK_NULL_HANDLE;
+    target.image = nullptr;
+}
+
+void Downsampler::dispatch(
+    VkCommandBuffer cmd,
+    Target &target,
+    Reduction reduction,
+    VkImageLayout finalLayout,
+    VkPipelineStageFlags2 dstStage
+)
+{
+    Image &image = *target.image;
+
+    u32 groupCountX = (image.getWidth() + TILE_SIZE - 1) / TILE_SIZE;
+    u32 groupCountY = (image.getHeight() + TILE_SIZE - 1) / TILE_SIZE;
+
+    // Covers whatever wrote level 0 and the counter reset of the previous
+    // dispatch on this target.
+    VkMemoryBarrier2 counterBarrier{};
+    counterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    counterBarrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    counterBarrier.srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
+    counterBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    counterBarrier.dstAccessMask =
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+
+    VkImageMemoryBarrier2 imageBarrier{};
+    imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    imageBarrier.srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
+    imageBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    imageBarrier.dstAccessMask =
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    imageBarrier.oldLayout = image.getLayout();
+    imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image = image.getImage();
+    imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    imageBarrier.subresourceRange.baseMipLevel = 0;
+    imageBarrier.subresourceRange.levelCount = static_cast<u32>(target.views.size());
+    imageBarrier.subresourceRange.baseArrayLayer = 0;
+    imageBarrier.subresourceRange.layerCount = image.getArrayLayers();
+
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.memoryBarrierCount = 1;
+    dependencyInfo.pMemoryBarriers = &counterBarrier;
+    dependencyInfo.imageMemoryBarrierCount = 1;
+    dependencyInfo.pImageMemoryBarriers = &imageBarrier;
+
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+
+    PushConstants pc = {
+        static_cast<u32>(target.views.size()) - 1,
+        groupCountX * groupCountY,
+        static_cast<u32>(reduction),
+        target.srgb ? 1u : 0u
+    };
+
+    m_pipeline.bind(cmd);
+    m_pipeline.bindDescriptorSet(cmd, target.descriptorSet, 1);
+    m_pipeline.push(cmd, VK_SHADER_STAGE_COMPUTE_BIT, sizeof(pc), &pc);
+
+    vkCmdDispatch(cmd, groupCountX, groupCountY, image.getArrayLayers());
+
+    imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    imageBarrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    imageBarrier.dstStageMask = dstStage;
+    imageBarrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+    imageBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    imageBarrier.newLayout = finalLayout;
+
+    dependencyInfo.memoryBarrierCount = 0;
+    dependencyInfo.pMemoryBarriers = nullptr;
+
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+
+    image.m_layout = finalLayout;
+}
+
+void Downsampler::generate(Image &image, Reduction reduction)
+{
+    Target target = createTarget(image);
+
+    VkCommandBuffer cmd = m_device->beginSingleTimeCommands();
+    dispatch(cmd, target, reduction);
+    m_device->endSingleTimeCommands(cmd);
+
+    destroyTarget(target);
+}
+
+} // namespace gfx
\ No newline at end of file
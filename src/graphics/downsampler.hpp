@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include "core/types.hpp"
+#include "buffer.hpp"
+#include "pipeline.hpp"
+
+namespace gfx
+{
+
+class Device;
+class Image;
+
+// Compute mip generation in a single dispatch (spd.comp). Writes every
+// level below level 0 with one barrier before and one after, regardless of
+// the image size.
+class Downsampler
+{
+
+public:
+    enum class Reduction : u32
+    {
+        Average,
+        Min,    // Depth pyramids with a standard depth range
+        Max     // Depth pyramids with reversed depth
+    };
+
+    // Storage views of every level, the descriptor set and the workgroup
+    // counters of one image. Created once and reused for per-frame targets.
+    struct Target
+    {
+        Image *image = nullptr;
+        std::vector<VkImageView> views;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        Buffer counters;
+        bool srgb = false;
+    };
+
+    Downsampler() = default;
+    ~Downsampler() = default;
+
+    void init(Device &device);
+    void destroy();
+
+    // Color formats with storage support, up to MAX_DIMENSION texels on a
+    // side. sRGB images are written through a UNORM view.
+    bool isSupported(VkFormat format, u32 width, u32 height) const;
+
+    // Also requires the image to have storage usage and more than one level.
+    bool isSupported(const Image &image) const;
+
+    Target createTarget(Image &image);
+    void destroyTarget(Target &target);
+
+    // Moves the image from its current layout to `finalLayout`, with the
+    // levels visible to `dstStage`. Level 0 must already hold the source.
+    void dispatch(
+        VkCommandBuffer cmd,
+        Target &target,
+        Reduction reduction = Reduction::Average,
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VkPipelineStageFlags2 dstStage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT
+    );
+
+    // One-off generation in a single time command buffer, for uploads.
+    void generate(Image &image, Reduction reduction = Reduction::Average);
+
+public:
+    static constexpr u32 MAX_LEVELS = 13;
+    static constexpr u32 MAX_DIMENSION = 1 << (MAX_LEVELS - 1);
+
+private:
+    struct PushConstants
+    {
+        u32 levelCount;
+        u32 workGroupCount;
+        u32 reduction;
+        u32 srgb;
+    };
+
+    Device *m_device = nullptr;
+
+    Pipeline m_pipeline;
+    bool m_enabled = false;
+
+    VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
+
+    static constexpr u32 MAX_TARGETS = 64;
+    static constexpr u32 TILE_SIZE = 64;
+
+};
+
+} // namespace gfx
\ No newline at end of file
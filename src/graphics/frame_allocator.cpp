@@ -0,0 +1,77 @@
+#include "frame_allocator.hpp"
+#include "device.hpp"
+
+namespace gfx
+{
+
+void FrameAllocator::init(Device &device, VkDeviceSize capacityPerFrame)
+{
+    m_device = &device;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
+
+    // Partitions start where a storage buffer descriptor may.
+    VkDeviceSize alignment = properties.limits.minStorageBufferOffsetAlignment;
+    m_capacity = (capacityPerFrame + alignment - 1) / alignment * alignment;
+
+    m_buffer.init(
+        device,
+        m_capacity * MAX_FRAMES_IN_FLIGHT,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+        VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_AUTO,
+        Buffer::HostAccess::SequentialWrite
+    );
+
+    m_data = static_cast<u8 *>(m_buffer.map());
+
+    for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        m_handles[i] = device.getBindlessManager().addSSBO(
+            m_buffer,
+            i * m_capacity,
+            m_capacity
+        );
+    }
+}
+
+void FrameAllocator::destroy()
+{
+    for (u32 handle : m_handles) {
+        m_device->getBindlessManager().removeResource(handle);
+    }
+
+    m_buffer.destroy();
+    m_data = nullptr;
+}
+
+void FrameAllocator::reset(u32 frameIndex)
+{
+    m_frameIndex = frameIndex;
+    m_offset = 0;
+}
+
+void FrameAllocator::flush()
+{
+    if (m_offset == 0) {
+        return;
+    }
+
+    m_buffer.flush(m_frameIndex * m_capacity, m_offset);
+}
+
+VkDeviceSize FrameAllocator::allocateBytes(VkDeviceSize size, VkDeviceSize stride)
+{
+    VkDeviceSize offset = (m_offset + stride - 1) / stride * stride;
+    if (offset + size > m_capacity) {
+        throw std::runtime_error("Frame allocator is out of memory.");
+    }
+
+    m_offset = offset + size;
+    return offset;
+}
+
+} // namespace gfx
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+
+#include "core/types.hpp"
+#include "buffer.hpp"
+#include "global.hpp"
+
+namespace gfx
+{
+
+class Device;
+
+// Transient data written by the CPU once per frame.
+template<typename T>
+struct FrameAllocation
+{
+    T *data = nullptr;
+
+    // Byte offset in getBuffer(), for vertex, index or indirect bindings.
+    VkDeviceSize offset = 0;
+
+    // Device address of data[0], for buffer_reference pointers.
+    VkDeviceAddress address = 0;
+
+    // SSBO handle of the frame's partition and the element index of
+    // data[0] in it when the partition is read as an array of T.
+    u32 handle = ~0u;
+    u32 index = 0;
+};
+
+// One persistently mapped host visible buffer, split in a partition per
+// frame in flight. Allocation bumps an offset in the current partition,
+// which is rewound by reset() once the frame that last used it finished.
+class FrameAllocator
+{
+
+public:
+    FrameAllocator() = default;
+    ~FrameAllocator() = default;
+
+    void init(Device &device, VkDeviceSize capacityPerFrame = 4ull << 20);
+    void destroy();
+
+    // Called by Device::beginFrame after waiting for the frame's
+    // previous submit.
+    void reset(u32 frameIndex);
+
+    // Makes the writes of the current frame visible; called by
+    // Device::endFrame before submission.
+    void flush();
+
+    // Throws when the partition is full. The memory is uninitialized.
+    template<typename T>
+    FrameAllocation<T> allocate(u32 count = 1);
+
+public:
+    VkBuffer getBuffer() const { return m_buffer.getBuffer(); }
+    u32 getHandle() const { return m_handles[m_frameIndex]; }
+
+    VkDeviceSize getCapacity() const { return m_capacity; }
+    VkDeviceSize getUsedBytes() const { return m_offset; }
+
+private:
+    Device *m_device = nullptr;
+
+    Buffer m_buffer;
+    u8 *m_data = nullptr;
+
+    VkDeviceSize m_capacity = 0;
+    std::array<u32, MAX_FRAMES_IN_FLIGHT> m_handles{};
+
+    u32 m_frameIndex = 0;
+    VkDeviceSize m_offset = 0;
+
+    // Offset in the current partition, a multiple of `stride`.
+    VkDeviceSize allocateBytes(VkDeviceSize size, VkDeviceSize stride);
+
+};
+
+template<typename T>
+FrameAllocation<T> FrameAllocator::allocate(u32 count)
+{
+    VkDeviceSize offset = allocateBytes(sizeof(T) * count, sizeof(T));
+    VkDeviceSize base = m_frameIndex * m_capacity;
+
+    FrameAllocation<T> allocation;
+    allocation.data = reinterpret_cast<T *>(m_data + base + offset);
+    allocation.offset = base + offset;
+    allocation.address = m_buffer.getDeviceAddress() + base + offset;
+    allocation.handle = m_handles[m_frameIndex];
+    allocation.index = static_cast<u32>(offset / sizeof(T));
+
+    return allocation;
+}
+
+} // namespace gfx
\ No newline at end of file
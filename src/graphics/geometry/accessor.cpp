@@ -0,0 +1,739 @@
+#include "accessor.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    #include <immintrin.h>
+    #define GEOMETRY_SSE2 1
+    #if defined(__GNUC__) || defined(__clang__)
+        #define GEOMETRY_AVX2 1
+        #define GEOMETRY_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+namespace gfx::geometry
+{
+
+namespace
+{
+
+constexpr usize CHUNK_SIZE = 1024;
+constexpr u32 MAX_COMPONENTS = 4;
+
+f32 getScale(ComponentType type, bool normalized)
+{
+    if (!normalized) {
+        return 1.0f;
+    }
+
+    switch (type) {
+        case ComponentType::I8:  return 1.0f / 127.0f;
+        case ComponentType::U8:  return 1.0f / 255.0f;
+        case ComponentType::I16: return 1.0f / 32767.0f;
+        case ComponentType::U16: return 1.0f / 65535.0f;
+        default:                 return 1.0f;
+    }
+}
+
+bool isSigned(ComponentType type)
+{
+    return type == ComponentType::I8 || type == ComponentType::I16;
+}
+
+void gather(
+    const u8 *src,
+    usize srcStride,
+    usize elementSize,
+    usize count,
+    u8 *dst
+)
+{
+    if (srcStride == elementSize) {
+        memcpy(dst, src, count * elementSize);
+        return;
+    }
+
+    for (usize i = 0; i < count; i++) {
+        memcpy(dst + i * elementSize, src + i * srcStride, elementSize);
+    }
+}
+
+template<u32 N>
+void copyStridedN(
+    const u8 *src,
+    usize srcStride,
+    usize count,
+    u8 *dst,
+    usize dstStride
+)
+{
+    for (usize i = 0; i < count; i++) {
+        memcpy(dst + i * dstStride, src + i * srcStride, N * sizeof(f32));
+    }
+}
+
+void copyStrided(
+    const u8 *src,
+    usize srcStride,
+    usize count,
+    u32 components,
+    u8 *dst,
+    usize dstStride
+)
+{
+    switch (components) {
+        case 1: copyStridedN<1>(src, srcStride, count, dst, dstStride); break;
+        case 2: copyStridedN<2>(src, srcStride, count, dst, dstStride); break;
+        case 3: copyStridedN<3>(src, srcStride, count, dst, dstStride); break;
+        case 4: copyStridedN<4>(src, srcStride, count, dst, dstStride); break;
+    }
+}
+
+template<typename T>
+void convertScalarTyped(const T *src, usize n, f32 scale, bool clamp, f32 *dst)
+{
+    for (usize i = 0; i < n; i++) {
+        f32 value = static_cast<f32>(src[i]) * scale;
+        dst[i] = clamp ? std::max(value, -1.0f) : value;
+    }
+}
+
+void convertScalar(
+    const void *src,
+    ComponentType type,
+    bool normalized,
+    usize n,
+    f32 *dst
+)
+{
+    f32 scale = getScale(type, normalized);
+    bool clamp = normalized && isSigned(type);
+
+    switch (type) {
+        case ComponentType::I8:
+            convertScalarTyped(static_cast<const i8 *>(src), n, scale, clamp, dst);
+            break;
+        case ComponentType::U8:
+            convertScalarTyped(static_cast<const u8 *>(src), n, scale, clamp, dst);
+            break;
+        case ComponentType::I16:
+            convertScalarTyped(static_cast<const i16 *>(src), n, scale, clamp, dst);
+            break;
+        case ComponentType::U16:
+            convertScalarTyped(static_cast<const u16 *>(src), n, scale, clamp, dst);
+            break;
+        case ComponentType::U32:
+            convertScalarTyped(static_cast<const u32 *>(src), n, scale, clamp, dst);
+            break;
+        case ComponentType::F32:
+            memcpy(dst, src, n * sizeof(f32));
+            break;
+    }
+}
+
+template<typename T>
+void widenScalar(const T *src, usize n, u32 *dst)
+{
+    for (usize i = 0; i < n; i++) {
+        dst[i] = static_cast<u32>(src[i]);
+    }
+}
+
+#ifdef GEOMETRY_SSE2
+
+inline void storeSSE2(__m128i v, __m128 scale, bool clamp, f32 *dst)
+{
+    __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(v), scale);
+    if (clamp) {
+        f = _mm_max_ps(f, _mm_set1_ps(-1.0f));
+    }
+    _mm_storeu_ps(dst, f);
+}
+
+usize convertSSE2(
+    const void *src,
+    ComponentType type,
+    bool normalized,
+    usize n,
+    f32 *dst
+)
+{
+    const __m128 scale = _mm_set1_ps(getScale(type, normalized));
+    const __m128i zero = _mm_setzero_si128();
+    const bool clamp = normalized && isSigned(type);
+
+    usize i = 0;
+
+    auto store = [&](__m128i v, usize offset) {
+        storeSSE2(v, scale, clamp, dst + offset);
+    };
+
+    switch (type) {
+        case ComponentType::U8:
+        case ComponentType::I8: {
+            const u8 *s = static_cast<const u8 *>(src);
+            for (; i + 16 <= n; i += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+                __m128i lo16, hi16;
+                if (type == ComponentType::I8) {
+                    lo16 = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+                    hi16 = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+                    store(_mm_srai_epi32(_mm_unpacklo_epi16(lo16, lo16), 16), i);
+                    store(_mm_srai_epi32(_mm_unpackhi_epi16(lo16, lo16), 16), i + 4);
+                    store(_mm_srai_epi32(_mm_unpacklo_epi16(hi16, hi16), 16), i + 8);
+                    store(_mm_srai_epi32(_mm_unpackhi_epi16(hi16, hi16), 16), i + 12);
+                } else {
+                    lo16 = _mm_unpacklo_epi8(v, zero);
+                    hi16 = _mm_unpackhi_epi8(v, zero);
+                    store(_mm_unpacklo_epi16(lo16, zero), i);
+                    store(_mm_unpackhi_epi16(lo16, zero), i + 4);
+                    store(_mm_unpacklo_epi16(hi16, zero), i + 8);
+                    store(_mm_unpackhi_epi16(hi16, zero), i + 12);
+                }
+            }
+            break;
+        }
+        case ComponentType::U16:
+        case ComponentType::I16: {
+            const u16 *s = static_cast<const u16 *>(src);
+            for (; i + 8 <= n; i += 8) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+                if (type == ComponentType::I16) {
+                    store(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), i);
+                    store(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16), i + 4);
+                } else {
+                    store(_mm_unpacklo_epi16(v, zero), i);
+                    store(_mm_unpackhi_epi16(v, zero), i + 4);
+                }
+            }
+            break;
+        }
+        case ComponentType::F32: {
+            const f32 *s = static_cast<const f32 *>(src);
+            for (; i + 4 <= n; i += 4) {
+                _mm_storeu_ps(dst + i, _mm_loadu_ps(s + i));
+            }
+            break;
+        }
+        case ComponentType::U32:
+            break;
+    }
+
+    return i;
+}
+
+usize widenSSE2(const void *src, ComponentType type, usize n, u32 *dst)
+{
+    const __m128i zero = _mm_setzero_si128();
+    usize i = 0;
+
+    if (type == ComponentType::U16) {
+        const u16 *s = static_cast<const u16 *>(src);
+        for (; i + 8 <= n; i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i *>(dst + i),
+                _mm_unpacklo_epi16(v, zero)
+            );
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i *>(dst + i + 4),
+                _mm_unpackhi_epi16(v, zero)
+            );
+        }
+    } else if (type == ComponentType::U8) {
+        const u8 *s = static_cast<const u8 *>(src);
+        for (; i + 16 <= n; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+            __m128i lo = _mm_unpacklo_epi8(v, zero);
+            __m128i hi = _mm_unpackhi_epi8(v, zero);
+            __m128i *d = reinterpret_cast<__m128i *>(dst + i);
+            _mm_storeu_si128(d + 0, _mm_unpacklo_epi16(lo, zero));
+            _mm_storeu_si128(d + 1, _mm_unpackhi_epi16(lo, zero));
+            _mm_storeu_si128(d + 2, _mm_unpacklo_epi16(hi, zero));
+            _mm_storeu_si128(d + 3, _mm_unpackhi_epi16(hi, zero));
+        }
+    }
+
+    return i;
+}
+
+#endif
+
+#ifdef GEOMETRY_AVX2
+
+GEOMETRY_TARGET_AVX2
+inline void storeAVX2(__m256i v, __m256 scale, bool clamp, f32 *dst)
+{
+    __m256 f = _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale);
+    if (clamp) {
+        f = _mm256_max_ps(f, _mm256_set1_ps(-1.0f));
+    }
+    _mm256_storeu_ps(dst, f);
+}
+
+GEOMETRY_TARGET_AVX2
+usize convertAVX2(
+    const void *src,
+    ComponentType type,
+    bool normalized,
+    usize n,
+    f32 *dst
+)
+{
+    const __m256 scale = _mm256_set1_ps(getScale(type, normalized));
+    const bool clamp = normalized && isSigned(type);
+
+    usize i = 0;
+
+    switch (type) {
+        case ComponentType::U8: {
+            const u8 *s = static_cast<const u8 *>(src);
+            for (; i + 8 <= n; i += 8) {
+                __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(s + i));
+                storeAVX2(_mm256_cvtepu8_epi32(v), scale, clamp, dst + i);
+            }
+            break;
+        }
+        case ComponentType::I8: {
+            const u8 *s = static_cast<const u8 *>(src);
+            for (; i + 8 <= n; i += 8) {
+                __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(s + i));
+                storeAVX2(_mm256_cvtepi8_epi32(v), scale, clamp, dst + i);
+            }
+            break;
+        }
+        case ComponentType::U16: {
+            const u16 *s = static_cast<const u16 *>(src);
+            for (; i + 8 <= n; i += 8) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+                storeAVX2(_mm256_cvtepu16_epi32(v), scale, clamp, dst + i);
+            }
+            break;
+        }
+        case ComponentType::I16: {
+            const u16 *s = static_cast<const u16 *>(src);
+            for (; i + 8 <= n; i += 8) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+                storeAVX2(_mm256_cvtepi16_epi32(v), scale, clamp, dst + i);
+            }
+            break;
+        }
+        case ComponentType::F32: {
+            const f32 *s = static_cast<const f32 *>(src);
+            for (; i + 8 <= n; i += 8) {
+                _mm256_storeu_ps(dst + i, _mm256_loadu_ps(s + i));
+            }
+            break;
+        }
+        case ComponentType::U32:
+            break;
+    }
+
+    return i;
+}
+
+template<bool IsByte, bool IsSigned, u32 N>
+GEOMETRY_TARGET_AVX2
+void convertStridedAVX2Typed(
+    const u8 *src,
+    usize srcStride,
+    usize count,
+    __m128 scale,
+    bool clamp,
+    u8 *dst,
+    usize dstStride
+)
+{
+    for (usize i = 0; i < count; i++) {
+        const u8 *s = src + i * srcStride;
+
+        __m128i v;
+        if constexpr (IsByte) {
+            i32 raw;
+            memcpy(&raw, s, sizeof(raw));
+            v = _mm_cvtsi32_si128(raw);
+            v = IsSigned ? _mm_cvtepi8_epi32(v) : _mm_cvtepu8_epi32(v);
+        } else {
+            v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(s));
+            v = IsSigned ? _mm_cvtepi16_epi32(v) : _mm_cvtepu16_epi32(v);
+        }
+
+        __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(v), scale);
+        if (clamp) {
+            f = _mm_max_ps(f, _mm_set1_ps(-1.0f));
+        }
+
+        f32 *d = reinterpret_cast<f32 *>(dst + i * dstStride);
+        if constexpr (N == 4) {
+            _mm_storeu_ps(d, f);
+        } else {
+            _mm_store_sd(reinterpret_cast<f64 *>(d), _mm_castps_pd(f));
+            if constexpr (N == 3) {
+                _mm_store_ss(d + 2, _mm_movehl_ps(f, f));
+            }
+        }
+    }
+}
+
+template<bool IsByte, bool IsSigned>
+GEOMETRY_TARGET_AVX2
+void convertStridedAVX2Components(
+    const u8 *src,
+    usize srcStride,
+    usize count,
+    u32 components,
+    __m128 scale,
+    bool clamp,
+    u8 *dst,
+    usize dstStride
+)
+{
+    switch (components) {
+        case 2:
+            convertStridedAVX2Typed<IsByte, IsSigned, 2>(
+                src, srcStride, count, scale, clamp, dst, dstStride
+            );
+            break;
+        case 3:
+            convertStridedAVX2Typed<IsByte, IsSigned, 3>(
+                src, srcStride, count, scale, clamp, dst, dstStride
+            );
+            break;
+        case 4:
+            convertStridedAVX2Typed<IsByte, IsSigned, 4>(
+                src, srcStride, count, scale, clamp, dst, dstStride
+            );
+            break;
+    }
+}
+
+// Converts one 2-4 component 8/16-bit element per iteration straight into
+// the destination. Each load may read past the element, so the last
+// element is always left to the caller.
+GEOMETRY_TARGET_AVX2
+usize convertStridedAVX2(
+    const AccessorView &view,
+    usize stride,
+    u32 components,
+    u8 *dst,
+    usize dstStride
+)
+{
+    const usize componentSize = getComponentSize(view.componentType);
+    const usize elementSize = componentSize * view.components;
+    const usize loadSize = componentSize == 1 ? 4 : 8;
+
+    if (
+        view.count < 2 ||
+        componentSize > 2 ||
+        view.components < 2 ||
+        view.components > MAX_COMPONENTS ||
+        view.components != components ||
+        stride + elementSize < loadSize
+    ) {
+        return 0;
+    }
+
+    const __m128 scale = _mm_set1_ps(getScale(view.componentType, view.normalized));
+    const bool clamp = view.normalized && isSigned(view.componentType);
+    const usize count = view.count - 1;
+
+    switch (view.componentType) {
+        case ComponentType::U8:
+            convertStridedAVX2Components<true, false>(
+                view.data, stride, count, components, scale, clamp, dst, dstStride
+            );
+            break;
+        case ComponentType::I8:
+            convertStridedAVX2Components<true, true>(
+                view.data, stride, count, components, scale, clamp, dst, dstStride
+            );
+            break;
+        case ComponentType::U16:
+            convertStridedAVX2Components<false, false>(
+                view.data, stride, count, components, scale, clamp, dst, dstStride
+            );
+            break;
+        case ComponentType::I16:
+            convertStridedAVX2Components<false, true>(
+                view.data, stride, count, components, scale, clamp, dst, dstStride
+            );
+            break;
+        default:
+            return 0;
+    }
+
+    return count;
+}
+
+GEOMETRY_TARGET_AVX2
+usize widenAVX2(const void *src, ComponentType type, usize n, u32 *dst)
+{
+    usize i = 0;
+
+    if (type == ComponentType::U16) {
+        const u16 *s = static_cast<const u16 *>(src);
+        for (; i + 8 <= n; i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+            _mm256_storeu_si256(
+                reinterpret_cast<__m256i *>(dst + i),
+                _mm256_cvtepu16_epi32(v)
+            );
+        }
+    } else if (type == ComponentType::U8) {
+        const u8 *s = static_cast<const u8 *>(src);
+        for (; i + 8 <= n; i += 8) {
+            __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(s + i));
+            _mm256_storeu_si256(
+                reinterpret_cast<__m256i *>(dst + i),
+                _mm256_cvtepu8_epi32(v)
+            );
+        }
+    }
+
+    return i;
+}
+
+#endif
+
+void convert(
+    const void *src,
+    ComponentType type,
+    bool normalized,
+    usize n,
+    f32 *dst
+)
+{
+    usize done = 0;
+
+#if defined(GEOMETRY_AVX2)
+    if (hasAVX2()) {
+        done = convertAVX2(src, type, normalized, n, dst);
+    } else {
+        done = convertSSE2(src, type, normalized, n, dst);
+    }
+#elif defined(GEOMETRY_SSE2)
+    done = convertSSE2(src, type, normalized, n, dst);
+#endif
+
+    if (done < n) {
+        const u8 *tail = static_cast<const u8 *>(src) + done * getComponentSize(type);
+        convertScalar(tail, type, normalized, n - done, dst + done);
+    }
+}
+
+void widen(const void *src, ComponentType type, usize n, u32 *dst)
+{
+    usize done = 0;
+
+#if defined(GEOMETRY_AVX2)
+    if (hasAVX2()) {
+        done = widenAVX2(src, type, n, dst);
+    } else {
+        done = widenSSE2(src, type, n, dst);
+    }
+#elif defined(GEOMETRY_SSE2)
+    done = widenSSE2(src, type, n, dst);
+#endif
+
+    switch (type) {
+        case ComponentType::U8:
+            widenScalar(static_cast<const u8 *>(src) + done, n - done, dst + done);
+            break;
+        case ComponentType::U16:
+            widenScalar(static_cast<const u16 *>(src) + done, n - done, dst + done);
+            break;
+        case ComponentType::U32:
+            memcpy(dst, src, n * sizeof(u32));
+            break;
+        default:
+            throw std::runtime_error("Unsupported index component type.");
+    }
+}
+
+} // namespace
+
+usize getComponentSize(ComponentType type)
+{
+    switch (type) {
+        case ComponentType::I8:
+        case ComponentType::U8:
+            return 1;
+        case ComponentType::I16:
+        case ComponentType::U16:
+            return 2;
+        case ComponentType::U32:
+        case ComponentType::F32:
+            return 4;
+    }
+
+    return 0;
+}
+
+bool hasAVX2()
+{
+#if defined(GEOMETRY_AVX2)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+void readFloats(
+    const AccessorView &view,
+    u32 components,
+    void *dst,
+    usize dstStride
+)
+{
+    if (components == 0 || components > MAX_COMPONENTS) {
+        throw std::invalid_argument("Invalid accessor component count.");
+    }
+
+    u8 *out = static_cast<u8 *>(dst);
+
+    if (!view.data) {
+        for (usize i = 0; i < view.count; i++) {
+            memset(out + i * dstStride, 0, components * sizeof(f32));
+        }
+        return;
+    }
+
+    const usize elementSize = getComponentSize(view.componentType) * view.components;
+    const usize stride = view.stride ? view.stride : elementSize;
+    const u32 srcComponents = std::min(view.components, MAX_COMPONENTS);
+    const usize packedSize = getComponentSize(view.componentType) * srcComponents;
+
+    if (view.componentType == ComponentType::F32 && srcComponents == components) {
+        copyStrided(view.data, stride, view.count, components, out, dstStride);
+        return;
+    }
+
+    usize done = 0;
+
+#ifdef GEOMETRY_AVX2
+    if (hasAVX2()) {
+        done = convertStridedAVX2(view, stride, components, out, dstStride);
+    }
+#endif
+
+    alignas(32) u8 packed[CHUNK_SIZE * MAX_COMPONENTS * sizeof(f32)];
+    alignas(32) f32 floats[CHUNK_SIZE * MAX_COMPONENTS];
+
+    for (usize base = done; base < view.count; base += CHUNK_SIZE) {
+        usize n = std::min(CHUNK_SIZE, view.count - base);
+        const u8 *src = view.data + base * stride;
+
+        const void *contiguous = src;
+        if (stride != packedSize) {
+            gather(src, stride, packedSize, n, packed);
+            contiguous = packed;
+        }
+
+        convert(
+            contiguous,
+            view.componentType,
+            view.normalized,
+            n * srcComponents,
+            floats
+        );
+
+        u8 *chunkDst = out + base * dstStride;
+
+        if (srcComponents == components) {
+            interleave(floats, n, components, chunkDst, dstStride);
+            continue;
+        }
+
+        for (usize i = 0; i < n; i++) {
+            f32 *d = reinterpret_cast<f32 *>(chunkDst + i * dstStride);
+            for (u32 c = 0; c < components; c++) {
+                d[c] = c < srcComponents ? floats[i * srcComponents + c] : 0.0f;
+            }
+        }
+    }
+}
+
+void readIndices(const AccessorView &view, u32 *dst)
+{
+    if (view.componentType != ComponentType::U8 &&
+        view.componentType != ComponentType::U16 &&
+        view.componentType != ComponentType::U32
+    ) {
+        throw std::runtime_error("Unsupported index component type.");
+    }
+
+    if (!view.data) {
+        memset(dst, 0, view.count * sizeof(u32));
+        return;
+    }
+
+    const usize elementSize = getComponentSize(view.componentType);
+    const usize stride = view.stride ? view.stride : elementSize;
+
+    if (stride == elementSize) {
+        widen(view.data, view.componentType, view.count, dst);
+        return;
+    }
+
+    alignas(32) u8 packed[CHUNK_SIZE * sizeof(u32)];
+
+    for (usize base = 0; base < view.count; base += CHUNK_SIZE) {
+        usize n = std::min(CHUNK_SIZE, view.count - base);
+        gather(view.data + base * stride, stride, elementSize, n, packed);
+        widen(packed, view.componentType, n, dst + base);
+    }
+}
+
+void interleave(
+    const f32 *src,
+    usize count,
+    u32 components,
+    void *dst,
+    usize dstStride
+)
+{
+    u8 *out = static_cast<u8 *>(dst);
+
+    if (dstStride == components * sizeof(f32)) {
+        memcpy(out, src, count * dstStride);
+        return;
+    }
+
+    switch (components) {
+        case 1:
+            for (usize i = 0; i < count; i++) {
+                memcpy(out + i * dstStride, src + i, sizeof(f32));
+            }
+            break;
+        case 2:
+            for (usize i = 0; i < count; i++) {
+                memcpy(out + i * dstStride, src + i * 2, 2 * sizeof(f32));
+            }
+            break;
+        case 3:
+            for (usize i = 0; i < count; i++) {
+                memcpy(out + i * dstStride, src + i * 3, 3 * sizeof(f32));
+            }
+            break;
+        case 4:
+            for (usize i = 0; i < count; i++) {
+#ifdef GEOMETRY_SSE2
+                _mm_storeu_ps(
+                    reinterpret_cast<f32 *>(out + i * dstStride),
+                    _mm_loadu_ps(src + i * 4)
+                );
+#else
+                memcpy(out + i * dstStride, src + i * 4, 4 * sizeof(f32));
+#endif
+            }
+            break;
+        default:
+            throw std::invalid_argument("Invalid accessor component count.");
+    }
+}
+
+} // namespace gfx::geometry
\ No newline at end of file
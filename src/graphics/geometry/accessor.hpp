@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+
+#include "core/types.hpp"
+
+namespace gfx::geometry
+{
+
+enum class ComponentType
+{
+    I8,
+    U8,
+    I16,
+    U16,
+    U32,
+    F32
+};
+
+// Raw view over a (possibly strided) vertex attribute or index stream.
+// A null data pointer describes an all-zero accessor.
+struct AccessorView
+{
+    const u8 *data = nullptr;
+    usize count = 0;
+    usize stride = 0;
+    u32 components = 1;
+    ComponentType componentType = ComponentType::F32;
+    bool normalized = false;
+};
+
+usize getComponentSize(ComponentType type);
+
+// Converts every element of the view to `components` floats written at
+// `dst + i * dstStride`. Missing components are filled with zero.
+void readFloats(
+    const AccessorView &view,
+    u32 components,
+    void *dst,
+    usize dstStride
+);
+
+// Widens U8/U16/U32 indices to a tightly packed u32 array.
+void readIndices(const AccessorView &view, u32 *dst);
+
+// Scatters tightly packed float tuples into a strided destination.
+void interleave(
+    const f32 *src,
+    usize count,
+    u32 components,
+    void *dst,
+    usize dstStride
+);
+
+bool hasAVX2();
+
+} // namespace gfx::geometry
\ No newline at end of file
@@ -0,0 +1,339 @@
+#include "meshlet.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace gfx::geometry
+{
+
+namespace
+{
+
+constexpr u8 NO_LOCAL_INDEX = 0xFF;
+constexpr f32 DISABLED_CONE_CUTOFF = 2.0f;
+
+const f32 *getPosition(const f32 *positions, usize stride, u32 index)
+{
+    const u8 *data = reinterpret_cast<const u8 *>(positions);
+    return reinterpret_cast<const f32 *>(data + index * stride);
+}
+
+} // namespace
+
+MeshletData buildMeshlets(
+    const u32 *indices,
+    usize indexCount,
+    const f32 *positions,
+    usize positionStride,
+    usize vertexCount,
+    u32 maxVertices,
+    u32 maxTriangles
+)
+{
+    if (indexCount % 3 != 0) {
+        throw std::invalid_argument("Index count must be a multiple of 3.");
+    }
+
+    if (maxVertices < 3 || maxVertices >= NO_LOCAL_INDEX || maxTriangles == 0) {
+        throw std::invalid_argument("Invalid meshlet limits.");
+    }
+
+    usize triangleCount = indexCount / 3;
+
+    std::vector<u32> adjacencyOffsets(vertexCount + 1, 0);
+    for (usize i = 0; i < indexCount; i++) {
+        if (indices[i] >= vertexCount) {
+            throw std::out_of_range("Index references a missing vertex.");
+        }
+        adjacencyOffsets[indices[i] + 1]++;
+    }
+
+    std::vector<u32> liveTriangles(vertexCount);
+    for (usize v = 0; v < vertexCount; v++) {
+        liveTriangles[v] = adjacencyOffsets[v + 1];
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    }
+
+    std::vector<u32> adjacency(indexCount);
+    std::vector<u32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (usize i = 0; i < indexCount; i++) {
+        adjacency[fill[indices[i]]++] = static_cast<u32>(i / 3);
+    }
+
+    std::vector<f32> centroids(triangleCount * 3);
+    for (usize t = 0; t < triangleCount; t++) {
+        for (u32 c = 0; c < 3; c++) {
+            f32 sum = 0.0f;
+            for (u32 k = 0; k < 3; k++) {
+                sum += getPosition(positions, positionStride, indices[t * 3 + k])[c];
+            }
+            centroids[t * 3 + c] = sum / 3.0f;
+        }
+    }
+
+    MeshletData data;
+    data.meshlets.reserve(triangleCount / maxTriangles + 1);
+    data.vertices.reserve(indexCount / 2);
+    data.triangles.reserve(indexCount);
+
+    std::vector<u8> localIndices(vertexCount, NO_LOCAL_INDEX);
+    std::vector<u8> emitted(triangleCount, 0);
+
+    Meshlet current;
+    f32 centerSum[3] = { 0.0f, 0.0f, 0.0f };
+
+    auto countNewVertices = [&](u32 triangle) {
+        u32 count = 0;
+        for (u32 k = 0; k < 3; k++) {
+            count += localIndices[indices[triangle * 3 + k]] == NO_LOCAL_INDEX;
+        }
+        return count;
+    };
+
+    auto fits = [&](u32 newVertices) {
+        return current.vertexCount + newVertices <= maxVertices &&
+            current.triangleCount + 1 <= maxTriangles;
+    };
+
+    auto flush = [&]() {
+        if (current.triangleCount == 0) {
+            return;
+        }
+
+        for (u32 i = 0; i < current.vertexCount; i++) {
+            localIndices[data.vertices[current.vertexOffset + i]] = NO_LOCAL_INDEX;
+        }
+
+        data.meshlets.push_back(current);
+
+        current = {};
+        current.vertexOffset = static_cast<u32>(data.vertices.size());
+        current.triangleOffset = static_cast<u32>(data.triangles.size() / 3);
+        centerSum[0] = centerSum[1] = centerSum[2] = 0.0f;
+    };
+
+    auto append = [&](u32 triangle) {
+        for (u32 k = 0; k < 3; k++) {
+            u32 vertex = indices[triangle * 3 + k];
+            if (localIndices[vertex] == NO_LOCAL_INDEX) {
+                localIndices[vertex] = static_cast<u8>(current.vertexCount++);
+                data.vertices.push_back(vertex);
+            }
+
+            data.triangles.push_back(localIndices[vertex]);
+            liveTriangles[vertex]--;
+        }
+
+        for (u32 c = 0; c < 3; c++) {
+            centerSum[c] += centroids[triangle * 3 + c];
+        }
+
+        emitted[triangle] = 1;
+        current.triangleCount++;
+    };
+
+    usize seed = 0;
+
+    for (usize emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        u32 best = ~0u;
+        u32 bestNewVertices = 4;
+        f32 bestDistance = F32_MAX;
+
+        if (current.triangleCount > 0) {
+            f32 center[3];
+            for (u32 c = 0; c < 3; c++) {
+                center[c] = centerSum[c] / current.triangleCount;
+            }
+
+            for (u32 i = 0; i < current.vertexCount; i++) {
+                u32 vertex = data.vertices[current.vertexOffset + i];
+                if (liveTriangles[vertex] == 0) {
+                    continue;
+                }
+
+                for (u32 a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++) {
+                    u32 triangle = adjacency[a];
+                    if (emitted[triangle]) {
+                        continue;
+                    }
+
+                    u32 newVertices = countNewVertices(triangle);
+                    if (!fits(newVertices) || newVertices > bestNewVertices) {
+                        continue;
+                    }
+
+                    f32 distance = 0.0f;
+                    for (u32 c = 0; c < 3; c++) {
+                        f32 d = centroids[triangle * 3 + c] - center[c];
+                        distance += d * d;
+                    }
+
+                    if (newVertices < bestNewVertices || distance < bestDistance) {
+                        best = triangle;
+                        bestNewVertices = newVertices;
+                        bestDistance = distance;
+                    }
+                }
+            }
+        }
+
+        if (best == ~0u) {
+            while (emitted[seed]) {
+                seed++;
+            }
+            best = static_cast<u32>(seed);
+
+            // Disconnected pieces only share a meshlet while it is mostly
+            // empty, so small islands do not produce tiny clusters but large
+            // clusters keep tight bounds.
+            bool halfFull = current.triangleCount * 2 >= maxTriangles;
+            if (halfFull || !fits(countNewVertices(best))) {
+                flush();
+            }
+        }
+
+        append(best);
+    }
+
+    flush();
+
+    return data;
+}
+
+MeshletBounds computeMeshletBounds(
+    const MeshletData &data,
+    const Meshlet &meshlet,
+    const f32 *positions,
+    usize positionStride,
+    bool twoSided
+)
+{
+    MeshletBounds bounds{};
+    bounds.coneCutoff = DISABLED_CONE_CUTOFF;
+
+    if (meshlet.vertexCount == 0) {
+        return bounds;
+    }
+
+    f32 boundsMin[3] = { F32_MAX, F32_MAX, F32_MAX };
+    f32 boundsMax[3] = { -F32_MAX, -F32_MAX, -F32_MAX };
+
+    for (u32 i = 0; i < meshlet.vertexCount; i++) {
+        const f32 *p = getPosition(
+            positions,
+            positionStride,
+            data.vertices[meshlet.vertexOffset + i]
+        );
+
+        for (u32 c = 0; c < 3; c++) {
+            boundsMin[c] = std::min(boundsMin[c], p[c]);
+            boundsMax[c] = std::max(boundsMax[c], p[c]);
+        }
+    }
+
+    for (u32 c = 0; c < 3; c++) {
+        bounds.center[c] = (boundsMin[c] + boundsMax[c]) * 0.5f;
+    }
+
+    f32 radiusSquared = 0.0f;
+    for (u32 i = 0; i < meshlet.vertexCount; i++) {
+        const f32 *p = getPosition(
+            positions,
+            positionStride,
+            data.vertices[meshlet.vertexOffset + i]
+        );
+
+        f32 distance = 0.0f;
+        for (u32 c = 0; c < 3; c++) {
+            f32 d = p[c] - bounds.center[c];
+            distance += d * d;
+        }
+        radiusSquared = std::max(radiusSquared, distance);
+    }
+    bounds.radius = std::sqrt(radiusSquared);
+
+    std::vector<f32> normals;
+    std::vector<const f32 *> corners;
+    normals.reserve(meshlet.triangleCount * 3);
+    corners.reserve(meshlet.triangleCount);
+
+    f32 axis[3] = { 0.0f, 0.0f, 0.0f };
+
+    for (u32 t = 0; t < meshlet.triangleCount; t++) {
+        const u8 *local = &data.triangles[(meshlet.triangleOffset + t) * 3];
+        const f32 *p[3];
+        for (u32 k = 0; k < 3; k++) {
+            p[k] = getPosition(
+                positions,
+                positionStride,
+                data.vertices[meshlet.vertexOffset + local[k]]
+            );
+        }
+
+        f32 e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+        f32 e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+        f32 n[3] = {
+            e1[1] * e2[2] - e1[2] * e2[1],
+            e1[2] * e2[0] - e1[0] * e2[2],
+            e1[0] * e2[1] - e1[1] * e2[0]
+        };
+
+        f32 length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length <= 0.0f) {
+            continue;
+        }
+
+        for (u32 c = 0; c < 3; c++) {
+            n[c] /= length;
+            axis[c] += n[c];
+            normals.push_back(n[c]);
+        }
+        corners.push_back(p[0]);
+    }
+
+    f32 axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    if (twoSided || corners.empty() || axisLength <= 0.0f) {
+        return bounds;
+    }
+
+    for (u32 c = 0; c < 3; c++) {
+        axis[c] /= axisLength;
+    }
+
+    f32 minDot = 1.0f;
+    for (usize t = 0; t < corners.size(); t++) {
+        const f32 *n = &normals[t * 3];
+        minDot = std::min(minDot, n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]);
+    }
+
+    // Normals spread over (almost) a hemisphere cannot be cone culled.
+    if (minDot <= 0.1f) {
+        return bounds;
+    }
+
+    // Move the apex back along the axis until it lies behind every
+    // triangle plane.
+    f32 maxT = 0.0f;
+    for (usize t = 0; t < corners.size(); t++) {
+        const f32 *n = &normals[t * 3];
+        const f32 *p = corners[t];
+
+        f32 dc = (bounds.center[0] - p[0]) * n[0] +
+            (bounds.center[1] - p[1]) * n[1] +
+            (bounds.center[2] - p[2]) * n[2];
+        f32 dn = axis[0] * n[0] + axis[1] * n[1] + axis[2] * n[2];
+
+        maxT = std::max(maxT, dc / dn);
+    }
+
+    for (u32 c = 0; c < 3; c++) {
+        bounds.coneAxis[c] = axis[c];
+        bounds.coneApex[c] = bounds.center[c] - axis[c] * maxT;
+    }
+    bounds.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+
+    return bounds;
+}
+
+} // namespace gfx::geometry
\ No newline at end of file
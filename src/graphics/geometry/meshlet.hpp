@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "core/types.hpp"
+
+namespace gfx::geometry
+{
+
+constexpr u32 MESHLET_MAX_VERTICES = 64;
+constexpr u32 MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet
+{
+    u32 vertexOffset = 0;
+    u32 triangleOffset = 0;
+    u32 vertexCount = 0;
+    u32 triangleCount = 0;
+};
+
+// Laid out as 12 words so it can be copied straight into a storage buffer.
+// A back-facing test passes when
+// dot(normalize(coneApex - eye), coneAxis) >= coneCutoff.
+struct MeshletBounds
+{
+    f32 center[3];
+    f32 radius;
+    f32 coneApex[3];
+    f32 coneCutoff;
+    f32 coneAxis[3];
+    f32 padding;
+};
+
+// `vertices` maps meshlet-local vertices to the original vertex buffer,
+// `triangles` stores three local u8 indices per triangle.
+struct MeshletData
+{
+    std::vector<Meshlet> meshlets;
+    std::vector<u32> vertices;
+    std::vector<u8> triangles;
+};
+
+// Greedily grows each meshlet with the adjacent triangle that adds the
+// fewest new vertices, preferring triangles close to the meshlet center.
+MeshletData buildMeshlets(
+    const u32 *indices,
+    usize indexCount,
+    const f32 *positions,
+    usize positionStride,
+    usize vertexCount,
+    u32 maxVertices = MESHLET_MAX_VERTICES,
+    u32 maxTriangles = MESHLET_MAX_TRIANGLES
+);
+
+// Cones are disabled (cutoff above 1) for two-sided geometry or when the
+// triangle normals spread too wide to ever be culled.
+MeshletBounds computeMeshletBounds(
+    const MeshletData &data,
+    const Meshlet &meshlet,
+    const f32 *positions,
+    usize positionStride,
+    bool twoSided = false
+);
+
+} // namespace gfx::geometry
\ No newline at end of file
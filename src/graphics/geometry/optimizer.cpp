@@ -0,0 +1,491 @@
+#include "optimizer.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+namespace gfx::geometry
+{
+
+namespace
+{
+
+constexpr u32 FORSYTH_CACHE_SIZE = 32;
+constexpr u32 FORSYTH_MAX_VALENCE = 32;
+constexpr f32 FORSYTH_CACHE_DECAY_POWER = 1.5f;
+constexpr f32 FORSYTH_LAST_TRI_SCORE = 0.75f;
+constexpr f32 FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+constexpr f32 FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+constexpr u32 OVERDRAW_CACHE_SIZE = 16;
+
+struct ForsythTables
+{
+    f32 cache[FORSYTH_CACHE_SIZE];
+    f32 valence[FORSYTH_MAX_VALENCE + 1];
+
+    ForsythTables()
+    {
+        for (u32 i = 0; i < FORSYTH_CACHE_SIZE; i++) {
+            if (i < 3) {
+                cache[i] = FORSYTH_LAST_TRI_SCORE;
+            } else {
+                f32 scaler = 1.0f / static_cast<f32>(FORSYTH_CACHE_SIZE - 3);
+                f32 score = 1.0f - static_cast<f32>(i - 3) * scaler;
+                cache[i] = std::pow(score, FORSYTH_CACHE_DECAY_POWER);
+            }
+        }
+
+        valence[0] = 0.0f;
+        for (u32 i = 1; i <= FORSYTH_MAX_VALENCE; i++) {
+            valence[i] = FORSYTH_VALENCE_BOOST_SCALE *
+                std::pow(static_cast<f32>(i), -FORSYTH_VALENCE_BOOST_POWER);
+        }
+    }
+};
+
+const ForsythTables &getForsythTables()
+{
+    static const ForsythTables tables;
+    return tables;
+}
+
+f32 getVertexScore(i32 cachePosition, u32 remaining)
+{
+    if (remaining == 0) {
+        return -1.0f;
+    }
+
+    const ForsythTables &tables = getForsythTables();
+
+    f32 score = 0.0f;
+    if (cachePosition >= 0) {
+        score = tables.cache[cachePosition];
+    }
+
+    if (remaining <= FORSYTH_MAX_VALENCE) {
+        score += tables.valence[remaining];
+    } else {
+        score += FORSYTH_VALENCE_BOOST_SCALE *
+            std::pow(static_cast<f32>(remaining), -FORSYTH_VALENCE_BOOST_POWER);
+    }
+
+    return score;
+}
+
+struct Adjacency
+{
+    std::vector<u32> counts;
+    std::vector<u32> offsets;
+    std::vector<u32> triangles;
+};
+
+Adjacency buildAdjacency(
+    const u32 *indices,
+    usize indexCount,
+    usize vertexCount
+)
+{
+    Adjacency adjacency;
+    adjacency.counts.assign(vertexCount, 0);
+    adjacency.offsets.assign(vertexCount, 0);
+    adjacency.triangles.resize(indexCount);
+
+    for (usize i = 0; i < indexCount; i++) {
+        adjacency.counts[indices[i]]++;
+    }
+
+    u32 offset = 0;
+    for (usize v = 0; v < vertexCount; v++) {
+        adjacency.offsets[v] = offset;
+        offset += adjacency.counts[v];
+    }
+
+    std::vector<u32> fill(adjacency.offsets);
+    for (usize i = 0; i < indexCount; i++) {
+        adjacency.triangles[fill[indices[i]]++] = static_cast<u32>(i / 3);
+    }
+
+    return adjacency;
+}
+
+void validateIndices(const u32 *indices, usize indexCount, usize vertexCount)
+{
+    if (indexCount % 3 != 0) {
+        throw std::invalid_argument("Index count must be a multiple of 3.");
+    }
+
+    for (usize i = 0; i < indexCount; i++) {
+        if (indices[i] >= vertexCount) {
+            throw std::out_of_range("Index references a missing vertex.");
+        }
+    }
+}
+
+} // namespace
+
+VertexCacheStats analyzeVertexCache(
+    const u32 *indices,
+    usize indexCount,
+    usize vertexCount,
+    u32 cacheSize
+)
+{
+    VertexCacheStats stats;
+
+    if (indexCount == 0) {
+        return stats;
+    }
+
+    std::vector<u32> timestamps(vertexCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    u32 timestamp = cacheSize + 1;
+    usize uniqueVertices = 0;
+
+    for (usize i = 0; i < indexCount; i++) {
+        u32 v = indices[i];
+
+        if (timestamp - timestamps[v] > cacheSize) {
+            timestamps[v] = timestamp++;
+            stats.vertexTransforms++;
+        }
+
+        if (!used[v]) {
+            used[v] = true;
+            uniqueVertices++;
+        }
+    }
+
+    stats.acmr = static_cast<f32>(stats.vertexTransforms) /
+        static_cast<f32>(indexCount / 3);
+    stats.atvr = static_cast<f32>(stats.vertexTransforms) /
+        static_cast<f32>(uniqueVertices);
+
+    return stats;
+}
+
+void optimizeVertexCache(
+    u32 *dst,
+    const u32 *indices,
+    usize indexCount,
+    usize vertexCount
+)
+{
+    validateIndices(indices, indexCount, vertexCount);
+
+    usize triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    Adjacency adjacency = buildAdjacency(indices, indexCount, vertexCount);
+
+    std::vector<f32> vertexScores(vertexCount);
+    for (usize v = 0; v < vertexCount; v++) {
+        vertexScores[v] = getVertexScore(-1, adjacency.counts[v]);
+    }
+
+    std::vector<f32> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+
+    u32 bestTriangle = 0;
+    f32 bestScore = -1.0f;
+
+    for (usize t = 0; t < triangleCount; t++) {
+        const u32 *tri = indices + t * 3;
+        triangleScores[t] =
+            vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+
+        if (triangleScores[t] > bestScore) {
+            bestScore = triangleScores[t];
+            bestTriangle = static_cast<u32>(t);
+        }
+    }
+
+    u32 cache[FORSYTH_CACHE_SIZE + 3];
+    u32 cacheCount = 0;
+    usize deadEndCursor = 0;
+
+    for (usize out = 0; out < triangleCount; out++) {
+        if (bestTriangle == ~0u) {
+            while (emitted[deadEndCursor]) {
+                deadEndCursor++;
+            }
+            bestTriangle = static_cast<u32>(deadEndCursor);
+        }
+
+        const u32 *tri = indices + bestTriangle * 3;
+        dst[out * 3 + 0] = tri[0];
+        dst[out * 3 + 1] = tri[1];
+        dst[out * 3 + 2] = tri[2];
+        emitted[bestTriangle] = true;
+
+        for (u32 k = 0; k < 3; k++) {
+            u32 v = tri[k];
+            u32 *list = adjacency.triangles.data() + adjacency.offsets[v];
+            u32 &count = adjacency.counts[v];
+
+            for (u32 i = 0; i < count; i++) {
+                if (list[i] == bestTriangle) {
+                    list[i] = list[count - 1];
+                    count--;
+                    break;
+                }
+            }
+        }
+
+        u32 newCache[FORSYTH_CACHE_SIZE + 3];
+        u32 newCount = 0;
+
+        auto pushUnique = [&](u32 v) {
+            for (u32 i = 0; i < newCount; i++) {
+                if (newCache[i] == v) {
+                    return;
+                }
+            }
+            newCache[newCount++] = v;
+        };
+
+        pushUnique(tri[0]);
+        pushUnique(tri[1]);
+        pushUnique(tri[2]);
+
+        for (u32 i = 0; i < cacheCount; i++) {
+            u32 v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                newCache[newCount++] = v;
+            }
+        }
+
+        for (u32 i = 0; i < newCount; i++) {
+            u32 v = newCache[i];
+            i32 position = i < FORSYTH_CACHE_SIZE ? static_cast<i32>(i) : -1;
+
+            f32 score = getVertexScore(position, adjacency.counts[v]);
+            f32 delta = score - vertexScores[v];
+            vertexScores[v] = score;
+
+            const u32 *list = adjacency.triangles.data() + adjacency.offsets[v];
+            for (u32 j = 0; j < adjacency.counts[v]; j++) {
+                triangleScores[list[j]] += delta;
+            }
+        }
+
+        bestTriangle = ~0u;
+        bestScore = -1.0f;
+
+        cacheCount = std::min(newCount, FORSYTH_CACHE_SIZE);
+
+        for (u32 i = 0; i < cacheCount; i++) {
+            u32 v = newCache[i];
+            const u32 *list = adjacency.triangles.data() + adjacency.offsets[v];
+
+            for (u32 j = 0; j < adjacency.counts[v]; j++) {
+                u32 t = list[j];
+                if (triangleScores[t] > bestScore) {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        memcpy(cache, newCache, cacheCount * sizeof(u32));
+    }
+}
+
+void optimizeOverdraw(
+    u32 *dst,
+    const u32 *indices,
+    usize indexCount,
+    const f32 *positions,
+    usize positionStride,
+    usize vertexCount,
+    f32 threshold
+)
+{
+    validateIndices(indices, indexCount, vertexCount);
+
+    usize triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    auto position = [&](u32 v) {
+        return reinterpret_cast<const f32 *>(
+            reinterpret_cast<const u8 *>(positions) + v * positionStride
+        );
+    };
+
+    std::vector<u32> timestamps(vertexCount, 0);
+    u32 timestamp = OVERDRAW_CACHE_SIZE + 1;
+
+    std::vector<u32> triangleMisses(triangleCount);
+    std::vector<u32> hardClusters;
+
+    for (usize t = 0; t < triangleCount; t++) {
+        u32 misses = 0;
+        for (u32 k = 0; k < 3; k++) {
+            u32 v = indices[t * 3 + k];
+            if (timestamp - timestamps[v] > OVERDRAW_CACHE_SIZE) {
+                timestamps[v] = timestamp++;
+                misses++;
+            }
+        }
+
+        triangleMisses[t] = misses;
+        if (t == 0 || misses == 3) {
+            hardClusters.push_back(static_cast<u32>(t));
+        }
+    }
+
+    std::vector<u32> clusters;
+    for (usize c = 0; c < hardClusters.size(); c++) {
+        u32 start = hardClusters[c];
+        u32 end = c + 1 < hardClusters.size() ?
+            hardClusters[c + 1] : static_cast<u32>(triangleCount);
+
+        u32 hardMisses = 0;
+        for (u32 t = start; t < end; t++) {
+            hardMisses += triangleMisses[t];
+        }
+
+        f32 limit = threshold * static_cast<f32>(hardMisses) /
+            static_cast<f32>(end - start);
+
+        timestamp += OVERDRAW_CACHE_SIZE + 1;
+        u32 misses = 0;
+        u32 softStart = start;
+
+        clusters.push_back(start);
+
+        for (u32 t = start; t < end; t++) {
+            for (u32 k = 0; k < 3; k++) {
+                u32 v = indices[t * 3 + k];
+                if (timestamp - timestamps[v] > OVERDRAW_CACHE_SIZE) {
+                    timestamps[v] = timestamp++;
+                    misses++;
+                }
+            }
+
+            u32 softCount = t - softStart + 1;
+            f32 softAcmr = static_cast<f32>(misses) / static_cast<f32>(softCount);
+
+            if (t + 1 < end && softCount >= 16 && softAcmr <= limit) {
+                clusters.push_back(t + 1);
+                softStart = t + 1;
+                misses = 0;
+                timestamp += OVERDRAW_CACHE_SIZE + 1;
+            }
+        }
+    }
+
+    f32 meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    for (usize i = 0; i < indexCount; i++) {
+        const f32 *p = position(indices[i]);
+        meshCentroid[0] += p[0];
+        meshCentroid[1] += p[1];
+        meshCentroid[2] += p[2];
+    }
+    for (u32 k = 0; k < 3; k++) {
+        meshCentroid[k] /= static_cast<f32>(indexCount);
+    }
+
+    std::vector<f32> sortKeys(clusters.size());
+
+    for (usize c = 0; c < clusters.size(); c++) {
+        u32 start = clusters[c];
+        u32 end = c + 1 < clusters.size() ?
+            clusters[c + 1] : static_cast<u32>(triangleCount);
+
+        f32 centroid[3] = {0.0f, 0.0f, 0.0f};
+        f32 normal[3] = {0.0f, 0.0f, 0.0f};
+        f32 totalArea = 0.0f;
+
+        for (u32 t = start; t < end; t++) {
+            const f32 *p0 = position(indices[t * 3 + 0]);
+            const f32 *p1 = position(indices[t * 3 + 1]);
+            const f32 *p2 = position(indices[t * 3 + 2]);
+
+            f32 e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            f32 e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            f32 n[3] = {
+                e1[1] * e2[2] - e1[2] * e2[1],
+                e1[2] * e2[0] - e1[0] * e2[2],
+                e1[0] * e2[1] - e1[1] * e2[0]
+            };
+
+            f32 area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (u32 k = 0; k < 3; k++) {
+                centroid[k] += (p0[k] + p1[k] + p2[k]) * (area / 3.0f);
+                normal[k] += n[k];
+            }
+            totalArea += area;
+        }
+
+        f32 invArea = totalArea > 0.0f ? 1.0f / totalArea : 0.0f;
+        f32 normalLength = std::sqrt(
+            normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]
+        );
+        f32 invNormal = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+
+        f32 key = 0.0f;
+        for (u32 k = 0; k < 3; k++) {
+            key += (centroid[k] * invArea - meshCentroid[k]) * normal[k] * invNormal;
+        }
+
+        sortKeys[c] = key;
+    }
+
+    std::vector<u32> order(clusters.size());
+    for (usize c = 0; c < order.size(); c++) {
+        order[c] = static_cast<u32>(c);
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    usize out = 0;
+    for (u32 c : order) {
+        u32 start = clusters[c];
+        u32 end = c + 1 < clusters.size() ?
+            clusters[c + 1] : static_cast<u32>(triangleCount);
+
+        usize count = (end - start) * 3;
+        memcpy(dst + out, indices + start * 3, count * sizeof(u32));
+        out += count;
+    }
+}
+
+std::vector<u32> optimizeVertexFetchRemap(
+    u32 *indices,
+    usize indexCount,
+    usize vertexCount,
+    usize *uniqueVertexCount
+)
+{
+    std::vector<u32> remap(vertexCount, ~0u);
+    u32 next = 0;
+
+    for (usize i = 0; i < indexCount; i++) {
+        u32 &v = indices[i];
+        if (v >= vertexCount) {
+            throw std::out_of_range("Index references a missing vertex.");
+        }
+
+        if (remap[v] == ~0u) {
+            remap[v] = next++;
+        }
+        v = remap[v];
+    }
+
+    if (uniqueVertexCount) {
+        *uniqueVertexCount = next;
+    }
+
+    return remap;
+}
+
+} // namespace gfx::geometry
\ No newline at end of file
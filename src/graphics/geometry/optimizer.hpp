@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "core/types.hpp"
+
+namespace gfx::geometry
+{
+
+struct VertexCacheStats
+{
+    u32 vertexTransforms = 0;
+    f32 acmr = 0.0f;
+    f32 atvr = 0.0f;
+};
+
+// Simulates a FIFO post-transform cache. ACMR is transforms per triangle,
+// ATVR is transforms per referenced vertex (1.0 is optimal).
+VertexCacheStats analyzeVertexCache(
+    const u32 *indices,
+    usize indexCount,
+    usize vertexCount,
+    u32 cacheSize = 16
+);
+
+// Reorders triangles for post-transform cache locality (Forsyth).
+// `dst` must not alias `indices`.
+void optimizeVertexCache(
+    u32 *dst,
+    const u32 *indices,
+    usize indexCount,
+    usize vertexCount
+);
+
+// Reorders clusters of an already cache-optimized index buffer so that
+// outward facing clusters are drawn first. `threshold` bounds how much
+// ACMR may degrade (1.05 allows 5%).
+void optimizeOverdraw(
+    u32 *dst,
+    const u32 *indices,
+    usize indexCount,
+    const f32 *positions,
+    usize positionStride,
+    usize vertexCount,
+    f32 threshold = 1.05f
+);
+
+// Renumbers vertices in first-use order, rewriting `indices` in place.
+// Returns the old-to-new remap table; unused vertices map to ~0u.
+std::vector<u32> optimizeVertexFetchRemap(
+    u32 *indices,
+    usize indexCount,
+    usize vertexCount,
+    usize *uniqueVertexCount = nullptr
+);
+
+template<typename T>
+std::vector<T> remapVertices(
+    const std::vector<T> &vertices,
+    const std::vector<u32> &remap,
+    usize newVertexCount
+)
+{
+    std::vector<T> result(newVertexCount);
+
+    for (usize i = 0; i < vertices.size(); i++) {
+        if (remap[i] != ~0u) {
+            result[remap[i]] = vertices[i];
+        }
+    }
+
+    return result;
+}
+
+} // namespace gfx::geometry
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "quantization.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace gfx::geometry
+{
+
+u16 quantizeUnorm16(f32 value)
+{
+    value = std::clamp(value, 0.0f, 1.0f);
+    return static_cast<u16>(value * 65535.0f + 0.5f);
+}
+
+f32 dequantizeUnorm16(u16 value)
+{
+    return value / 65535.0f;
+}
+
+u16 quantizeHalf(f32 value)
+{
+    u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    u32 sign = (bits >> 16) & 0x8000u;
+    u32 exponent = (bits >> 23) & 0xFFu;
+    u32 mantissa = bits & 0x7FFFFFu;
+
+    if (exponent == 0xFFu) {
+        return static_cast<u16>(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+    }
+
+    i32 halfExponent = static_cast<i32>(exponent) - 127 + 15;
+
+    if (halfExponent >= 31) {
+        return static_cast<u16>(sign | 0x7C00u);
+    }
+
+    if (halfExponent <= 0) {
+        if (halfExponent < -10) {
+            return static_cast<u16>(sign);
+        }
+
+        mantissa |= 0x800000u;
+        u32 shift = static_cast<u32>(14 - halfExponent);
+        u32 half = mantissa >> shift;
+        u32 rest = mantissa & ((1u << shift) - 1);
+        u32 midpoint = 1u << (shift - 1);
+
+        if (rest > midpoint || (rest == midpoint && (half & 1u))) {
+            half++;
+        }
+
+        return static_cast<u16>(sign | half);
+    }
+
+    u32 half = (static_cast<u32>(halfExponent) << 10) | (mantissa >> 13);
+    u32 rest = mantissa & 0x1FFFu;
+
+    // A carry out of the mantissa correctly bumps the exponent (and
+    // rounds the largest finite values up to inf).
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        half++;
+    }
+
+    return static_cast<u16>(sign | half);
+}
+
+f32 dequantizeHalf(u16 value)
+{
+    u32 sign = static_cast<u32>(value & 0x8000u) << 16;
+    u32 exponent = (value >> 10) & 0x1Fu;
+    u32 mantissa = value & 0x3FFu;
+
+    u32 bits;
+    if (exponent == 0x1Fu) {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    } else if (mantissa != 0) {
+        f32 result = std::ldexp(static_cast<f32>(mantissa), -24);
+        return sign ? -result : result;
+    } else {
+        bits = sign;
+    }
+
+    f32 result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+static i16 quantizeSnorm16(f32 value)
+{
+    value = std::clamp(value, -1.0f, 1.0f);
+    return static_cast<i16>(std::lround(value * 32767.0f));
+}
+
+void encodeOctahedral(const f32 *normal, i16 *dst)
+{
+    f32 length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    if (length <= 0.0f) {
+        dst[0] = 0;
+        dst[1] = 0;
+        return;
+    }
+
+    f32 x = normal[0] / length;
+    f32 y = normal[1] / length;
+
+    if (normal[2] < 0.0f) {
+        f32 foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        f32 foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    dst[0] = quantizeSnorm16(x);
+    dst[1] = quantizeSnorm16(y);
+}
+
+void decodeOctahedral(const i16 *src, f32 *normal)
+{
+    f32 x = std::max(src[0] / 32767.0f, -1.0f);
+    f32 y = std::max(src[1] / 32767.0f, -1.0f);
+    f32 z = 1.0f - std::fabs(x) - std::fabs(y);
+
+    f32 t = std::max(-z, 0.0f);
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+
+    f32 length = std::sqrt(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+} // namespace gfx::geometry
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+#include "core/types.hpp"
+
+namespace gfx::geometry
+{
+
+// Maps [0, 1] to the full u16 range with round-to-nearest.
+u16 quantizeUnorm16(f32 value);
+f32 dequantizeUnorm16(u16 value);
+
+// IEEE 754 binary16 with round-to-nearest-even; overflow saturates to inf.
+u16 quantizeHalf(f32 value);
+f32 dequantizeHalf(u16 value);
+
+// Octahedral unit vector encoding into two snorm16 components. The
+// input does not need to be normalized.
+void encodeOctahedral(const f32 *normal, i16 *dst);
+void decodeOctahedral(const i16 *src, f32 *normal);
+
+} // namespace gfx::geometry
\ No newline at end of file
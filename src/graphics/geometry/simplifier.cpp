@@ -0,0 +1,386 @@
+#include "simplifier.hpp"
+#include "welder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace gfx::geometry
+{
+
+namespace
+{
+
+struct Quadric
+{
+    f64 a00 = 0.0, a11 = 0.0, a22 = 0.0;
+    f64 a01 = 0.0, a02 = 0.0, a12 = 0.0;
+    f64 b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    f64 c = 0.0;
+    f64 weight = 0.0;
+
+    void addPlane(f64 nx, f64 ny, f64 nz, f64 d, f64 w)
+    {
+        a00 += w * nx * nx;
+        a11 += w * ny * ny;
+        a22 += w * nz * nz;
+        a01 += w * nx * ny;
+        a02 += w * nx * nz;
+        a12 += w * ny * nz;
+        b0 += w * nx * d;
+        b1 += w * ny * d;
+        b2 += w * nz * d;
+        c += w * d * d;
+        weight += w;
+    }
+
+    void add(const Quadric &other)
+    {
+        a00 += other.a00;
+        a11 += other.a11;
+        a22 += other.a22;
+        a01 += other.a01;
+        a02 += other.a02;
+        a12 += other.a12;
+        b0 += other.b0;
+        b1 += other.b1;
+        b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+    }
+
+    // Weighted mean squared distance of `p` to the accumulated planes.
+    f64 evaluate(const f32 *p) const
+    {
+        f64 x = p[0], y = p[1], z = p[2];
+
+        f64 r = a00 * x * x + a11 * y * y + a22 * z * z;
+        r += 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z);
+        r += 2.0 * (b0 * x + b1 * y + b2 * z);
+        r += c;
+
+        return weight > 0.0 ? std::fabs(r) / weight : 0.0;
+    }
+};
+
+struct Collapse
+{
+    u32 v;
+    u32 u;
+    f64 cost;
+};
+
+void cross(const f32 *a, const f32 *b, const f32 *c, f64 *n)
+{
+    f64 e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    f64 e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+u64 edgeKey(u32 a, u32 b)
+{
+    return a < b ?
+        (static_cast<u64>(a) << 32) | b :
+        (static_cast<u64>(b) << 32) | a;
+}
+
+} // namespace
+
+usize simplify(
+    u32 *dst,
+    const u32 *indices,
+    usize indexCount,
+    const f32 *positions,
+    usize positionStride,
+    usize vertexCount,
+    usize targetIndexCount,
+    f32 targetError,
+    f32 *resultError
+)
+{
+    if (indexCount % 3 != 0) {
+        throw std::invalid_argument("Index count must be a multiple of 3.");
+    }
+
+    if (resultError) {
+        *resultError = 0.0f;
+    }
+
+    for (usize i = 0; i < indexCount; i++) {
+        if (indices[i] >= vertexCount) {
+            throw std::out_of_range("Index references a missing vertex.");
+        }
+    }
+
+    std::vector<u32> result(indices, indices + indexCount);
+
+    if (targetIndexCount >= indexCount || vertexCount == 0) {
+        memcpy(dst, result.data(), indexCount * sizeof(u32));
+        return indexCount;
+    }
+
+    // Positions normalized to a unit extent make errors scale independent.
+    const u8 *positionData = reinterpret_cast<const u8 *>(positions);
+    std::vector<f32> pos(vertexCount * 3);
+
+    f32 boundsMin[3] = { F32_MAX, F32_MAX, F32_MAX };
+    f32 boundsMax[3] = { -F32_MAX, -F32_MAX, -F32_MAX };
+
+    for (usize v = 0; v < vertexCount; v++) {
+        const f32 *p = reinterpret_cast<const f32 *>(positionData + v * positionStride);
+        for (u32 c = 0; c < 3; c++) {
+            pos[v * 3 + c] = p[c];
+            boundsMin[c] = std::min(boundsMin[c], p[c]);
+            boundsMax[c] = std::max(boundsMax[c], p[c]);
+        }
+    }
+
+    f32 extent = std::max({
+        boundsMax[0] - boundsMin[0],
+        boundsMax[1] - boundsMin[1],
+        boundsMax[2] - boundsMin[2]
+    });
+    f32 scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+    for (usize v = 0; v < vertexCount; v++) {
+        for (u32 c = 0; c < 3; c++) {
+            pos[v * 3 + c] = (pos[v * 3 + c] - boundsMin[c]) * scale;
+        }
+    }
+
+    // Vertices sharing a position (attribute seams) form one topological
+    // vertex; quadrics and edge counts are tracked per position.
+    std::vector<u32> positionIDs(vertexCount);
+    usize positionCount = generateVertexRemap(
+        positionIDs.data(),
+        nullptr,
+        vertexCount,
+        pos.data(),
+        vertexCount,
+        sizeof(f32) * 3
+    );
+
+    std::vector<u8> referenced(vertexCount, 0);
+    for (u32 index : result) {
+        referenced[index] = 1;
+    }
+
+    std::vector<u32> wedgeCount(positionCount, 0);
+    for (usize v = 0; v < vertexCount; v++) {
+        wedgeCount[positionIDs[v]] += referenced[v];
+    }
+
+    std::unordered_map<u64, u32> edgeCounts;
+    edgeCounts.reserve(indexCount);
+
+    std::vector<Quadric> quadrics(positionCount);
+
+    for (usize i = 0; i < indexCount; i += 3) {
+        u32 p[3] = {
+            positionIDs[result[i + 0]],
+            positionIDs[result[i + 1]],
+            positionIDs[result[i + 2]]
+        };
+
+        if (p[0] == p[1] || p[1] == p[2] || p[0] == p[2]) {
+            continue;
+        }
+
+        for (u32 e = 0; e < 3; e++) {
+            edgeCounts[edgeKey(p[e], p[(e + 1) % 3])]++;
+        }
+
+        const f32 *p0 = &pos[result[i + 0] * 3];
+        const f32 *p1 = &pos[result[i + 1] * 3];
+        const f32 *p2 = &pos[result[i + 2] * 3];
+
+        f64 n[3];
+        cross(p0, p1, p2, n);
+
+        f64 length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length <= 0.0) {
+            continue;
+        }
+
+        n[0] /= length;
+        n[1] /= length;
+        n[2] /= length;
+        f64 d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+
+        for (u32 c = 0; c < 3; c++) {
+            quadrics[p[c]].addPlane(n[0], n[1], n[2], d, length);
+        }
+    }
+
+    std::vector<u8> lockedPositions(positionCount, 0);
+    for (usize id = 0; id < positionCount; id++) {
+        lockedPositions[id] = wedgeCount[id] > 1;
+    }
+
+    for (const auto &[key, count] : edgeCounts) {
+        if (count != 2) {
+            lockedPositions[key >> 32] = 1;
+            lockedPositions[key & 0xFFFFFFFFu] = 1;
+        }
+    }
+
+    std::vector<u32> remap(vertexCount);
+    for (usize v = 0; v < vertexCount; v++) {
+        remap[v] = static_cast<u32>(v);
+    }
+
+    std::vector<u32> adjacencyOffsets(vertexCount + 1);
+    std::vector<u32> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<u8> touched(vertexCount);
+
+    const f64 errorLimit = static_cast<f64>(targetError) * targetError;
+    f64 maxError = 0.0;
+
+    while (result.size() > targetIndexCount) {
+        usize triangleCount = result.size() / 3;
+
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (u32 index : result) {
+            adjacencyOffsets[index + 1]++;
+        }
+        for (usize v = 0; v < vertexCount; v++) {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+
+        adjacency.resize(result.size());
+        std::vector<u32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (usize i = 0; i < result.size(); i++) {
+            adjacency[fill[result[i]]++] = static_cast<u32>(i / 3);
+        }
+
+        collapses.clear();
+        for (usize i = 0; i < result.size(); i += 3) {
+            for (u32 e = 0; e < 3; e++) {
+                u32 a = result[i + e];
+                u32 b = result[i + (e + 1) % 3];
+
+                for (u32 dir = 0; dir < 2; dir++) {
+                    u32 v = dir == 0 ? a : b;
+                    u32 u = dir == 0 ? b : a;
+
+                    if (lockedPositions[positionIDs[v]] || v == u) {
+                        continue;
+                    }
+
+                    Quadric q = quadrics[positionIDs[v]];
+                    q.add(quadrics[positionIDs[u]]);
+
+                    collapses.push_back({ v, u, q.evaluate(&pos[u * 3]) });
+                }
+            }
+        }
+
+        if (collapses.empty()) {
+            break;
+        }
+
+        std::sort(
+            collapses.begin(),
+            collapses.end(),
+            [](const Collapse &a, const Collapse &b) { return a.cost < b.cost; }
+        );
+
+        // Interior collapses remove two triangles each.
+        usize targetTriangles = targetIndexCount / 3;
+        usize collapseLimit = (triangleCount - targetTriangles) / 2 + 1;
+        usize collapsed = 0;
+
+        std::fill(touched.begin(), touched.end(), 0);
+
+        for (const Collapse &collapse : collapses) {
+            if (collapse.cost > errorLimit || collapsed >= collapseLimit) {
+                break;
+            }
+
+            u32 v = collapse.v;
+            u32 u = collapse.u;
+
+            if (touched[v] || touched[u]) {
+                continue;
+            }
+
+            bool flips = false;
+            for (u32 a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1] && !flips; a++) {
+                const u32 *tri = &result[adjacency[a] * 3];
+                if (tri[0] == u || tri[1] == u || tri[2] == u) {
+                    continue;
+                }
+
+                const f32 *before[3];
+                const f32 *after[3];
+                for (u32 c = 0; c < 3; c++) {
+                    before[c] = &pos[tri[c] * 3];
+                    after[c] = tri[c] == v ? &pos[u * 3] : before[c];
+                }
+
+                f64 n0[3], n1[3];
+                cross(before[0], before[1], before[2], n0);
+                cross(after[0], after[1], after[2], n1);
+
+                // Reject rotations past ~75 degrees, not only full flips,
+                // so repeated collapses cannot fold a triangle over.
+                f64 dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+                f64 len0 = std::sqrt(n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]);
+                f64 len1 = std::sqrt(n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]);
+                flips = dot <= 0.25 * len0 * len1;
+            }
+
+            if (flips) {
+                continue;
+            }
+
+            remap[v] = u;
+            quadrics[positionIDs[u]].add(quadrics[positionIDs[v]]);
+
+            for (u32 a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; a++) {
+                const u32 *tri = &result[adjacency[a] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+            }
+            touched[u] = 1;
+
+            maxError = std::max(maxError, collapse.cost);
+            collapsed++;
+        }
+
+        if (collapsed == 0) {
+            break;
+        }
+
+        usize write = 0;
+        for (usize i = 0; i < result.size(); i += 3) {
+            u32 a = remap[result[i + 0]];
+            u32 b = remap[result[i + 1]];
+            u32 c = remap[result[i + 2]];
+
+            if (a == b || b == c || a == c) {
+                continue;
+            }
+
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (resultError) {
+        *resultError = static_cast<f32>(std::sqrt(maxError));
+    }
+
+    memcpy(dst, result.data(), result.size() * sizeof(u32));
+    return result.size();
+}
+
+} // namespace gfx::geometry
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+#include "core/types.hpp"
+
+namespace gfx::geometry
+{
+
+// Quadric error metric edge-collapse simplification. Writes at most
+// `indexCount` indices to `dst` (which may alias `indices`) and returns the
+// resulting index count. Vertices on open borders, UV/normal seams and
+// non-manifold edges are never moved, so the vertex buffer is reused as is.
+//
+// `targetError` and `resultError` are relative to the mesh extent; multiply
+// by the bounding radius to get model space units.
+usize simplify(
+    u32 *dst,
+    const u32 *indices,
+    usize indexCount,
+    const f32 *positions,
+    usize positionStride,
+    usize vertexCount,
+    usize targetIndexCount,
+    f32 targetError,
+    f32 *resultError = nullptr
+);
+
+} // namespace gfx::geometry
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "welder.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace gfx::geometry
+{
+
+namespace
+{
+
+constexpr u32 EMPTY_SLOT = ~0u;
+
+u32 hashBytes(const u8 *data, usize size)
+{
+    u32 hash = 2166136261u;
+
+    for (usize i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+class VertexHasher
+{
+
+public:
+    VertexHasher(
+        const void *vertices,
+        usize vertexSize,
+        WeldMode mode,
+        f32 epsilon
+    ) :
+        m_vertices(static_cast<const u8 *>(vertices)),
+        m_vertexSize(vertexSize),
+        m_mode(mode),
+        m_invEpsilon(epsilon > 0.0f ? 1.0f / epsilon : 0.0f)
+    {
+    }
+
+    u32 hash(u32 index) const
+    {
+        const u8 *vertex = m_vertices + index * m_vertexSize;
+
+        if (m_mode == WeldMode::Exact) {
+            return hashBytes(vertex, m_vertexSize);
+        }
+
+        u32 hash = 2166136261u;
+        for (usize c = 0; c < m_vertexSize / sizeof(f32); c++) {
+            i32 key = quantize(vertex, c);
+            hash ^= static_cast<u32>(key);
+            hash *= 16777619u;
+        }
+
+        return hash;
+    }
+
+    bool equal(u32 a, u32 b) const
+    {
+        const u8 *va = m_vertices + a * m_vertexSize;
+        const u8 *vb = m_vertices + b * m_vertexSize;
+
+        if (m_mode == WeldMode::Exact) {
+            return memcmp(va, vb, m_vertexSize) == 0;
+        }
+
+        for (usize c = 0; c < m_vertexSize / sizeof(f32); c++) {
+            if (quantize(va, c) != quantize(vb, c)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    const u8 *m_vertices;
+    usize m_vertexSize;
+    WeldMode m_mode;
+    f32 m_invEpsilon;
+
+    i32 quantize(const u8 *vertex, usize component) const
+    {
+        f32 value;
+        memcpy(&value, vertex + component * sizeof(f32), sizeof(f32));
+        return static_cast<i32>(std::lround(value * m_invEpsilon));
+    }
+
+};
+
+} // namespace
+
+usize generateVertexRemap(
+    u32 *remap,
+    const u32 *indices,
+    usize indexCount,
+    const void *vertices,
+    usize vertexCount,
+    usize vertexSize,
+    WeldMode mode,
+    f32 epsilon
+)
+{
+    if (mode == WeldMode::Epsilon && (epsilon <= 0.0f || vertexSize % sizeof(f32) != 0)) {
+        throw std::invalid_argument("Epsilon welding needs float vertices and epsilon > 0.");
+    }
+
+    if (!indices && indexCount != vertexCount) {
+        throw std::invalid_argument("Unindexed welding needs indexCount == vertexCount.");
+    }
+
+    for (usize i = 0; i < vertexCount; i++) {
+        remap[i] = ~0u;
+    }
+
+    usize tableSize = 1;
+    while (tableSize < vertexCount + vertexCount / 4 + 1) {
+        tableSize *= 2;
+    }
+
+    std::vector<u32> table(tableSize, EMPTY_SLOT);
+    const usize mask = tableSize - 1;
+
+    VertexHasher hasher(vertices, vertexSize, mode, epsilon);
+    u32 next = 0;
+
+    for (usize i = 0; i < indexCount; i++) {
+        u32 index = indices ? indices[i] : static_cast<u32>(i);
+        if (index >= vertexCount) {
+            throw std::out_of_range("Index references a missing vertex.");
+        }
+
+        if (remap[index] != ~0u) {
+            continue;
+        }
+
+        usize slot = hasher.hash(index) & mask;
+
+        for (usize probe = 0; ; probe++) {
+            u32 entry = table[slot];
+
+            if (entry == EMPTY_SLOT) {
+                table[slot] = index;
+                remap[index] = next++;
+                break;
+            }
+
+            if (hasher.equal(entry, index)) {
+                remap[index] = remap[entry];
+                break;
+            }
+
+            slot = (slot + probe + 1) & mask;
+        }
+    }
+
+    return next;
+}
+
+void remapIndexBuffer(
+    u32 *dst,
+    const u32 *indices,
+    usize indexCount,
+    const u32 *remap
+)
+{
+    for (usize i = 0; i < indexCount; i++) {
+        u32 index = indices ? indices[i] : static_cast<u32>(i);
+        dst[i] = remap[index];
+    }
+}
+
+} // namespace gfx::geometry
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "core/types.hpp"
+
+namespace gfx::geometry
+{
+
+enum class WeldMode
+{
+    Exact,
+    Epsilon
+};
+
+// Builds an old-to-new vertex remap merging identical vertices. In Epsilon
+// mode vertices are treated as arrays of f32 and merged when every
+// component snaps to the same multiple of `epsilon`. Vertices that are
+// never referenced by `indices` map to ~0u. A null `indices` means the
+// stream is unindexed and `indexCount` equals the vertex count.
+usize generateVertexRemap(
+    u32 *remap,
+    const u32 *indices,
+    usize indexCount,
+    const void *vertices,
+    usize vertexCount,
+    usize vertexSize,
+    WeldMode mode = WeldMode::Exact,
+    f32 epsilon = 0.0f
+);
+
+void remapIndexBuffer(
+    u32 *dst,
+    const u32 *indices,
+    usize indexCount,
+    const u32 *remap
+);
+
+} // namespace gfx::geometry
\ No newline at end of file
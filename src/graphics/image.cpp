@@ -1,10 +1,58 @@
 #include "image.hpp"
 #include "device.hpp"
+#include "texture/ktx2.hpp"
+#include "texture/mipmaps.hpp"
 #include "stb_image.h"
 
+#include <fstream>
+
 namespace gfx
 {
 
+namespace
+{
+
+constexpr VkFormatFeatureFlags LINEAR_BLIT_FEATURES =
+    VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT |
+    VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+    VK_FORMAT_FEATURE_BLIT_DST_BIT;
+
+// 8 bit RGBA layouts the CPU mip generator can filter when blitting is
+// not available.
+bool isCpuFilterable(VkFormat format, bool &srgb)
+{
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+            srgb = false;
+            return true;
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            srgb = true;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Storage for the compute downsampler when it can handle the image,
+// blit sources otherwise.
+VkImageUsageFlags getMipmapUsage(
+    Device &device,
+    VkFormat format,
+    u32 width,
+    u32 height
+)
+{
+    if (device.getDownsampler().isSupported(format, width, height)) {
+        return VK_IMAGE_USAGE_STORAGE_BIT;
+    }
+
+    return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+}
+
+} // namespace
+
 void Image::init(
     Device &device,
     u32 width,
@@ -25,6 +73,7 @@ void Image::init(
     m_mipLevels = mipLevels;
     m_samples = samples;
     m_aspectFlags = aspectFlags;
+    m_usage = usage;
 
     createImage(
         width,
@@ -50,6 +99,19 @@ void Image::init(
     VkImageAspectFlags aspectFlags
 )
 {
+    const std::string ktx2Extension = ".ktx2";
+    if (
+        filepath.size() >= ktx2Extension.size() &&
+        filepath.compare(
+            filepath.size() - ktx2Extension.size(),
+            ktx2Extension.size(),
+            ktx2Extension
+        ) == 0
+    ) {
+        initKtx2(device, filepath, additionalUsage, mipmaps, aspectFlags);
+        return;
+    }
+
     int width, height, channels;
     stbi_uc *pixels = stbi_load(
         filepath.c_str(),
@@ -63,6 +125,35 @@ void Image::init(
         throw std::runtime_error("Failed to load image file: " + filepath);
     }
 
+    bool srgb = false;
+    if (
+        mipmaps &&
+        !device.isFormatSupported(format, LINEAR_BLIT_FEATURES) &&
+        !device.getDownsampler().isSupported(format, width, height) &&
+        isCpuFilterable(format, srgb)
+    ) {
+        texture::MipChain chain = texture::generateMipChain(
+            pixels,
+            static_cast<u32>(width),
+            static_cast<u32>(height),
+            { .srgb = srgb }
+        );
+
+        stbi_image_free(pixels);
+
+        init(
+            device,
+            chain.data.data(),
+            static_cast<u32>(width),
+            static_cast<u32>(height),
+            static_cast<u32>(chain.levels.size()),
+            format,
+            additionalUsage,
+            aspectFlags
+        );
+        return;
+    }
+
     VkDeviceSize imageSize = width * height * 4;
 
     u32 mipLevels = 1;
@@ -71,23 +162,11 @@ void Image::init(
         mipLevels = static_cast<u32>(std::floor(std::log2(max))) + 1;
     }
 
-    Buffer stagingBuffer;
-    stagingBuffer.init(
-        device,
-        imageSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VMA_MEMORY_USAGE_CPU_TO_GPU
-    );
-
-    stagingBuffer.uploadData(pixels, imageSize);
-
-    stbi_image_free(pixels);
-
     VkImageUsageFlags usage = 
         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 
     if (mipmaps) {
-        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        usage |= getMipmapUsage(device, format, width, height);
     }
     
     usage |= additionalUsage;
@@ -112,7 +191,13 @@ void Image::init(
         VK_PIPELINE_STAGE_TRANSFER_BIT
     );
 
-    copyFromBuffer(stagingBuffer);
+    // Staged after the transition, whose submit would otherwise claim it.
+    StagingAllocation staging = device.getStagingPool().allocate(imageSize);
+    memcpy(staging.data, pixels, imageSize);
+
+    stbi_image_free(pixels);
+
+    copyFromBuffer(staging.buffer, staging.offset);
 
     if (mipmaps) {
         generateMipmaps();
@@ -125,7 +210,7 @@ void Image::init(
         );
     }
 
-    stagingBuffer.destroy();
+    createImageView(m_aspectFlags);
 }
 
 void Image::init(
@@ -139,7 +224,49 @@ void Image::init(
     VkImageAspectFlags aspectFlags
 )
 {
-    VkDeviceSize imageSize = width * height * 4;
+    if (mipmaps && vk::isBlockCompressed(format)) {
+        throw std::invalid_argument(
+            "Block compressed images need precomputed mip levels."
+        );
+    }
+
+    if (!device.isFormatSupported(
+        format,
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT
+    )) {
+        throw std::runtime_error(
+            "Image format is not supported for sampling: " + std::to_string(format)
+        );
+    }
+
+    bool srgb = false;
+    if (
+        mipmaps &&
+        !device.isFormatSupported(format, LINEAR_BLIT_FEATURES) &&
+        !device.getDownsampler().isSupported(format, width, height) &&
+        isCpuFilterable(format, srgb)
+    ) {
+        texture::MipChain chain = texture::generateMipChain(
+            static_cast<const u8 *>(data),
+            width,
+            height,
+            { .srgb = srgb }
+        );
+
+        init(
+            device,
+            chain.data.data(),
+            width,
+            height,
+            static_cast<u32>(chain.levels.size()),
+            format,
+            additionalUsage,
+            aspectFlags
+        );
+        return;
+    }
+
+    VkDeviceSize imageSize = vk::getImageSize(format, width, height);
 
     u32 mipLevels = 1;
     if (mipmaps) {
@@ -147,23 +274,11 @@ void Image::init(
         mipLevels = static_cast<u32>(std::floor(std::log2(max))) + 1;
     }
 
-    Buffer stagingBuffer;
-    stagingBuffer.init(
-        device,
-        imageSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VMA_MEMORY_USAGE_CPU_TO_GPU
-    );
-
-    void *mappedData = stagingBuffer.map();
-    memcpy(mappedData, data, imageSize);
-    stagingBuffer.unmap();
-
     VkImageUsageFlags usage = 
         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 
     if (mipmaps) {
-        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        usage |= getMipmapUsage(device, format, width, height);
     }
 
     usage |= additionalUsage;
@@ -188,7 +303,10 @@ void Image::init(
         VK_PIPELINE_STAGE_TRANSFER_BIT
     );
 
-    copyFromBuffer(stagingBuffer);
+    StagingAllocation staging = device.getStagingPool().allocate(imageSize);
+    memcpy(staging.data, data, imageSize);
+
+    copyFromBuffer(staging.buffer, staging.offset);
 
     if (mipmaps) {
         generateMipmaps();
@@ -202,8 +320,129 @@ void Image::init(
     }
 
     createImageView(m_aspectFlags);
+}
+
+void Image::init(
+    Device &device,
+    const void *data,
+    u32 width,
+    u32 height,
+    u32 mipLevels,
+    VkFormat format,
+    VkImageUsageFlags additionalUsage,
+    VkImageAspectFlags aspectFlags
+)
+{
+    if (!device.isFormatSupported(
+        format,
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT
+    )) {
+        throw std::runtime_error(
+            "Image format is not supported for sampling: " + std::to_string(format)
+        );
+    }
+
+    init(
+        device,
+        width,
+        height,
+        format,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | additionalUsage,
+        aspectFlags,
+        mipLevels,
+        VK_SAMPLE_COUNT_1_BIT,
+        VMA_MEMORY_USAGE_AUTO,
+        false
+    );
+
+    VkDeviceSize imageSize = 0;
+    for (u32 level = 0; level < mipLevels; level++) {
+        imageSize += getLevelSize(level) * m_arrayLayers;
+    }
+
+    transitionLayout(
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT
+    );
+
+    StagingAllocation staging = device.getStagingPool().allocate(imageSize);
+    memcpy(staging.data, data, imageSize);
+
+    copyFromBuffer(staging.buffer, staging.offset, mipLevels);
+
+    transitionLayout(
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+    );
+
+    createImageView(m_aspectFlags);
+}
+
+void Image::initSparse(
+    Device &device,
+    u32 width,
+    u32 height,
+    u32 mipLevels,
+    VkFormat format,
+    VkImageUsageFlags usage
+)
+{
+    m_sparse = true;
+
+    init(
+        device,
+        width,
+        height,
+        format,
+        usage,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        mipLevels
+    );
+}
+
+void Image::initAliased(
+    Device &device,
+    u32 width,
+    u32 height,
+    VkFormat format,
+    VkImageUsageFlags usage,
+    VkImageAspectFlags aspectFlags,
+    VkSampleCountFlagBits samples
+)
+{
+    m_aliased = true;
+
+    init(
+        device,
+        width,
+        height,
+        format,
+        usage,
+        aspectFlags,
+        1,
+        samples,
+        VMA_MEMORY_USAGE_AUTO,
+        false
+    );
+}
+
+void Image::bindMemory(VmaAllocation allocation, VkDeviceSize offset)
+{
+    VkResult res = vmaBindImageMemory2(
+        m_device->getAllocator(),
+        allocation,
+        offset,
+        m_image,
+        nullptr
+    );
+
+    vk::check(res, "Failed to bind image memory!");
 
-    stagingBuffer.destroy();
+    m_imageView = createView(m_format, m_aspectFlags);
 }
 
 void Image::destroy()
@@ -212,11 +451,27 @@ void Image::destroy()
         vkDestroyImageView(m_device->getDevice(), m_imageView, nullptr);
     }
 
-    if (m_image) {
+    if (m_image && (m_sparse || m_aliased)) {
+        vkDestroyImage(m_device->getDevice(), m_image, nullptr);
+    } else if (m_image) {
+        m_device->getMemoryBudget().untrack(m_allocation);
         vmaDestroyImage(m_device->getAllocator(), m_image, m_allocation);
     }
 }
 
+void Image::deferDestroy()
+{
+    if (!m_image) {
+        return;
+    }
+
+    m_device->deferDestroy([image = *this]() mutable {
+        image.destroy();
+    });
+
+    *this = Image{};
+}
+
 VkImageView Image::createView(
     VkFormat format,
     VkImageAspectFlags aspectFlags,
@@ -227,13 +482,13 @@ VkImageView Image::createView(
     VkImageViewCreateInfo viewInfo = {};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = m_image;
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.viewType = m_viewType;
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = aspectFlags;
     viewInfo.subresourceRange.baseMipLevel = baseMipLevel;
     viewInfo.subresourceRange.levelCount = levelCount;
     viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
+    viewInfo.subresourceRange.layerCount = m_arrayLayers;
 
     VkImageView imageView;
     if (vkCreateImageView(m_device->getDevice(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
@@ -263,7 +518,7 @@ void Image::transitionLayout(
     barrier.subresourceRange.baseMipLevel = 0;
     barrier.subresourceRange.levelCount = m_mipLevels;
     barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
+    barrier.subresourceRange.layerCount = m_arrayLayers;
 
     if (
         oldLayout == VK_IMAGE_LAYOUT_UNDEFINED &&
@@ -304,16 +559,55 @@ void Image::transitionLayout(
     m_layout = newLayout;
 }
 
+void Image::transitionLayout(
+    VkCommandBuffer cmd,
+    VkImageLayout newLayout,
+    VkPipelineStageFlags2 srcStageMask,
+    VkPipelineStageFlags2 dstStageMask
+)
+{
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = srcStageMask;
+    barrier.srcAccessMask = m_layout == VK_IMAGE_LAYOUT_UNDEFINED
+        ? VK_ACCESS_2_NONE
+        : VK_ACCESS_2_MEMORY_WRITE_BIT;
+    barrier.dstStageMask = dstStageMask;
+    barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+    barrier.oldLayout = m_layout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = m_image;
+    barrier.subresourceRange.aspectMask = m_aspectFlags;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = m_mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = m_arrayLayers;
+
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.imageMemoryBarrierCount = 1;
+    dependencyInfo.pImageMemoryBarriers = &barrier;
+
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+
+    m_layout = newLayout;
+}
+
 void Image::generateMipmaps()
 {
-    VkFormatProperties formatProperties;
-    vkGetPhysicalDeviceFormatProperties(
-        m_device->getPhysicalDevice(),
-        m_format,
-        &formatProperties
-    );
+    if (vk::isBlockCompressed(m_format)) {
+        throw std::runtime_error("Block compressed images cannot be blitted!");
+    }
 
-    if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
+    Downsampler &downsampler = m_device->getDownsampler();
+    if (downsampler.isSupported(*this)) {
+        downsampler.generate(*this);
+        return;
+    }
+
+    if (!m_device->isFormatSupported(m_format, LINEAR_BLIT_FEATURES)) {
         throw std::runtime_error("Texture image format does not support linear blitting!");
     }
 
@@ -326,7 +620,7 @@ void Image::generateMipmaps()
     barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.subresourceRange.aspectMask = m_aspectFlags;
     barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
+    barrier.subresourceRange.layerCount = m_arrayLayers;
     barrier.subresourceRange.levelCount = 1;
 
     int mipWidth = static_cast<int>(m_width);
@@ -371,13 +665,13 @@ void Image::generateMipmaps()
         blit.srcSubresource.aspectMask = m_aspectFlags;
         blit.srcSubresource.mipLevel = i - 1;
         blit.srcSubresource.baseArrayLayer = 0;
-        blit.srcSubresource.layerCount = 1;
+        blit.srcSubresource.layerCount = m_arrayLayers;
         blit.dstOffsets[0] = { 0, 0, 0 };
         blit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
         blit.dstSubresource.aspectMask = m_aspectFlags;
         blit.dstSubresource.mipLevel = i;
         blit.dstSubresource.baseArrayLayer = 0;
-        blit.dstSubresource.layerCount = 1;
+        blit.dstSubresource.layerCount = m_arrayLayers;
 
         vkCmdBlitImage(
             commandBuffer,
@@ -466,31 +760,58 @@ void Image::generateMipmaps()
     m_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 }
 
-void Image::copyFromBuffer(Buffer &buffer)
+void Image::copyFromBuffer(VkBuffer buffer, VkDeviceSize offset, u32 mipLevels)
 {
     VkCommandBuffer commandBuffer = m_device->beginSingleTimeCommands();
+    copyFromBuffer(commandBuffer, buffer, offset, mipLevels);
+    m_device->endSingleTimeCommands(commandBuffer);
+}
 
-    VkBufferImageCopy region = {};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-    region.imageSubresource.aspectMask = m_aspectFlags;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-    region.imageOffset = { 0, 0, 0 };
-    region.imageExtent = { m_width, m_height, 1 };
+void Image::copyFromBuffer(
+    VkCommandBuffer cmd,
+    VkBuffer buffer,
+    VkDeviceSize offset,
+    u32 mipLevels
+)
+{
+    std::vector<VkBufferImageCopy> regions(mipLevels);
+
+    for (u32 level = 0; level < mipLevels; level++) {
+        VkBufferImageCopy &region = regions[level];
+        region.bufferOffset = offset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = m_aspectFlags;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = m_arrayLayers;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = {
+            std::max(m_width >> level, 1u),
+            std::max(m_height >> level, 1u),
+            1
+        };
+
+        offset += getLevelSize(level) * m_arrayLayers;
+    }
 
     vkCmdCopyBufferToImage(
-        commandBuffer,
-        buffer.getBuffer(),
+        cmd,
+        buffer,
         m_image,
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        1,
-        &region
+        static_cast<u32>(regions.size()),
+        regions.data()
     );
+}
 
-    m_device->endSingleTimeCommands(commandBuffer);
+VkDeviceSize Image::getLevelSize(u32 level) const
+{
+    return vk::getImageSize(
+        m_format,
+        std::max(m_width >> level, 1u),
+        std::max(m_height >> level, 1u)
+    );
 }
 
 void Image::createImage(
@@ -510,7 +831,7 @@ void Image::createImage(
     imageInfo.extent.height = height;
     imageInfo.extent.depth = 1;
     imageInfo.mipLevels = mipLevels;
-    imageInfo.arrayLayers = 1;
+    imageInfo.arrayLayers = m_arrayLayers;
     imageInfo.format = format;
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -518,6 +839,53 @@ void Image::createImage(
     imageInfo.samples = samples;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    if (
+        m_viewType == VK_IMAGE_VIEW_TYPE_CUBE ||
+        m_viewType == VK_IMAGE_VIEW_TYPE_CUBE_ARRAY
+    ) {
+        imageInfo.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+    }
+
+    // sRGB formats get storage usage through a UNORM view.
+    if (
+        (usage & VK_IMAGE_USAGE_STORAGE_BIT) &&
+        !m_device->isFormatSupported(format, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)
+    ) {
+        imageInfo.flags |=
+            VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT |
+            VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+    }
+
+    m_createFlags = imageInfo.flags;
+
+    if (m_sparse) {
+        imageInfo.flags |=
+            VK_IMAGE_CREATE_SPARSE_BINDING_BIT |
+            VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
+
+        VkResult res = vkCreateImage(
+            m_device->getDevice(),
+            &imageInfo,
+            nullptr,
+            &m_image
+        );
+
+        vk::check(res, "Failed to create sparse image!");
+        return;
+    }
+
+    if (m_aliased) {
+        VkResult res = vkCreateImage(
+            m_device->getDevice(),
+            &imageInfo,
+            nullptr,
+            &m_image
+        );
+
+        vk::check(res, "Failed to create aliased image!");
+        return;
+    }
+
     VmaAllocationCreateInfo allocInfo = {};
     allocInfo.usage = memoryUsage;
 
@@ -531,6 +899,166 @@ void Image::createImage(
     ) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create image!");
     }
+
+    m_device->getMemoryBudget().track(m_allocation, MemoryBudget::getImageCategory(usage));
+}
+
+void Image::initKtx2(
+    Device &device,
+    const std::string &filepath,
+    VkImageUsageFlags additionalUsage,
+    bool mipmaps,
+    VkImageAspectFlags aspectFlags
+)
+{
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to load image file: " + filepath);
+    }
+
+    texture::Ktx2Header header = texture::readKtx2Header(file);
+
+    VkFormat format = static_cast<VkFormat>(header.vkFormat);
+    if (format == VK_FORMAT_UNDEFINED) {
+        throw std::runtime_error("Basis Universal KTX2 files are not supported: " + filepath);
+    }
+
+    if (header.depth > 1) {
+        throw std::runtime_error("3D KTX2 textures are not supported: " + filepath);
+    }
+
+    u32 layers = std::max(header.layerCount, 1u);
+    if (header.faceCount == 6) {
+        m_viewType = header.layerCount > 0
+            ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY
+            : VK_IMAGE_VIEW_TYPE_CUBE;
+    } else {
+        m_viewType = header.layerCount > 0
+            ? VK_IMAGE_VIEW_TYPE_2D_ARRAY
+            : VK_IMAGE_VIEW_TYPE_2D;
+    }
+    m_arrayLayers = layers * header.faceCount;
+
+    u32 width = header.width;
+    u32 height = std::max(header.height, 1u);
+
+    // A level count of 0 asks the loader to build the chain.
+    u32 storedLevels = static_cast<u32>(header.levels.size());
+    bool generate = header.levelCount == 0 && mipmaps;
+    u32 mipLevels = generate ? texture::getMipLevelCount(width, height) : storedLevels;
+
+    if (!device.isFormatSupported(
+        format,
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT
+    )) {
+        throw std::runtime_error(
+            "Image format is not supported for sampling: " + std::to_string(format)
+        );
+    }
+
+    VkImageUsageFlags usage =
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    if (generate) {
+        usage |= getMipmapUsage(device, format, width, height);
+    }
+
+    usage |= additionalUsage;
+
+    init(
+        device,
+        width,
+        height,
+        format,
+        usage,
+        aspectFlags,
+        mipLevels,
+        VK_SAMPLE_COUNT_1_BIT,
+        VMA_MEMORY_USAGE_AUTO,
+        false
+    );
+
+    // Staging holds the levels largest first as copyFromBuffer expects,
+    // while the file stores them smallest first.
+    std::vector<VkDeviceSize> offsets(storedLevels);
+    VkDeviceSize stagingSize = 0;
+
+    for (u32 level = 0; level < storedLevels; level++) {
+        VkDeviceSize size = getLevelSize(level) * m_arrayLayers;
+        if (header.levels[level].uncompressedByteLength != size) {
+            throw std::runtime_error("Invalid KTX2 level size: " + filepath);
+        }
+
+        offsets[level] = stagingSize;
+        stagingSize += size;
+    }
+
+    transitionLayout(
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT
+    );
+
+    StagingAllocation stagingAllocation = device.getStagingPool().allocate(stagingSize);
+    u8 *staging = stagingAllocation.data;
+
+    // Raw levels are read straight into the staging buffer; supercompressed
+    // ones are read first and decoded into it in parallel.
+    if (header.supercompression == texture::Supercompression::None) {
+        for (u32 level = 0; level < storedLevels; level++) {
+            file.seekg(static_cast<std::streamoff>(header.levels[level].byteOffset));
+            file.read(
+                reinterpret_cast<char *>(staging + offsets[level]),
+                static_cast<std::streamsize>(header.levels[level].byteLength)
+            );
+        }
+    } else {
+        std::vector<std::vector<u8>> compressed(storedLevels);
+        std::vector<texture::DecodeJob> jobs(storedLevels);
+
+        for (u32 level = 0; level < storedLevels; level++) {
+            const texture::Ktx2Level &source = header.levels[level];
+            compressed[level].resize(source.byteLength);
+
+            file.seekg(static_cast<std::streamoff>(source.byteOffset));
+            file.read(
+                reinterpret_cast<char *>(compressed[level].data()),
+                static_cast<std::streamsize>(source.byteLength)
+            );
+
+            jobs[level] = {
+                .src = compressed[level].data(),
+                .srcSize = compressed[level].size(),
+                .dst = staging + offsets[level],
+                .dstSize = source.uncompressedByteLength
+            };
+        }
+
+        if (file) {
+            texture::decodeSupercompressed(header.supercompression, jobs);
+        }
+    }
+
+    // The region is released with the next submit either way.
+    if (!file) {
+        throw std::runtime_error("KTX2 file is truncated: " + filepath);
+    }
+
+    copyFromBuffer(stagingAllocation.buffer, stagingAllocation.offset, storedLevels);
+
+    if (generate) {
+        generateMipmaps();
+    } else {
+        transitionLayout(
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+        );
+    }
+
+    createImageView(m_aspectFlags);
 }
 
 void Image::createImageView(VkImageAspectFlags aspectFlags)
@@ -538,13 +1066,13 @@ void Image::createImageView(VkImageAspectFlags aspectFlags)
     VkImageViewCreateInfo viewInfo = {};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = m_image;
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.viewType = m_viewType;
     viewInfo.format = m_format;
     viewInfo.subresourceRange.aspectMask = aspectFlags;
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.levelCount = m_mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
+    viewInfo.subresourceRange.layerCount = m_arrayLayers;
 
     VkResult res = vkCreateImageView(
         m_device->getDevice(),
@@ -3,6 +3,8 @@
 #include <vulkan/vulkan.h>
 #include <vk_mem_alloc.h>
 
+#include <vector>
+
 #include "core/types.hpp"
 #include "buffer.hpp"
 
@@ -31,6 +33,8 @@ public:
         bool imageView = true
     );
 
+    // `.ktx2` files upload their stored levels, layers and cube faces as
+    // is; `format` only applies to other files.
     void init(
         Device &device,
         const std::string &filepath,
@@ -51,8 +55,51 @@ public:
         VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT
     );
 
+    // `data` holds `mipLevels` tightly packed levels, largest first. Used
+    // for block compressed formats, which cannot be blitted.
+    void init(
+        Device &device,
+        const void *data,
+        u32 width,
+        u32 height,
+        u32 mipLevels,
+        VkFormat format,
+        VkImageUsageFlags additionalUsage = 0,
+        VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT
+    );
+
+    // Sparse residency image without any memory bound; the owner binds
+    // tiles and the mip tail with vkQueueBindSparse. Starts in the
+    // undefined layout.
+    void initSparse(
+        Device &device,
+        u32 width,
+        u32 height,
+        u32 mipLevels,
+        VkFormat format,
+        VkImageUsageFlags usage
+    );
+
+    // Image without memory, for render targets that share memory with
+    // others never in use at the same time. bindMemory() binds it and
+    // creates the view; the memory stays with the caller.
+    void initAliased(
+        Device &device,
+        u32 width,
+        u32 height,
+        VkFormat format,
+        VkImageUsageFlags usage,
+        VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT,
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT
+    );
+
+    void bindMemory(VmaAllocation allocation, VkDeviceSize offset);
+
     void destroy();
 
+    // destroy() once the frames in flight are done with the image.
+    void deferDestroy();
+
     VkImageView createView(
         VkFormat format,
         VkImageAspectFlags aspectFlags,
@@ -67,9 +114,32 @@ public:
         VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT
     );
 
+    // Records into `cmd` instead of waiting on a single time command
+    // buffer; the old layout is the tracked one.
+    void transitionLayout(
+        VkCommandBuffer cmd,
+        VkImageLayout newLayout,
+        VkPipelineStageFlags2 srcStageMask,
+        VkPipelineStageFlags2 dstStageMask
+    );
+
+    // One compute dispatch when the image has storage usage and the
+    // downsampler supports it, a blit per level otherwise.
     void generateMipmaps();
 
-    void copyFromBuffer(Buffer &buffer);
+    // Copies the first `mipLevels` levels, tightly packed in `buffer` with
+    // all array layers of a level next to each other.
+    // `offset` is where the packed levels start in `buffer`.
+    void copyFromBuffer(VkBuffer buffer, VkDeviceSize offset, u32 mipLevels = 1);
+    void copyFromBuffer(
+        VkCommandBuffer cmd,
+        VkBuffer buffer,
+        VkDeviceSize offset,
+        u32 mipLevels = 1
+    );
+
+    // Size of one array layer of `level`.
+    VkDeviceSize getLevelSize(u32 level) const;
 
 public:
     VkImage getImage() const { return m_image; }
@@ -82,10 +152,18 @@ public:
     u32 getWidth() const { return m_width; }
     u32 getHeight() const { return m_height; }
     u32 getMipLevels() const { return m_mipLevels; }
+    u32 getArrayLayers() const { return m_arrayLayers; }
+    VkImageViewType getViewType() const { return m_viewType; }
     VkSampleCountFlagBits getSamples() const { return m_samples; }
     VkImageAspectFlags getAspectFlags() const { return m_aspectFlags; }
+    VkImageUsageFlags getUsage() const { return m_usage; }
+    bool isSparse() const { return m_sparse; }
+    bool isAliased() const { return m_aliased; }
 
 private:
+    friend class Downsampler;
+    friend class Defragmenter;
+
     Device *m_device = nullptr;
 
     VkImage m_image = VK_NULL_HANDLE;
@@ -98,8 +176,14 @@ private:
     u32 m_width = 0;
     u32 m_height = 0;
     u32 m_mipLevels = 1;
+    u32 m_arrayLayers = 1;
+    VkImageViewType m_viewType = VK_IMAGE_VIEW_TYPE_2D;
     VkSampleCountFlagBits m_samples = VK_SAMPLE_COUNT_1_BIT;
     VkImageAspectFlags m_aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
+    VkImageUsageFlags m_usage = 0;
+    VkImageCreateFlags m_createFlags = 0;
+    bool m_sparse = false;
+    bool m_aliased = false;
 
     void createImage(
         u32 width,
@@ -113,6 +197,14 @@ private:
 
     void createImageView(VkImageAspectFlags aspectFlags);
 
+    void initKtx2(
+        Device &device,
+        const std::string &filepath,
+        VkImageUsageFlags additionalUsage,
+        bool mipmaps,
+        VkImageAspectFlags aspectFlags
+    );
+
 };
 
 } // namespace gfx
\ No newline at end of file
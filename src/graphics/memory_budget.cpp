@@ -0,0 +1,195 @@
+#include "memory_budget.hpp"
+#include "device.hpp"
+
+#include <algorithm>
+
+namespace gfx
+{
+
+void MemoryBudget::init(Device &device, f32 pressureThreshold)
+{
+    m_device = &device;
+    m_pressureThreshold = pressureThreshold;
+
+    update();
+}
+
+void MemoryBudget::destroy()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_callbacks.clear();
+}
+
+void MemoryBudget::update()
+{
+    // Budgets are refetched from VK_EXT_memory_budget when the frame
+    // index changes.
+    vmaSetCurrentFrameIndex(m_device->getAllocator(), ++m_frame);
+
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(m_device->getAllocator(), budgets);
+
+    const VkPhysicalDeviceMemoryProperties *properties = nullptr;
+    vmaGetMemoryProperties(m_device->getAllocator(), &properties);
+
+    MemoryPressure deviceLocal;
+    for (u32 i = 0; i < properties->memoryHeapCount; i++) {
+        if (properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            deviceLocal.usage += budgets[i].usage;
+            deviceLocal.budget += budgets[i].budget;
+        }
+    }
+
+    VkDeviceSize limit = static_cast<VkDeviceSize>(
+        static_cast<f64>(deviceLocal.budget) * m_pressureThreshold
+    );
+
+    if (deviceLocal.usage > limit) {
+        deviceLocal.excess = deviceLocal.usage - limit;
+    }
+
+    m_deviceLocal = deviceLocal;
+
+    if (!isUnderPressure()) {
+        return;
+    }
+
+    // Copied so callbacks may unregister themselves.
+    std::vector<std::pair<u32, PressureCallback>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        callbacks = m_callbacks;
+    }
+
+    for (auto &[id, callback] : callbacks) {
+        callback(m_deviceLocal);
+    }
+}
+
+void MemoryBudget::track(VmaAllocation allocation, Category category)
+{
+    // Stored off by one, so untagged allocations read as null.
+    vmaSetAllocationUserData(
+        m_device->getAllocator(),
+        allocation,
+        reinterpret_cast<void *>(static_cast<uintptr_t>(category) + 1)
+    );
+
+    VmaAllocationInfo info{};
+    vmaGetAllocationInfo(m_device->getAllocator(), allocation, &info);
+
+    usize index = static_cast<usize>(category);
+    m_categoryBytes[index] += info.size;
+    m_categoryCounts[index]++;
+}
+
+void MemoryBudget::untrack(VmaAllocation allocation)
+{
+    if (!allocation) {
+        return;
+    }
+
+    VmaAllocationInfo info{};
+    vmaGetAllocationInfo(m_device->getAllocator(), allocation, &info);
+
+    if (!info.pUserData) {
+        return;
+    }
+
+    usize index = reinterpret_cast<uintptr_t>(info.pUserData) - 1;
+    m_categoryBytes[index] -= info.size;
+    m_categoryCounts[index]--;
+
+    vmaSetAllocationUserData(m_device->getAllocator(), allocation, nullptr);
+}
+
+u32 MemoryBudget::addPressureCallback(PressureCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    u32 id = m_nextCallbackID++;
+    m_callbacks.push_back({ id, std::move(callback) });
+
+    return id;
+}
+
+void MemoryBudget::removePressureCallback(u32 id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto isRemoved = [id](const auto &entry) {
+        return entry.first == id;
+    };
+
+    m_callbacks.erase(
+        std::remove_if(m_callbacks.begin(), m_callbacks.end(), isRemoved),
+        m_callbacks.end()
+    );
+}
+
+MemoryStats MemoryBudget::getStats() const
+{
+    VmaTotalStatistics total{};
+    vmaCalculateStatistics(m_device->getAllocator(), &total);
+
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(m_device->getAllocator(), budgets);
+
+    const VkPhysicalDeviceMemoryProperties *properties = nullptr;
+    vmaGetMemoryProperties(m_device->getAllocator(), &properties);
+
+    MemoryStats stats;
+    stats.heaps.resize(properties->memoryHeapCount);
+
+    for (u32 i = 0; i < properties->memoryHeapCount; i++) {
+        const VmaStatistics &heap = total.memoryHeap[i].statistics;
+
+        MemoryStats::Heap &entry = stats.heaps[i];
+        entry.usage = budgets[i].usage;
+        entry.budget = budgets[i].budget;
+        entry.blockBytes = heap.blockBytes;
+        entry.allocationBytes = heap.allocationBytes;
+        entry.blockCount = heap.blockCount;
+        entry.allocationCount = heap.allocationCount;
+        entry.isDeviceLocal =
+            properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+    }
+
+    for (usize i = 0; i < MEMORY_CATEGORY_COUNT; i++) {
+        stats.categoryBytes[i] = m_categoryBytes[i];
+        stats.categoryCounts[i] = m_categoryCounts[i];
+    }
+
+    stats.deviceLocal = m_deviceLocal;
+
+    return stats;
+}
+
+MemoryBudget::Category MemoryBudget::getBufferCategory(VkBufferUsageFlags usage)
+{
+    if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
+        return Category::Geometry;
+    }
+
+    if (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT) {
+        return Category::Staging;
+    }
+
+    return Category::Other;
+}
+
+MemoryBudget::Category MemoryBudget::getImageCategory(VkImageUsageFlags usage)
+{
+    VkImageUsageFlags attachment =
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+        VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+    if (usage & attachment) {
+        return Category::RenderTarget;
+    }
+
+    return Category::Texture;
+}
+
+} // namespace gfx
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "core/types.hpp"
+
+namespace gfx
+{
+
+class Device;
+
+static constexpr usize MEMORY_CATEGORY_COUNT = 5;
+
+// Device local heaps at the last MemoryBudget::update().
+struct MemoryPressure
+{
+    VkDeviceSize usage = 0;
+    VkDeviceSize budget = 0;
+
+    // Bytes to release to get back under the pressure threshold.
+    VkDeviceSize excess = 0;
+};
+
+struct MemoryStats
+{
+    struct Heap
+    {
+        VkDeviceSize usage = 0;
+        VkDeviceSize budget = 0;
+
+        // Memory VMA holds in blocks and the part of it allocations use.
+        VkDeviceSize blockBytes = 0;
+        VkDeviceSize allocationBytes = 0;
+
+        u32 blockCount = 0;
+        u32 allocationCount = 0;
+        bool isDeviceLocal = false;
+    };
+
+    std::vector<Heap> heaps;
+
+    // Indexed by MemoryBudget::Category.
+    std::array<VkDeviceSize, MEMORY_CATEGORY_COUNT> categoryBytes{};
+    std::array<u32, MEMORY_CATEGORY_COUNT> categoryCounts{};
+
+    MemoryPressure deviceLocal;
+};
+
+// Tracks VMA heap budgets and what the engine's allocations are used for.
+// Systems that can give memory back register a pressure callback, which
+// fires every update while device local usage is above the threshold.
+class MemoryBudget
+{
+
+public:
+    enum class Category
+    {
+        Texture,
+        Geometry,
+        RenderTarget,
+        Staging,
+        Other
+    };
+
+    using PressureCallback = std::function<void(const MemoryPressure &pressure)>;
+
+    MemoryBudget() = default;
+    ~MemoryBudget() = default;
+
+    // `pressureThreshold` is the share of the device local budget above
+    // which callbacks fire.
+    void init(Device &device, f32 pressureThreshold = 0.9f);
+    void destroy();
+
+    // Refreshes the heap budgets; called by Device::beginFrame.
+    void update();
+
+    // Tags `allocation` with `category` through its VMA user data and
+    // counts its size; untrack() before freeing it.
+    void track(VmaAllocation allocation, Category category);
+    void untrack(VmaAllocation allocation);
+
+    u32 addPressureCallback(PressureCallback callback);
+    void removePressureCallback(u32 id);
+
+    // Walks every VMA block; meant for telemetry, not every frame.
+    MemoryStats getStats() const;
+
+    static Category getBufferCategory(VkBufferUsageFlags usage);
+    static Category getImageCategory(VkImageUsageFlags usage);
+
+public:
+    const MemoryPressure &getDeviceLocal() const { return m_deviceLocal; }
+    bool isUnderPressure() const { return m_deviceLocal.excess > 0; }
+
+    // Device local budget not in use yet.
+    VkDeviceSize getAvailableBytes() const
+    {
+        return m_deviceLocal.budget > m_deviceLocal.usage
+            ? m_deviceLocal.budget - m_deviceLocal.usage
+            : 0;
+    }
+
+    VkDeviceSize getCategoryBytes(Category category) const
+    {
+        return m_categoryBytes[static_cast<usize>(category)];
+    }
+
+private:
+    Device *m_device = nullptr;
+    f32 m_pressureThreshold = 0.9f;
+    u32 m_frame = 0;
+
+    MemoryPressure m_deviceLocal;
+
+    // Allocations are made from loader and streaming code alike.
+    std::array<std::atomic<VkDeviceSize>, MEMORY_CATEGORY_COUNT> m_categoryBytes{};
+    std::array<std::atomic<u32>, MEMORY_CATEGORY_COUNT> m_categoryCounts{};
+
+    std::vector<std::pair<u32, PressureCallback>> m_callbacks;
+    u32 m_nextCallbackID = 0;
+    std::mutex m_mutex;
+
+};
+
+} // namespace gfx
\ No newline at end of file
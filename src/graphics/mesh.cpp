@@ -3,23 +3,58 @@
 namespace gfx
 {
 
+static constexpr u32 MESHLET_TASK_GROUP_SIZE = 32;
+static constexpr u32 MESHLET_HEADER_WORDS = 12;
+
 void Mesh::init(
     Device& device,
     const std::vector<Vertex>& vertices,
-    const std::vector<u32>& indices)
+    const std::vector<u32>& indices,
+    const std::vector<Lod>& lods)
+{
+    m_vertexFormat = VertexFormat::Float;
+    initBuffers(device, vertices, indices, lods);
+}
+
+void Mesh::init(
+    Device& device,
+    const std::vector<PackedVertex>& vertices,
+    const std::vector<u32>& indices,
+    const std::vector<Lod>& lods)
+{
+    m_vertexFormat = VertexFormat::Packed;
+    initBuffers(device, vertices, indices, lods);
+}
+
+template<typename V>
+void Mesh::initBuffers(
+    Device& device,
+    const std::vector<V>& vertices,
+    const std::vector<u32>& indices,
+    const std::vector<Lod>& lods)
 {
     m_device = &device;
     m_vertexCount = static_cast<u32>(vertices.size());
     m_indexCount = static_cast<u32>(indices.size());
 
-    VkDeviceSize vertexBufferSize = sizeof(Vertex) * vertices.size();
-VkDeviceSize indexBufferSize = sizeof(u32) * indices.size();
+    m_lods = lods;
+    if (m_lods.empty()) {
+        m_lods.push_back({ 0, m_indexCount, 0.0f });
+    }
 
+    VkDeviceSize vertexBufferSize = sizeof(V) * vertices.size();
+
+    // Storage usage lets the mesh shading path fetch vertices directly,
+    // the device address lets vertex pulling do the same. Transfer source
+    // usage lets the defragmenter copy it.
     m_vertexBuffer.init(
         device,
         vertexBufferSize,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VMA_MEMORY_USAGE_CPU_TO_GPU
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+        VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
     );
 
     m_vertexBuffer.uploadData(
@@ -27,51 +62,248 @@ VkDeviceSize indexBufferSize = sizeof(u32) * indices.size();
         m_vertexCount
     );
 
-    if (m_indexCount > 0) {
-        m_indexBuffer.init(
-            device,
-            indexBufferSize,
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-            VMA_MEMORY_USAGE_CPU_TO_GPU
-        );
+    if (m_indexCount == 0) {
+        return;
+    }
 
-        m_indexBuffer.uploadData(
-            indices.data(),
-            m_indexCount
-        );
+    // Keep the largest index below the primitive restart value so the
+    // narrow formats stay valid if restart is ever enabled.
+    if (m_vertexCount <= U8_MAX && device.getFeatures().indexTypeUint8) {
+        m_indexType = VK_INDEX_TYPE_UINT8_EXT;
+        uploadIndices<u8>(indices);
+    } else if (m_vertexCount <= U16_MAX) {
+        m_indexType = VK_INDEX_TYPE_UINT16;
+        uploadIndices<u16>(indices);
+    } else {
+        m_indexType = VK_INDEX_TYPE_UINT32;
+        uploadIndices<u32>(indices);
+    }
+}
+
+template<typename T>
+void Mesh::uploadIndices(const std::vector<u32> &indices)
+{
+    std::vector<T> packed(indices.begin(), indices.end());
+
+    m_indexBuffer.init(
+        *m_device,
+        sizeof(T) * packed.size(),
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT
+    );
+
+    m_indexBuffer.uploadData(packed);
+}
+
+void Mesh::initMeshlets(
+    const geometry::MeshletData &data,
+    const std::vector<geometry::MeshletBounds> &bounds,
+    const glm::vec3 &positionOffset,
+    const glm::vec3 &positionScale
+)
+{
+    if (data.meshlets.empty()) {
+        return;
     }
+
+    // Layout in 32-bit words: header, meshlets, bounds, vertex indices,
+    // then one packed u8x3 triangle per word.
+    u32 meshletCount = static_cast<u32>(data.meshlets.size());
+    u32 meshletWords = meshletCount * sizeof(geometry::Meshlet) / sizeof(u32);
+    u32 boundsWords = meshletCount * sizeof(geometry::MeshletBounds) / sizeof(u32);
+    u32 vertexWords = static_cast<u32>(data.vertices.size());
+    u32 triangleWords = static_cast<u32>(data.triangles.size() / 3);
+
+    u32 boundsOffset = MESHLET_HEADER_WORDS + meshletWords;
+    u32 verticesOffset = boundsOffset + boundsWords;
+    u32 trianglesOffset = verticesOffset + vertexWords;
+
+    std::vector<u32> words(trianglesOffset + triangleWords, 0);
+
+    words[0] = meshletCount;
+    words[1] = boundsOffset;
+    words[2] = verticesOffset;
+    words[3] = trianglesOffset;
+    memcpy(&words[4], &positionOffset.x, sizeof(glm::vec3));
+    memcpy(&words[8], &positionScale.x, sizeof(glm::vec3));
+
+    memcpy(
+        &words[MESHLET_HEADER_WORDS],
+        data.meshlets.data(),
+        meshletWords * sizeof(u32)
+    );
+    memcpy(&words[boundsOffset], bounds.data(), boundsWords * sizeof(u32));
+    memcpy(&words[verticesOffset], data.vertices.data(), vertexWords * sizeof(u32));
+
+    for (u32 t = 0; t < triangleWords; t++) {
+        words[trianglesOffset + t] =
+            static_cast<u32>(data.triangles[t * 3 + 0]) |
+            static_cast<u32>(data.triangles[t * 3 + 1]) << 8 |
+            static_cast<u32>(data.triangles[t * 3 + 2]) << 16;
+    }
+
+    m_meshletBuffer.init(
+        *m_device,
+        words.size() * sizeof(u32),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT
+    );
+    m_meshletBuffer.uploadData(words);
+
+    auto &bindlessManager = m_device->getBindlessManager();
+    m_meshletBufferID = bindlessManager.addSSBO(m_meshletBuffer);
+    m_vertexBufferID = bindlessManager.addSSBO(m_vertexBuffer);
+
+    m_meshletCount = meshletCount;
 }
 
 void Mesh::destroy()
 {
+    release();
+
+    if (m_meshletCount > 0) {
+        m_meshletBuffer.destroy();
+        m_meshletCount = 0;
+    }
+
     m_vertexBuffer.destroy();
     m_indexBuffer.destroy();
 }
 
+void Mesh::deferDestroy()
+{
+    release();
+
+    if (m_meshletCount > 0) {
+        m_meshletBuffer.deferDestroy();
+        m_meshletCount = 0;
+    }
+
+    m_vertexBuffer.deferDestroy();
+    m_indexBuffer.deferDestroy();
+}
+
+void Mesh::release()
+{
+    auto &defragmenter = m_device->getDefragmenter();
+    defragmenter.removeBuffer(m_vertexBuffer);
+    defragmenter.removeBuffer(m_indexBuffer);
+    defragmenter.removeBuffer(m_meshletBuffer);
+
+    if (m_meshletCount > 0) {
+        auto &bindlessManager = m_device->getBindlessManager();
+        bindlessManager.removeResource(m_meshletBufferID);
+        bindlessManager.removeResource(m_vertexBufferID);
+    }
+}
+
+void Mesh::allowDefragmentation()
+{
+    auto &defragmenter = m_device->getDefragmenter();
+    defragmenter.addBuffer(m_vertexBuffer);
+
+    if (m_indexCount > 0) {
+        defragmenter.addBuffer(m_indexBuffer);
+    }
+
+    if (m_meshletCount > 0) {
+        defragmenter.addBuffer(m_meshletBuffer);
+    }
+}
+
 void Mesh::bind(VkCommandBuffer cmd) const
 {
     VkBuffer vertexBuffers[] = { m_vertexBuffer.getBuffer() };
     VkDeviceSize offsets[] = { 0 };
     vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
 
+    bindIndexBuffer(cmd);
+}
+
+void Mesh::bindPulled(
+    VkCommandBuffer cmd,
+    Pipeline &pipeline,
+    u32 pushOffset
+) const
+{
+    VertexPullPushConstants pc = {
+        .vertices = m_vertexBuffer.getDeviceAddress()
+    };
+
+    pipeline.push(
+        cmd,
+        VK_SHADER_STAGE_VERTEX_BIT,
+        sizeof(VertexPullPushConstants),
+        &pc,
+        pushOffset
+    );
+
+    bindIndexBuffer(cmd);
+}
+
+void Mesh::bindIndexBuffer(VkCommandBuffer cmd) const
+{
     if (m_indexCount > 0)
     {
         vkCmdBindIndexBuffer(
             cmd,
             m_indexBuffer.getBuffer(),
             0,
-            VK_INDEX_TYPE_UINT32
+            m_indexType
         );
     }
 }
 
-void Mesh::draw(VkCommandBuffer cmd) const
+void Mesh::draw(VkCommandBuffer cmd, u32 lod) const
 {
+    // The first instance carries the texture index to the vertex shader,
+    // which works with and without vertex input state.
+    u32 textureIndex = getTextureIndex();
+
     if (m_indexCount > 0) {
-        vkCmdDrawIndexed(cmd, m_indexCount, 1, 0, 0, 0);
+        const Lod &range = m_lods[std::min(lod, getLodCount() - 1)];
+        vkCmdDrawIndexed(cmd, range.indexCount, 1, range.indexOffset, 0, textureIndex);
     } else {
-        vkCmdDraw(cmd, m_vertexCount, 1, 0, 0);
+        vkCmdDraw(cmd, m_vertexCount, 1, 0, textureIndex);
+    }
+}
+
+void Mesh::drawMeshlets(
+    VkCommandBuffer cmd,
+    Pipeline &pipeline,
+    u32 pushOffset
+) const
+{
+    if (m_meshletCount == 0) {
+        return;
     }
+
+    auto &bindlessManager = m_device->getBindlessManager();
+
+    MeshletPushConstants pc = {
+        .meshletBuffer = bindlessManager.getIndex(m_meshletBufferID),
+        .vertexBuffer = bindlessManager.getIndex(m_vertexBufferID),
+        .meshletCount = m_meshletCount,
+        .textureIndex = getTextureIndex()
+    };
+
+    pipeline.push(
+        cmd,
+        VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT,
+        sizeof(MeshletPushConstants),
+        &pc,
+        pushOffset
+    );
+
+    u32 groupCount = (m_meshletCount + MESHLET_TASK_GROUP_SIZE - 1) / MESHLET_TASK_GROUP_SIZE;
+    m_device->drawMeshTasks(cmd, groupCount);
+}
+
+u32 Mesh::getTextureIndex() const
+{
+    return m_device->getBindlessManager().getIndex(m_textureID);
 }
 
 } // namespace gfx
\ No newline at end of file
@@ -8,10 +8,18 @@
 
 #include "device.hpp"
 #include "buffer.hpp"
+#include "pipeline.hpp"
+#include "geometry/meshlet.hpp"
 
 namespace gfx
 {
 
+enum class VertexFormat
+{
+    Float,
+    Packed
+};
+
 class Mesh
 {
 
@@ -55,6 +63,72 @@ public:
         }
     };
 
+    // 16 byte layout: positions are unorm16 relative to the model bounds
+    // (w is padding), normals are octahedral snorm16, UVs are half floats.
+    struct PackedVertex
+    {
+        u16 pos[4];
+        i16 normal[2];
+        u16 uv[2];
+
+        static VkVertexInputBindingDescription getBindingDescription()
+        {
+            VkVertexInputBindingDescription bindingDescription{};
+            bindingDescription.binding = 0;
+            bindingDescription.stride = sizeof(PackedVertex);
+            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+            return bindingDescription;
+        }
+
+        static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions()
+        {
+            std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+
+            attributeDescriptions[0].binding = 0;
+            attributeDescriptions[0].location = 0;
+            attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+            attributeDescriptions[0].offset = offsetof(PackedVertex, pos);
+
+            attributeDescriptions[1].binding = 0;
+            attributeDescriptions[1].location = 1;
+            attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+            attributeDescriptions[1].offset = offsetof(PackedVertex, normal);
+
+            attributeDescriptions[2].binding = 0;
+            attributeDescriptions[2].location = 2;
+            attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+            attributeDescriptions[2].offset = offsetof(PackedVertex, uv);
+
+            return attributeDescriptions;
+        }
+    };
+
+    // Index range of one detail level inside the shared index buffer.
+    // `error` is the simplification error in model space units.
+    struct Lod
+    {
+        u32 indexOffset = 0;
+        u32 indexCount = 0;
+        f32 error = 0.0f;
+    };
+
+    // Pushed after the per-draw block for the task and mesh shaders. The
+    // buffers are elements of the bindless storage buffer array.
+    struct MeshletPushConstants
+    {
+        u32 meshletBuffer = 0;
+        u32 vertexBuffer = 0;
+        u32 meshletCount = 0;
+        u32 textureIndex = 0;
+    };
+
+    // Pushed after the per-draw block for the vertex pulling shader.
+    struct VertexPullPushConstants
+    {
+        VkDeviceAddress vertices = 0;
+    };
+
     Mesh() = default;
     ~Mesh() = default;
 
@@ -67,18 +141,74 @@ public:
     void init(
         Device &device,
         const std::vector<Vertex> &vertices,
-        const std::vector<u32> &indices
+        const std::vector<u32> &indices,
+        const std::vector<Lod> &lods = {}
+    );
+
+    void init(
+        Device &device,
+        const std::vector<PackedVertex> &vertices,
+        const std::vector<u32> &indices,
+        const std::vector<Lod> &lods = {}
+    );
+
+    // Uploads meshlets of the full detail level as one storage buffer.
+    // `positionOffset` and `positionScale` dequantize packed positions.
+    void initMeshlets(
+        const geometry::MeshletData &data,
+        const std::vector<geometry::MeshletBounds> &bounds,
+        const glm::vec3 &positionOffset,
+        const glm::vec3 &positionScale
     );
 
     void destroy();
 
+    // Like destroy(), but the buffers are released once the frames in
+    // flight are done with them.
+    void deferDestroy();
+
+    // Lets the defragmenter move the buffers. Call once the mesh has its
+    // final address; destroy() removes them again.
+    void allowDefragmentation();
+
     void bind(VkCommandBuffer cmd) const;
-    void draw(VkCommandBuffer cmd) const;
+
+    // For pipelines without vertex input state: binds the index buffer
+    // and pushes the vertex buffer address at `pushOffset`.
+    void bindPulled(
+        VkCommandBuffer cmd,
+        Pipeline &pipeline,
+        u32 pushOffset
+    ) const;
+
+    void draw(VkCommandBuffer cmd, u32 lod = 0) const;
+
+    void drawMeshlets(
+        VkCommandBuffer cmd,
+        Pipeline &pipeline,
+        u32 pushOffset
+    ) const;
 
 public:
+    // Bindless texture ID sampled by the draws, read again on every draw.
     void setTextureID(u32 textureID) { m_textureID = textureID; }
     u32 getTextureID() const { return m_textureID; }
 
+    VkIndexType getIndexType() const { return m_indexType; }
+    VertexFormat getVertexFormat() const { return m_vertexFormat; }
+
+    u32 getLodCount() const { return static_cast<u32>(m_lods.size()); }
+    const Lod &getLod(u32 lod) const { return m_lods[lod]; }
+
+    bool hasMeshlets() const { return m_meshletCount > 0; }
+
+    void setBoundingSphere(const glm::vec4 &sphere) { m_boundingSphere = sphere; }
+    const glm::vec4 &getBoundingSphere() const { return m_boundingSphere; }
+
+    // Texture coordinate units per model unit, averaged over the surface.
+    void setUVDensity(f32 density) { m_uvDensity = density; }
+    f32 getUVDensity() const { return m_uvDensity; }
+
 private:
     Device *m_device = nullptr;
 
@@ -86,9 +216,38 @@ private:
     Buffer m_indexBuffer;
 
     u32 m_vertexCount = 0;
+    VertexFormat m_vertexFormat = VertexFormat::Float;
     u32 m_indexCount = 0;
+    VkIndexType m_indexType = VK_INDEX_TYPE_UINT32;
+
+    std::vector<Lod> m_lods;
+
+    Buffer m_meshletBuffer;
+    u32 m_meshletCount = 0;
+    u32 m_meshletBufferID = ~0u;
+    u32 m_vertexBufferID = ~0u;
+    glm::vec4 m_boundingSphere = glm::vec4(0.0f);
+    f32 m_uvDensity = 0.0f;
 
     u32 m_textureID = 0;
+
+private:
+    void bindIndexBuffer(VkCommandBuffer cmd) const;
+    u32 getTextureIndex() const;
+
+    // Drops the defragmenter and bindless references to the buffers.
+    void release();
+
+    template<typename V>
+    void initBuffers(
+        Device &device,
+        const std::vector<V> &vertices,
+        const std::vector<u32> &indices,
+        const std::vector<Lod> &lods
+    );
+
+    template<typename T>
+    void uploadIndices(const std::vector<u32> &indices);
 };
 
 } // namespace gfx
\ No newline at end of file
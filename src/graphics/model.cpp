@@ -1,4 +1,13 @@
 #include "model.hpp"
+#include "geometry/accessor.hpp"
+#include "geometry/optimizer.hpp"
+#include "geometry/welder.hpp"
+#include "geometry/quantization.hpp"
+#include "geometry/simplifier.hpp"
+#include "texture/mipmaps.hpp"
+
+#include <cstring>
+#include <stdexcept>
 
 namespace gfx
 {
@@ -6,11 +15,23 @@ namespace gfx
 void Model::load(
     Device &device,
     BindlessManager &bindlessManager,
-    const std::string &filepath
+    const std::string &filepath,
+    const ModelLoadOptions &options,
+    TextureCache *textureCache
 )
 {
     m_device = &device;
     m_bindlessManager = &bindlessManager;
+    m_options = options;
+
+    if (!textureCache) {
+        m_ownedTextureCache = std::make_unique<TextureCache>();
+        m_ownedTextureCache->init(device, bindlessManager);
+        textureCache = m_ownedTextureCache.get();
+    }
+
+    m_textureCache = textureCache;
+    m_textureStreamer = textureCache->getTextureStreamer();
 
     tinygltf::Model gltfModel;
     tinygltf::TinyGLTF loader;
@@ -45,12 +66,34 @@ void Model::destroy()
     }
 
     m_meshes.clear();
+    releaseTextures();
+}
 
-    for (auto &texture : m_textures) {
-        texture.destroy();
+void Model::deferDestroy()
+{
+    for (auto &mesh : m_meshes) {
+        mesh.deferDestroy();
+    }
+
+    m_meshes.clear();
+    releaseTextures();
+}
+
+void Model::releaseTextures()
+{
+    // The cache defers destroying images, see TextureCache::release().
+    for (u32 id : m_textures) {
+        m_textureCache->release(id);
     }
 
     m_textures.clear();
+    m_textureStreams.clear();
+    m_meshTextures.clear();
+
+    if (m_ownedTextureCache) {
+        m_ownedTextureCache->destroy();
+        m_ownedTextureCache.reset();
+    }
 }
 
 void Model::draw(VkCommandBuffer cmd)
@@ -61,165 +104,732 @@ void Model::draw(VkCommandBuffer cmd)
     }
 }
 
+void Model::draw(
+    VkCommandBuffer cmd,
+    const Camera &camera,
+    const glm::mat4 &transform,
+    f32 viewportHeight
+)
+{
+    for (usize i = 0; i < m_meshes.size(); i++) {
+        Mesh &mesh = m_meshes[i];
+        f32 pixelsPerUnit = getPixelsPerUnit(mesh, camera, transform, viewportHeight);
+
+        requestTexture(i, pixelsPerUnit);
+
+        mesh.bind(cmd);
+        mesh.draw(cmd, selectLod(mesh, pixelsPerUnit));
+    }
+}
+
+void Model::drawPulled(
+    VkCommandBuffer cmd,
+    Pipeline &pipeline,
+    u32 pushOffset,
+    const Camera &camera,
+    const glm::mat4 &transform,
+    f32 viewportHeight
+)
+{
+    for (usize i = 0; i < m_meshes.size(); i++) {
+        Mesh &mesh = m_meshes[i];
+        f32 pixelsPerUnit = getPixelsPerUnit(mesh, camera, transform, viewportHeight);
+
+        requestTexture(i, pixelsPerUnit);
+
+        mesh.bindPulled(cmd, pipeline, pushOffset);
+        mesh.draw(cmd, selectLod(mesh, pixelsPerUnit));
+    }
+}
+
+void Model::requestTextures(
+    const Camera &camera,
+    const glm::mat4 &transform,
+    f32 viewportHeight
+)
+{
+    for (usize i = 0; i < m_meshes.size(); i++) {
+        requestTexture(
+            i,
+            getPixelsPerUnit(m_meshes[i], camera, transform, viewportHeight)
+        );
+    }
+}
+
+void Model::requestTexture(usize meshIndex, f32 pixelsPerUnit)
+{
+    u32 streamID = m_textureStreams[m_meshTextures[meshIndex]];
+    if (streamID == ~0u) {
+        return;
+    }
+
+    Mesh &mesh = m_meshes[meshIndex];
+    m_textureStreamer->request(streamID, mesh.getUVDensity() / pixelsPerUnit);
+    mesh.setTextureID(m_textureStreamer->getHandle(streamID));
+}
+
+f32 Model::getPixelsPerUnit(
+    const Mesh &mesh,
+    const Camera &camera,
+    const glm::mat4 &transform,
+    f32 viewportHeight
+) const
+{
+    const glm::vec4 &sphere = mesh.getBoundingSphere();
+
+    glm::vec3 center = glm::vec3(transform * glm::vec4(glm::vec3(sphere), 1.0f));
+    f32 scale = std::max({
+        glm::length(glm::vec3(transform[0])),
+        glm::length(glm::vec3(transform[1])),
+        glm::length(glm::vec3(transform[2]))
+    });
+
+    f32 distance = glm::length(center - camera.getPosition()) - sphere.w * scale;
+    distance = std::max(distance, camera.getNear());
+
+    // Pixels per world unit at `distance` for a vertical field of view.
+    f32 projection = viewportHeight * 0.5f /
+        std::tan(glm::radians(camera.getFov()) * 0.5f);
+    return projection * scale / distance;
+}
+
+u32 Model::selectLod(const Mesh &mesh, f32 pixelsPerUnit) const
+{
+    u32 lod = 0;
+    for (u32 i = 1; i < mesh.getLodCount(); i++) {
+        if (mesh.getLod(i).error * pixelsPerUnit > m_options.lodPixelThreshold) {
+            break;
+        }
+        lod = i;
+    }
+
+    return lod;
+}
+
+void Model::drawMeshlets(
+    VkCommandBuffer cmd,
+    Pipeline &pipeline,
+    u32 pushOffset
+)
+{
+    for (auto &mesh : m_meshes) {
+        mesh.drawMeshlets(cmd, pipeline, pushOffset);
+    }
+}
+
+bool Model::hasMeshlets() const
+{
+    for (const auto &mesh : m_meshes) {
+        if (!mesh.hasMeshlets()) {
+            return false;
+        }
+    }
+
+    return !m_meshes.empty();
+}
+
+glm::mat4 Model::getDequantizeTransform() const
+{
+    if (m_vertexFormat != VertexFormat::Packed) {
+        return glm::mat4(1.0f);
+    }
+
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), m_boundsMin);
+    return glm::scale(transform, m_boundsExtent);
+}
+
+static geometry::ComponentType getComponentType(int componentType)
+{
+    switch (componentType) {
+        case TINYGLTF_COMPONENT_TYPE_BYTE:
+            return geometry::ComponentType::I8;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            return geometry::ComponentType::U8;
+        case TINYGLTF_COMPONENT_TYPE_SHORT:
+            return geometry::ComponentType::I16;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            return geometry::ComponentType::U16;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            return geometry::ComponentType::U32;
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+            return geometry::ComponentType::F32;
+        default:
+            throw std::runtime_error(
+                "Unsupported accessor component type: " +
+                std::to_string(componentType)
+            );
+    }
+}
+
+static geometry::AccessorView getAccessorView(
+    const tinygltf::Model &gltfModel,
+    const tinygltf::Accessor &accessor
+)
+{
+    geometry::AccessorView view;
+    view.count = accessor.count;
+    view.components = static_cast<u32>(
+        tinygltf::GetNumComponentsInType(accessor.type)
+    );
+    view.componentType = getComponentType(accessor.componentType);
+    view.normalized = accessor.normalized;
+
+    if (accessor.bufferView < 0) {
+        return view;
+    }
+
+    const tinygltf::BufferView &bufferView = 
+        gltfModel.bufferViews[accessor.bufferView];
+    const tinygltf::Buffer &buffer =
+        gltfModel.buffers[bufferView.buffer];
+
+    int stride = accessor.ByteStride(bufferView);
+    if (stride <= 0) {
+        throw std::runtime_error("Invalid accessor byte stride.");
+    }
+
+    usize offset = accessor.byteOffset + bufferView.byteOffset;
+    usize elementSize = 
+        geometry::getComponentSize(view.componentType) * view.components;
+
+    if (
+        view.count > 0 &&
+        offset + (view.count - 1) * stride + elementSize > buffer.data.size()
+    ) {
+        throw std::runtime_error("Accessor exceeds buffer bounds.");
+    }
+
+    view.data = buffer.data.data() + offset;
+    view.stride = static_cast<usize>(stride);
+
+    return view;
+}
+
+static void readAttribute(
+    const tinygltf::Model &gltfModel,
+    const tinygltf::Primitive &primitive,
+    const std::string &name,
+    u32 components,
+    usize vertexCount,
+    u8 *dst
+)
+{
+    geometry::AccessorView view;
+    view.count = vertexCount;
+
+    auto it = primitive.attributes.find(name);
+    if (it != primitive.attributes.end()) {
+        view = getAccessorView(gltfModel, gltfModel.accessors[it->second]);
+        if (view.count != vertexCount) {
+            throw std::runtime_error("Mesh attribute count mismatch: " + name);
+        }
+    }
+
+    geometry::readFloats(view, components, dst, sizeof(Mesh::Vertex));
+}
+
+// Square root of texture area over surface area, so texel density scales
+// linearly with it.
+static f32 computeUVDensity(
+    const std::vector<Mesh::Vertex> &vertices,
+    const std::vector<u32> &indices
+)
+{
+    f32 surfaceArea = 0.0f;
+    f32 uvArea = 0.0f;
+
+    for (usize i = 0; i + 2 < indices.size(); i += 3) {
+        const Mesh::Vertex &a = vertices[indices[i + 0]];
+        const Mesh::Vertex &b = vertices[indices[i + 1]];
+        const Mesh::Vertex &c = vertices[indices[i + 2]];
+
+        surfaceArea += glm::length(glm::cross(b.pos - a.pos, c.pos - a.pos));
+
+        glm::vec2 uvB = b.uv - a.uv;
+        glm::vec2 uvC = c.uv - a.uv;
+        uvArea += std::abs(uvB.x * uvC.y - uvB.y * uvC.x);
+    }
+
+    if (surfaceArea <= 0.0f) {
+        return 0.0f;
+    }
+
+    return std::sqrt(uvArea / surfaceArea);
+}
+
 void Model::processMeshes(
     const tinygltf::Model &gltfModel,
     const std::vector<u32> &textureIDs
 )
 {
+    std::vector<Primitive> primitives;
+
     for (const auto &mesh : gltfModel.meshes) {
         for (const auto &primitive : mesh.primitives) {
             std::vector<Mesh::Vertex> vertices;
             std::vector<u32> indices;
 
-            usize vertexCount = 0;
-
-            if (primitive.attributes.find("POSITION") != primitive.attributes.end()) {
-                const tinygltf::Accessor &posAccessor = 
-                    gltfModel.accessors[primitive.attributes.at("POSITION")];
-
-                vertexCount = posAccessor.count;
-                vertices.resize(vertexCount);
-            } else {
+            auto posIt = primitive.attributes.find("POSITION");
+            if (posIt == primitive.attributes.end()) {
                 throw std::runtime_error("Mesh has no POSITION attribute.");
             }
 
-            if (primitive.indices >= 0) {
-                const tinygltf::Accessor &accessor = gltfModel.accessors[primitive.indices];
-                const tinygltf::BufferView &bufferView = gltfModel.bufferViews[accessor.bufferView];
-                const tinygltf::Buffer &buffer = gltfModel.buffers[bufferView.buffer];
-            
-                indices.resize(accessor.count);
-                const void* data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
-                
-                switch (accessor.componentType) {
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
-                        const uint16_t* typedIndices =
-                            reinterpret_cast<const uint16_t*>(data);
-                        for (usize i = 0; i < accessor.count; i++) {
-                            indices[i] = static_cast<u32>(typedIndices[i]);
-                        }
-                        break;
-                    }
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
-                        const uint32_t* typedIndices =
-                            reinterpret_cast<const uint32_t*>(data);
-                        for (usize i = 0; i < accessor.count; i++) {
-                            indices[i] = typedIndices[i];
-                        }
-                        break;
-                    }
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
-                        const uint8_t* typedIndices = 
-                            reinterpret_cast<const uint8_t*>(data);
-                        for (usize i = 0; i < accessor.count; i++) {
-                            indices[i] = static_cast<u32>(typedIndices[i]);
-                        }
-                        break;
-                    }
-                    default:
-                        std::cerr << "Unsupported index component type: " << accessor.componentType << std::endl;
-                        indices.resize(vertexCount);
-                        for (usize i = 0; i < vertexCount; i++) {
-                            indices[i] = static_cast<u32>(i);
-                        }
-                }
-            } else {
-                indices.resize(vertexCount);
-                for (usize i = 0; i < vertexCount; i++) {
-                    indices[i] = static_cast<u32>(i);
-                }
-            }
-
-            if (primitive.attributes.find("POSITION") != primitive.attributes.end()) {
-                const tinygltf::Accessor &accessor = 
-                    gltfModel.accessors[primitive.attributes.at("POSITION")];
-                const tinygltf::BufferView &bufferView = 
-                    gltfModel.bufferViews[accessor.bufferView];
-                const tinygltf::Buffer &buffer =
-                    gltfModel.buffers[bufferView.buffer];
+            geometry::AccessorView posView = getAccessorView(
+                gltfModel,
+                gltfModel.accessors[posIt->second]
+            );
 
-                const f32 *data = reinterpret_cast<const f32 *>(
-                    buffer.data.data() + accessor.byteOffset + bufferView.byteOffset
-                );
+            usize vertexCount = posView.count;
+            vertices.resize(vertexCount);
 
-                for (usize i = 0; i < vertexCount; ++i) {
-                    vertices[i].pos = glm::vec3(
-                        data[i * 3],
-                        data[i * 3 + 1],
-                        data[i * 3 + 2]
-                    );
-                }
-            } else {
-                throw std::runtime_error("Mesh has no POSITION attribute.");
-            }
+            u8 *vertexData = reinterpret_cast<u8 *>(vertices.data());
 
-            if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
-                const tinygltf::Accessor &accessor = 
-                    gltfModel.accessors[primitive.attributes.at("NORMAL")];
-                const tinygltf::BufferView &bufferView = 
-                    gltfModel.bufferViews[accessor.bufferView];
-                const tinygltf::Buffer &buffer =
-                    gltfModel.buffers[bufferView.buffer];
-
-                const f32 *data = reinterpret_cast<const f32 *>(
-                    buffer.data.data() + accessor.byteOffset + bufferView.byteOffset
-                );
+            geometry::readFloats(
+                posView,
+                3,
+                vertexData + offsetof(Mesh::Vertex, pos),
+                sizeof(Mesh::Vertex)
+            );
 
-                for (usize i = 0; i < vertexCount; ++i) {
-                    vertices[i].normal = glm::vec3(
-                        data[i * 3],
-                        data[i * 3 + 1],
-                        data[i * 3 + 2]
-                    );
-                }
-            } else {
-                for (usize i = 0; i < vertexCount; ++i) {
-                    vertices[i].normal = glm::vec3(0.0f, 0.0f, 0.0f);
-                }
-            }
+            readAttribute(
+                gltfModel,
+                primitive,
+                "NORMAL",
+                3,
+                vertexCount,
+                vertexData + offsetof(Mesh::Vertex, normal)
+            );
 
-            if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
-                const tinygltf::Accessor &accessor = 
-                    gltfModel.accessors[primitive.attributes.at("TEXCOORD_0")];
-                const tinygltf::BufferView &bufferView = 
-                    gltfModel.bufferViews[accessor.bufferView];
-                const tinygltf::Buffer &buffer =
-                    gltfModel.buffers[bufferView.buffer];
+            readAttribute(
+                gltfModel,
+                primitive,
+                "TEXCOORD_0",
+                2,
+                vertexCount,
+                vertexData + offsetof(Mesh::Vertex, uv)
+            );
 
-                const f32 *data = reinterpret_cast<const f32 *>(
-                    buffer.data.data() + accessor.byteOffset + bufferView.byteOffset
+            if (primitive.indices >= 0) {
+                geometry::AccessorView indexView = getAccessorView(
+                    gltfModel,
+                    gltfModel.accessors[primitive.indices]
                 );
 
-                for (usize i = 0; i < vertexCount; ++i) {
-                    vertices[i].uv = glm::vec2(
-                        data[i * 2],
-                        data[i * 2 + 1]
-                    );
+                indices.resize(indexView.count);
+                geometry::readIndices(indexView, indices.data());
+
+                // The optimizers index per-vertex tables with these.
+                for (u32 index : indices) {
+                    if (index >= vertexCount) {
+                        throw std::out_of_range("Index references a missing vertex.");
+                    }
                 }
             } else {
-                for (usize i = 0; i < vertexCount; ++i) {
-                    vertices[i].uv = glm::vec2(0.0f, 0.0f);
+                indices.resize(vertexCount);
+                for (usize i = 0; i < vertexCount; i++) {
+                    indices[i] = static_cast<u32>(i);
                 }
             }
 
+            weldMesh(vertices, indices);
+            optimizeMesh(vertices, indices);
+
             u32 textureID = 0;
+            u32 textureIndex = 0;
+            bool twoSided = false;
             if (
                 primitive.material >= 0 &&
                 primitive.material < static_cast<int>(gltfModel.materials.size())
             ) {
                 const auto& material = gltfModel.materials[primitive.material];
+                twoSided = material.doubleSided;
                 if (material.pbrMetallicRoughness.baseColorTexture.index >= 0) {
                     int texIndex = material.pbrMetallicRoughness.baseColorTexture.index;
-                    textureID = textureIDs[texIndex + 1];
+                    textureIndex = static_cast<u32>(texIndex + 1);
+                    textureID = textureIDs[textureIndex];
                 }
             }
 
-            Mesh mesh;
-            mesh.init(*m_device, vertices, indices);
-            m_meshes.push_back(std::move(mesh));
-            m_meshes.back().setTextureID(textureID);
+            Primitive result;
+            result.vertices = std::move(vertices);
+            result.indices = std::move(indices);
+            result.textureID = textureID;
+            result.textureIndex = textureIndex;
+            result.uvDensity = computeUVDensity(result.vertices, result.indices);
+            result.twoSided = twoSided;
+
+            generateLods(result);
+            buildMeshlets(result);
+            primitives.push_back(std::move(result));
         }
     }
+
+    createMeshes(primitives);
+}
+
+void Model::generateLods(Primitive &primitive)
+{
+    auto &vertices = primitive.vertices;
+    auto &indices = primitive.indices;
+
+    if (vertices.empty()) {
+        return;
+    }
+
+    glm::vec3 boundsMin = vertices[0].pos;
+    glm::vec3 boundsMax = vertices[0].pos;
+    for (const auto &vertex : vertices) {
+        boundsMin = glm::min(boundsMin, vertex.pos);
+        boundsMax = glm::max(boundsMax, vertex.pos);
+    }
+
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    f32 radius = 0.0f;
+    for (const auto &vertex : vertices) {
+        radius = std::max(radius, glm::length(vertex.pos - center));
+    }
+    primitive.boundingSphere = glm::vec4(center, radius);
+
+    primitive.lods.push_back({ 0, static_cast<u32>(indices.size()), 0.0f });
+
+    if (indices.empty() || indices.size() % 3 != 0) {
+        return;
+    }
+
+    glm::vec3 size = boundsMax - boundsMin;
+    f32 extent = std::max({ size.x, size.y, size.z });
+
+    std::vector<u32> previous(indices);
+    std::vector<u32> simplified(indices.size());
+    std::vector<u32> optimized;
+    f32 relativeError = 0.0f;
+
+    for (u32 level = 1; level < m_options.lodCount; level++) {
+        usize target = static_cast<usize>(previous.size() * m_options.lodReduction) / 3 * 3;
+
+        // Errors accumulate because each level simplifies the previous one.
+        f32 remainingError = m_options.lodMaxError - relativeError;
+        if (remainingError <= 0.0f) {
+            break;
+        }
+
+        f32 error = 0.0f;
+        usize indexCount = geometry::simplify(
+            simplified.data(),
+            previous.data(),
+            previous.size(),
+            &vertices[0].pos.x,
+            sizeof(Mesh::Vertex),
+            vertices.size(),
+            target,
+            remainingError,
+            &error
+        );
+
+        // Stop once a level no longer removes a meaningful share.
+        if (indexCount == 0 || indexCount > previous.size() * 9 / 10) {
+            break;
+        }
+
+        relativeError += error;
+
+        optimized.resize(indexCount);
+        geometry::optimizeVertexCache(
+            optimized.data(),
+            simplified.data(),
+            indexCount,
+            vertices.size()
+        );
+
+        primitive.lods.push_back({
+            static_cast<u32>(indices.size()),
+            static_cast<u32>(indexCount),
+            relativeError * extent
+        });
+
+        indices.insert(indices.end(), optimized.begin(), optimized.end());
+        previous.assign(optimized.begin(), optimized.end());
+    }
+
+    std::cout << "Mesh LODs: " << primitive.lods.size() << " levels, "
+              << primitive.lods.back().indexCount / 3 << " triangles at coarsest"
+              << std::endl;
+}
+
+void Model::buildMeshlets(Primitive &primitive)
+{
+    if (!m_options.buildMeshlets || primitive.lods.empty()) {
+        return;
+    }
+
+    const Mesh::Lod &lod = primitive.lods[0];
+    if (lod.indexCount == 0 || lod.indexCount % 3 != 0) {
+        return;
+    }
+
+    const f32 *positions = &primitive.vertices[0].pos.x;
+
+    primitive.meshlets = geometry::buildMeshlets(
+        primitive.indices.data() + lod.indexOffset,
+        lod.indexCount,
+        positions,
+        sizeof(Mesh::Vertex),
+        primitive.vertices.size()
+    );
+
+    primitive.meshletBounds.reserve(primitive.meshlets.meshlets.size());
+    for (const auto &meshlet : primitive.meshlets.meshlets) {
+        primitive.meshletBounds.push_back(geometry::computeMeshletBounds(
+            primitive.meshlets,
+            meshlet,
+            positions,
+            sizeof(Mesh::Vertex),
+            primitive.twoSided
+        ));
+    }
+
+    std::cout << "Mesh meshlets: " << primitive.meshlets.meshlets.size()
+              << " for " << lod.indexCount / 3 << " triangles" << std::endl;
+}
+
+void Model::createMeshes(std::vector<Primitive> &primitives)
+{
+    std::vector<std::vector<Mesh::PackedVertex>> packed;
+
+    m_vertexFormat = VertexFormat::Float;
+    if (m_options.vertexFormat == VertexFormat::Packed) {
+        if (packVertices(primitives, packed)) {
+            m_vertexFormat = VertexFormat::Packed;
+        } else {
+            std::cout << "Packed vertices exceed error bounds, "
+                      << "using float vertices" << std::endl;
+        }
+    }
+
+    for (usize i = 0; i < primitives.size(); i++) {
+        Mesh mesh;
+        const Primitive &primitive = primitives[i];
+
+        if (m_vertexFormat == VertexFormat::Packed) {
+            mesh.init(*m_device, packed[i], primitive.indices, primitive.lods);
+        } else {
+            mesh.init(*m_device, primitive.vertices, primitive.indices, primitive.lods);
+        }
+
+        m_meshes.push_back(std::move(mesh));
+        m_meshes.back().setTextureID(primitive.textureID);
+        m_meshes.back().setBoundingSphere(primitive.boundingSphere);
+        m_meshes.back().setUVDensity(primitive.uvDensity);
+        m_meshTextures.push_back(primitive.textureIndex);
+
+        if (!primitive.meshlets.meshlets.empty()) {
+            bool isPacked = m_vertexFormat == VertexFormat::Packed;
+            m_meshes.back().initMeshlets(
+                primitive.meshlets,
+                primitive.meshletBounds,
+                isPacked ? m_boundsMin : glm::vec3(0.0f),
+                isPacked ? m_boundsExtent : glm::vec3(1.0f)
+            );
+        }
+    }
+
+    // Registered by address, so only once the vector stops growing.
+    for (auto &mesh : m_meshes) {
+        mesh.allowDefragmentation();
+    }
+}
+
+bool Model::packVertices(
+    const std::vector<Primitive> &primitives,
+    std::vector<std::vector<Mesh::PackedVertex>> &packed
+)
+{
+    // All meshes share the model bounds so one transform dequantizes
+    // every draw of this model.
+    glm::vec3 boundsMin(F32_MAX);
+    glm::vec3 boundsMax(-F32_MAX);
+
+    for (const auto &primitive : primitives) {
+        for (const auto &vertex : primitive.vertices) {
+            boundsMin = glm::min(boundsMin, vertex.pos);
+            boundsMax = glm::max(boundsMax, vertex.pos);
+        }
+    }
+
+    if (boundsMin.x > boundsMax.x) {
+        return false;
+    }
+
+    glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(F32_MIN));
+
+    f32 positionError = 0.0f;
+    f32 normalError = 0.0f;
+    f32 uvError = 0.0f;
+
+    packed.resize(primitives.size());
+
+    for (usize i = 0; i < primitives.size(); i++) {
+        const auto &vertices = primitives[i].vertices;
+        packed[i].resize(vertices.size());
+
+        for (usize v = 0; v < vertices.size(); v++) {
+            const Mesh::Vertex &src = vertices[v];
+            Mesh::PackedVertex &dst = packed[i][v];
+
+            glm::vec3 normalized = (src.pos - boundsMin) / extent;
+            for (u32 c = 0; c < 3; c++) {
+                dst.pos[c] = geometry::quantizeUnorm16(normalized[c]);
+
+                f32 decoded = boundsMin[c] + 
+                    geometry::dequantizeUnorm16(dst.pos[c]) * extent[c];
+                positionError = std::max(positionError, std::abs(decoded - src.pos[c]));
+            }
+            dst.pos[3] = 0;
+
+            glm::vec3 normal = src.normal;
+            geometry::encodeOctahedral(&normal.x, dst.normal);
+
+            if (glm::dot(normal, normal) > 0.0f) {
+                glm::vec3 decoded;
+                geometry::decodeOctahedral(dst.normal, &decoded.x);
+                normalError = std::max(
+                    normalError,
+                    glm::length(decoded - glm::normalize(normal))
+                );
+            }
+
+            for (u32 c = 0; c < 2; c++) {
+                dst.uv[c] = geometry::quantizeHalf(src.uv[c]);
+
+                f32 decoded = geometry::dequantizeHalf(dst.uv[c]);
+                uvError = std::max(uvError, std::abs(decoded - src.uv[c]));
+            }
+        }
+    }
+
+    std::cout << "Vertex quantization error: position " << positionError
+              << ", normal " << normalError << ", uv " << uvError << std::endl;
+
+    if (
+        positionError > m_options.maxPositionError ||
+        normalError > m_options.maxNormalError ||
+        uvError > m_options.maxUVError
+    ) {
+        packed.clear();
+        return false;
+    }
+
+    m_boundsMin = boundsMin;
+    m_boundsExtent = extent;
+
+    return true;
+}
+
+void Model::weldMesh(
+    std::vector<Mesh::Vertex> &vertices,
+    std::vector<u32> &indices
+)
+{
+    if (!m_options.weldVertices || vertices.empty()) {
+        return;
+    }
+
+    geometry::WeldMode mode = m_options.weldEpsilon > 0.0f ?
+        geometry::WeldMode::Epsilon : geometry::WeldMode::Exact;
+
+    std::vector<u32> remap(vertices.size());
+    usize vertexCount = geometry::generateVertexRemap(
+        remap.data(),
+        indices.data(),
+        indices.size(),
+        vertices.data(),
+        vertices.size(),
+        sizeof(Mesh::Vertex),
+        mode,
+        m_options.weldEpsilon
+    );
+
+    if (vertexCount == vertices.size()) {
+        return;
+    }
+
+    usize bytesBefore = vertices.size() * sizeof(Mesh::Vertex);
+
+    geometry::remapIndexBuffer(
+        indices.data(),
+        indices.data(),
+        indices.size(),
+        remap.data()
+    );
+    vertices = geometry::remapVertices(vertices, remap, vertexCount);
+
+    usize bytesAfter = vertices.size() * sizeof(Mesh::Vertex);
+
+    std::cout << "Mesh welded: " << remap.size() << " -> " << vertexCount
+              << " vertices, saved " << (bytesBefore - bytesAfter) / 1024
+              << " KiB" << std::endl;
+}
+
+void Model::optimizeMesh(
+    std::vector<Mesh::Vertex> &vertices,
+    std::vector<u32> &indices
+)
+{
+    if (indices.empty() || indices.size() % 3 != 0) {
+        return;
+    }
+
+    geometry::VertexCacheStats before = geometry::analyzeVertexCache(
+        indices.data(),
+        indices.size(),
+        vertices.size()
+    );
+
+    if (m_options.optimizeVertexCache) {
+        std::vector<u32> optimized(indices.size());
+        geometry::optimizeVertexCache(
+            optimized.data(),
+            indices.data(),
+            indices.size(),
+            vertices.size()
+        );
+
+        if (m_options.optimizeOverdraw) {
+            geometry::optimizeOverdraw(
+                indices.data(),
+                optimized.data(),
+                optimized.size(),
+                &vertices[0].pos.x,
+                sizeof(Mesh::Vertex),
+                vertices.size(),
+                m_options.overdrawThreshold
+            );
+        } else {
+            indices.swap(optimized);
+        }
+    }
+
+    if (m_options.optimizeVertexFetch) {
+        usize uniqueVertexCount = 0;
+        std::vector<u32> remap = geometry::optimizeVertexFetchRemap(
+            indices.data(),
+            indices.size(),
+            vertices.size(),
+            &uniqueVertexCount
+        );
+
+        vertices = geometry::remapVertices(vertices, remap, uniqueVertexCount);
+    }
+
+    geometry::VertexCacheStats after = geometry::analyzeVertexCache(
+        indices.data(),
+        indices.size(),
+        vertices.size()
+    );
+
+    std::cout << "Mesh optimized: " << indices.size() / 3 << " triangles, ACMR "
+              << before.acmr << " -> " << after.acmr << ", ATVR "
+              << before.atvr << " -> " << after.atvr << std::endl;
 }
 
 void Model::processTextures(
@@ -228,19 +838,37 @@ void Model::processTextures(
 )
 {
     textureIDs.resize(gltfModel.textures.size() + 1, 0);
+    m_textureStreams.resize(gltfModel.textures.size() + 1, ~0u);
 
-    Image defaultImage;
-    u32 whitePixel = 0xFFFFFFFF;
-    defaultImage.init(
-        *m_device,
-        &whitePixel,
-        1,
-        1,
-        VK_FORMAT_R8G8B8A8_UNORM
-    );
+    u32 defaultTexture = m_textureCache->acquireDefault();
+    textureIDs[0] = m_textureCache->getHandle(defaultTexture);
+    m_textures.push_back(defaultTexture);
 
-    textureIDs[0] = m_bindlessManager->addTexture(defaultImage);
-    m_textures.push_back(std::move(defaultImage));
+    std::vector<TextureUsage> usages(gltfModel.textures.size());
+    auto getUsage = [&](int index) -> TextureUsage * {
+        if (index < 0 || index >= static_cast<int>(usages.size())) {
+            return nullptr;
+        }
+        return &usages[index];
+    };
+
+    for (const tinygltf::Material &material : gltfModel.materials) {
+        if (TextureUsage *usage = getUsage(material.normalTexture.index)) {
+            usage->normalMap = true;
+        }
+
+        if (TextureUsage *usage = getUsage(material.emissiveTexture.index)) {
+            usage->srgb = true;
+        }
+
+        int baseColor = material.pbrMetallicRoughness.baseColorTexture.index;
+        if (TextureUsage *usage = getUsage(baseColor)) {
+            usage->srgb = true;
+            if (material.alphaMode == "MASK") {
+                usage->alphaCutoff = static_cast<f32>(material.alphaCutoff);
+            }
+        }
+    }
 
     for (usize i = 0; i < gltfModel.textures.size(); i++) {
         const tinygltf::Texture &gltfTexture = gltfModel.textures[i];
@@ -253,31 +881,232 @@ void Model::processTextures(
         }
 
         const tinygltf::Image &image = gltfModel.images[gltfTexture.source];
-        Image textureImage;
-
-        if (image.component == 4) {
-            textureImage.init(
-                *m_device,
-                image.image.data(),
-                image.width,
-                image.height,
-                VK_FORMAT_R8G8B8A8_UNORM
-            );
-        } else if (image.component == 3) {
-            textureImage.init(
-                *m_device,
-                image.image.data(),
-                image.width,
-                image.height,
-                VK_FORMAT_R8G8B8_UNORM
+        TextureKey key = getTextureKey(
+            image,
+            usages[i],
+            getSampler(gltfModel, gltfTexture.sampler)
+        );
+
+        // Processing is skipped entirely for textures another model, or
+        // another glTF texture of this one, already uploaded.
+        u32 id = m_textureCache->acquire(key);
+        if (id == ~0u) {
+            TextureData texture = createTexture(image, usages[i]);
+            id = m_textureCache->add(
+                key,
+                texture.data.data(),
+                texture.levelCount,
+                texture.format,
+                m_options.streamTextures
             );
-        } else {
-            throw std::runtime_error("Unsupported image format.");
         }
 
-        textureIDs[i + 1] = m_bindlessManager->addTexture(textureImage);
-        m_textures.push_back(std::move(textureImage));
+        m_textures.push_back(id);
+        m_textureStreams[i + 1] = m_textureCache->getStreamID(id);
+        textureIDs[i + 1] = m_textureCache->getHandle(id);
+    }
+}
+
+VkSampler Model::getSampler(const tinygltf::Model &gltfModel, int samplerIndex) const
+{
+    // glTF defaults: repeat, filtering left to the implementation.
+    tinygltf::Sampler gltfSampler;
+    if (samplerIndex >= 0 && samplerIndex < static_cast<int>(gltfModel.samplers.size())) {
+        gltfSampler = gltfModel.samplers[samplerIndex];
+    }
+
+    auto getAddressMode = [](int wrap) {
+        switch (wrap) {
+            case TINYGLTF_TEXTURE_WRAP_CLAMP_TO_EDGE: return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            case TINYGLTF_TEXTURE_WRAP_MIRRORED_REPEAT: return VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+            default: return VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        }
+    };
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = gltfSampler.magFilter == TINYGLTF_TEXTURE_FILTER_NEAREST
+        ? VK_FILTER_NEAREST
+        : VK_FILTER_LINEAR;
+    samplerInfo.addressModeU = getAddressMode(gltfSampler.wrapS);
+    samplerInfo.addressModeV = getAddressMode(gltfSampler.wrapT);
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+    // Every texture gets a full chain, so minification without mipmaps
+    // samples level 0 only.
+    switch (gltfSampler.minFilter) {
+        case TINYGLTF_TEXTURE_FILTER_NEAREST:
+        case TINYGLTF_TEXTURE_FILTER_LINEAR:
+            samplerInfo.minFilter = gltfSampler.minFilter == TINYGLTF_TEXTURE_FILTER_NEAREST
+                ? VK_FILTER_NEAREST
+                : VK_FILTER_LINEAR;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            samplerInfo.maxLod = 0.0f;
+            break;
+        case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_NEAREST:
+            samplerInfo.minFilter = VK_FILTER_NEAREST;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            break;
+        case TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_NEAREST:
+            samplerInfo.minFilter = VK_FILTER_LINEAR;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            break;
+        case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_LINEAR:
+            samplerInfo.minFilter = VK_FILTER_NEAREST;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            break;
+        default:
+            samplerInfo.minFilter = VK_FILTER_LINEAR;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            break;
     }
+
+    bool isFiltered = samplerInfo.minFilter == VK_FILTER_LINEAR && samplerInfo.maxLod > 0.0f;
+    samplerInfo.anisotropyEnable = isFiltered && m_options.maxAnisotropy > 1.0f;
+    samplerInfo.maxAnisotropy = m_options.maxAnisotropy;
+
+    return m_device->getSamplerCache().getSampler(samplerInfo);
+}
+
+TextureKey Model::getTextureKey(
+    const tinygltf::Image &image,
+    const TextureUsage &usage,
+    VkSampler sampler
+) const
+{
+    u32 alphaCutoff;
+    memcpy(&alphaCutoff, &usage.alphaCutoff, sizeof(alphaCutoff));
+
+    // Everything createTexture() depends on besides the pixels.
+    u32 settings[] = {
+        static_cast<u32>(image.component),
+        static_cast<u32>(image.bits),
+        usage.normalMap,
+        usage.srgb,
+        alphaCutoff,
+        m_options.compressTextures,
+        static_cast<u32>(m_options.colorTextureFormat),
+        static_cast<u32>(m_options.mipFilter)
+    };
+
+    TextureKey key;
+    key.hash = TextureCache::hash(
+        image.image.data(),
+        image.image.size(),
+        TextureCache::hash(settings, sizeof(settings))
+    );
+    key.width = static_cast<u32>(image.width);
+    key.height = static_cast<u32>(image.height);
+    key.sampler = sampler;
+
+    return key;
+}
+
+Model::TextureData Model::createTexture(
+    const tinygltf::Image &image,
+    const TextureUsage &usage
+)
+{
+    if (image.bits != 8 || (image.component != 3 && image.component != 4)) {
+        throw std::runtime_error("Unsupported image format.");
+    }
+
+    u32 width = static_cast<u32>(image.width);
+    u32 height = static_cast<u32>(image.height);
+    usize pixelCount = static_cast<usize>(width) * height;
+
+    // Three channel formats are rarely sampleable, expand to RGBA.
+    std::vector<u8> pixels(pixelCount * 4);
+    bool hasAlpha = false;
+
+    for (usize i = 0; i < pixelCount; i++) {
+        const u8 *src = &image.image[i * image.component];
+        pixels[i * 4 + 0] = src[0];
+        pixels[i * 4 + 1] = src[1];
+        pixels[i * 4 + 2] = src[2];
+        pixels[i * 4 + 3] = image.component == 4 ? src[3] : 255;
+        hasAlpha |= pixels[i * 4 + 3] != 255;
+    }
+
+    texture::BlockFormat blockFormat = usage.normalMap
+        ? texture::BlockFormat::BC5
+        : m_options.colorTextureFormat;
+
+    if (blockFormat == texture::BlockFormat::BC1 && hasAlpha) {
+        blockFormat = texture::BlockFormat::BC3;
+    }
+
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    switch (blockFormat) {
+        case texture::BlockFormat::BC1: format = VK_FORMAT_BC1_RGB_UNORM_BLOCK; break;
+        case texture::BlockFormat::BC3: format = VK_FORMAT_BC3_UNORM_BLOCK; break;
+        case texture::BlockFormat::BC5: format = VK_FORMAT_BC5_UNORM_BLOCK; break;
+        case texture::BlockFormat::BC7: format = VK_FORMAT_BC7_UNORM_BLOCK; break;
+    }
+
+    texture::MipChain chain = texture::generateMipChain(
+        pixels.data(),
+        width,
+        height,
+        {
+            .filter = m_options.mipFilter,
+            .srgb = usage.srgb,
+            .alphaCutoff = usage.alphaCutoff
+        }
+    );
+
+    u32 mipLevels = static_cast<u32>(chain.levels.size());
+
+    TextureData texture;
+    texture.width = width;
+    texture.height = height;
+    texture.levelCount = mipLevels;
+
+    bool compress = m_options.compressTextures && m_device->isFormatSupported(
+        format,
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT |
+        VK_FORMAT_FEATURE_TRANSFER_DST_BIT
+    );
+
+    if (!compress) {
+        texture.data = std::move(chain.data);
+        texture.format = VK_FORMAT_R8G8B8A8_UNORM;
+        return texture;
+    }
+
+    usize encodedSize = 0;
+    for (const texture::MipLevel &level : chain.levels) {
+        encodedSize += texture::getEncodedSize(blockFormat, level.width, level.height);
+    }
+
+    std::vector<u8> encoded(encodedSize);
+    usize offset = 0;
+
+    for (const texture::MipLevel &level : chain.levels) {
+        texture::encode(
+            blockFormat,
+            chain.data.data() + level.offset,
+            level.width,
+            level.height,
+            encoded.data() + offset
+        );
+        offset += texture::getEncodedSize(blockFormat, level.width, level.height);
+    }
+
+    usize uncompressedSize = chain.data.size();
+
+    texture.data = std::move(encoded);
+    texture.format = format;
+
+    std::cout << "Texture compressed: " << width << "x" << height << ", "
+        << mipLevels << " levels, " << uncompressedSize / 1024 << " KiB -> "
+        << encodedSize / 1024 << " KiB" << std::endl;
+
+    return texture;
 }
 
 } // namespace gfx
\ No newline at end of file
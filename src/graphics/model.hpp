@@ -8,10 +8,66 @@
 #include "mesh.hpp"
 #include "image.hpp"
 #include "bindless_manager.hpp"
+#include "camera.hpp"
+#include "texture_streamer.hpp"
+#include "texture_cache.hpp"
+#include "texture/block_compression.hpp"
+#include "texture/mipmaps.hpp"
 
 namespace gfx
 {
 
+struct ModelLoadOptions
+{
+    bool weldVertices = true;
+    f32 weldEpsilon = 0.0f;
+
+    bool optimizeVertexCache = true;
+    bool optimizeOverdraw = false;
+    f32 overdrawThreshold = 1.05f;
+    bool optimizeVertexFetch = true;
+
+    // Packed vertices fall back to Float when any attribute would exceed
+    // its error bound. Position error is in model units.
+    VertexFormat vertexFormat = VertexFormat::Float;
+    f32 maxPositionError = 1e-3f;
+    f32 maxNormalError = 1e-3f;
+    f32 maxUVError = 1e-3f;
+
+    // Each level targets `lodReduction` of the previous triangle count;
+    // generation stops early once `lodMaxError` (relative to the mesh
+    // extent) is reached. `lodCount` includes the full detail level.
+    u32 lodCount = 4;
+    f32 lodReduction = 0.5f;
+    f32 lodMaxError = 0.05f;
+
+    // Coarsest level whose projected error stays below this many pixels
+    // is drawn.
+    f32 lodPixelThreshold = 1.0f;
+
+    // Clusters of the full detail level for the mesh shading path.
+    bool buildMeshlets = true;
+
+    // Block compress textures with a full mip chain when the device
+    // supports it: `colorTextureFormat` for color (BC1 becomes BC3 for
+    // textures with alpha) and BC5 for normal maps.
+    bool compressTextures = true;
+    texture::BlockFormat colorTextureFormat = texture::BlockFormat::BC7;
+
+    // Texture mips are built on the CPU, in linear space for color
+    // textures and keeping alpha test coverage for masked materials.
+    texture::MipFilter mipFilter = texture::MipFilter::Kaiser;
+
+    // Applied to glTF samplers with mipmapped minification, clamped to the
+    // device limit.
+    f32 maxAnisotropy = 16.0f;
+
+    // When the texture cache has a streamer, only the coarse levels are
+    // uploaded at load and finer ones follow the on-screen texel density
+    // of each mesh.
+    bool streamTextures = true;
+};
+
 class Model
 {
 
@@ -19,33 +75,175 @@ public:
     Model() = default;
     ~Model() = default;
 
+    // Without a shared texture cache the model keeps its own, so nothing
+    // is shared with other models.
     void load(
         Device &device,
         BindlessManager &bindlessManager,
-        const std::string &filepath
+        const std::string &filepath,
+        const ModelLoadOptions &options = {},
+        TextureCache *textureCache = nullptr
     );
 
     void destroy();
 
+    // For unloading while frames are in flight: GPU resources are
+    // released once those frames are done with them.
+    void deferDestroy();
+
     void draw(VkCommandBuffer cmd);
 
+    void draw(
+        VkCommandBuffer cmd,
+        const Camera &camera,
+        const glm::mat4 &transform,
+        f32 viewportHeight
+    );
+
+    // Draws through a vertex pulling pipeline; `pushOffset` is where the
+    // per-mesh Mesh::VertexPullPushConstants block starts.
+    void drawPulled(
+        VkCommandBuffer cmd,
+        Pipeline &pipeline,
+        u32 pushOffset,
+        const Camera &camera,
+        const glm::mat4 &transform,
+        f32 viewportHeight
+    );
+
+    // Draws through a task/mesh shader pipeline; `pushOffset` is where the
+    // per-mesh Mesh::MeshletPushConstants block starts.
+    void drawMeshlets(
+        VkCommandBuffer cmd,
+        Pipeline &pipeline,
+        u32 pushOffset
+    );
+
+    bool hasMeshlets() const;
+
+    // Requests streamed texture levels for the meshes as seen from
+    // `camera`; draw() with a camera does this on its own.
+    void requestTextures(
+        const Camera &camera,
+        const glm::mat4 &transform,
+        f32 viewportHeight
+    );
+
+public:
+    VertexFormat getVertexFormat() const { return m_vertexFormat; }
+
+    // Maps packed unorm positions back to model space; identity for Float.
+    glm::mat4 getDequantizeTransform() const;
+
 private:
+    struct Primitive
+    {
+        std::vector<Mesh::Vertex> vertices;
+        std::vector<u32> indices;
+        std::vector<Mesh::Lod> lods;
+        glm::vec4 boundingSphere = glm::vec4(0.0f);
+        geometry::MeshletData meshlets;
+        std::vector<geometry::MeshletBounds> meshletBounds;
+        u32 textureID = 0;
+        u32 textureIndex = 0;
+        f32 uvDensity = 0.0f;
+        bool twoSided = false;
+    };
+
+    struct TextureUsage
+    {
+        bool normalMap = false;
+        bool srgb = false;
+        f32 alphaCutoff = 0.0f;
+    };
+
+    // Tightly packed levels, largest first.
+    struct TextureData
+    {
+        std::vector<u8> data;
+        u32 width = 0;
+        u32 height = 0;
+        u32 levelCount = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+    };
+
     Device *m_device = nullptr;
     BindlessManager *m_bindlessManager = nullptr;
+    TextureCache *m_textureCache = nullptr;
+    TextureStreamer *m_textureStreamer = nullptr;
+
+    std::unique_ptr<TextureCache> m_ownedTextureCache;
+
+    ModelLoadOptions m_options;
+
+    VertexFormat m_vertexFormat = VertexFormat::Float;
+    glm::vec3 m_boundsMin = glm::vec3(0.0f);
+    glm::vec3 m_boundsExtent = glm::vec3(1.0f);
 
     std::vector<Mesh> m_meshes;
-    std::vector<Image> m_textures;
+
+    // Texture cache references, released on destroy().
+    std::vector<u32> m_textures;
+
+    // Streamer IDs indexed like the bindless texture IDs, ~0u for textures
+    // uploaded as a whole, and the texture index of each mesh.
+    std::vector<u32> m_textureStreams;
+    std::vector<u32> m_meshTextures;
+
+    void releaseTextures();
 
     void processMeshes(
         const tinygltf::Model &gltfModel,
         const std::vector<u32> &textureIDs
     );
 
+    void weldMesh(
+        std::vector<Mesh::Vertex> &vertices,
+        std::vector<u32> &indices
+    );
+
+    void optimizeMesh(
+        std::vector<Mesh::Vertex> &vertices,
+        std::vector<u32> &indices
+    );
+
+    void generateLods(Primitive &primitive);
+    void buildMeshlets(Primitive &primitive);
+
+    // Screen pixels covered by one model unit at the nearest point of the
+    // mesh bounds.
+    f32 getPixelsPerUnit(
+        const Mesh &mesh,
+        const Camera &camera,
+        const glm::mat4 &transform,
+        f32 viewportHeight
+    ) const;
+
+    u32 selectLod(const Mesh &mesh, f32 pixelsPerUnit) const;
+    void requestTexture(usize meshIndex, f32 pixelsPerUnit);
+
+    void createMeshes(std::vector<Primitive> &primitives);
+
+    bool packVertices(
+        const std::vector<Primitive> &primitives,
+        std::vector<std::vector<Mesh::PackedVertex>> &packed
+    );
+
     void processTextures(
         const tinygltf::Model &gltfModel,
         std::vector<u32> &textureIDs
     );
 
+    VkSampler getSampler(const tinygltf::Model &gltfModel, int samplerIndex) const;
+
+    TextureKey getTextureKey(
+        const tinygltf::Image &image,
+        const TextureUsage &usage,
+        VkSampler sampler
+    ) const;
+
+    TextureData createTexture(const tinygltf::Image &image, const TextureUsage &usage);
+
 };
 
 } // namespace gfx
\ No newline at end of file
@@ -3,10 +3,17 @@
 namespace gfx
 {
 
-void ModelManager::init(Device &device, BindlessManager &bindlessManager)
+void ModelManager::init(
+    Device &device,
+    BindlessManager &bindlessManager,
+    const TextureStreamerOptions &streamerOptions
+)
 {
     m_device = &device;
     m_bindlessManager = &bindlessManager;
+
+    m_textureStreamer.init(device, bindlessManager, streamerOptions);
+    m_textureCache.init(device, bindlessManager, &m_textureStreamer);
 }
 
 void ModelManager::destroy()
@@ -15,9 +22,20 @@ void ModelManager::destroy()
         model.second->destroy();
     }
     m_models.clear();
+
+    m_textureCache.destroy();
+    m_textureStreamer.destroy();
+}
+
+void ModelManager::update()
+{
+    m_textureStreamer.update();
 }
 
-u32 ModelManager::loadModel(const std::string &filepath)
+u32 ModelManager::loadModel(
+    const std::string &filepath,
+    const ModelLoadOptions &options
+)
 {
     auto it = m_pathToID.find(filepath);
     if (it != m_pathToID.end()) {
@@ -25,7 +43,13 @@ u32 ModelManager::loadModel(const std::string &filepath)
     }
 
     auto model = std::make_unique<Model>();
-    model->load(*m_device, *m_bindlessManager, filepath);
+    model->load(
+        *m_device,
+        *m_bindlessManager,
+        filepath,
+        options,
+        &m_textureCache
+    );
 
     u32 id = m_nextID++;
     m_models[id] = std::move(model);
@@ -34,6 +58,25 @@ u32 ModelManager::loadModel(const std::string &filepath)
     return id;
 }
 
+void ModelManager::unloadModel(u32 id)
+{
+    auto it = m_models.find(id);
+    if (it == m_models.end()) {
+        return;
+    }
+
+    it->second->deferDestroy();
+    m_models.erase(it);
+
+    for (auto pathIt = m_pathToID.begin(); pathIt != m_pathToID.end();) {
+        if (pathIt->second == id) {
+            pathIt = m_pathToID.erase(pathIt);
+        } else {
+            ++pathIt;
+        }
+    }
+}
+
 Model *ModelManager::getModel(u32 id)
 {
     auto it = m_models.find(id);
@@ -60,4 +103,60 @@ void ModelManager::drawModel(VkCommandBuffer cmd, u32 id)
     }
 }
 
+void ModelManager::drawModel(
+    VkCommandBuffer cmd,
+    u32 id,
+    const Camera &camera,
+    const glm::mat4 &transform,
+    f32 viewportHeight
+)
+{
+    auto model = getModel(id);
+    if (model) {
+        model->draw(cmd, camera, transform, viewportHeight);
+    }
+}
+
+void ModelManager::drawModelPulled(
+    VkCommandBuffer cmd,
+    u32 id,
+    Pipeline &pipeline,
+    u32 pushOffset,
+    const Camera &camera,
+    const glm::mat4 &transform,
+    f32 viewportHeight
+)
+{
+    auto model = getModel(id);
+    if (model) {
+        model->drawPulled(cmd, pipeline, pushOffset, camera, transform, viewportHeight);
+    }
+}
+
+void ModelManager::drawModelMeshlets(
+    VkCommandBuffer cmd,
+    u32 id,
+    Pipeline &pipeline,
+    u32 pushOffset
+)
+{
+    auto model = getModel(id);
+    if (model) {
+        model->drawMeshlets(cmd, pipeline, pushOffset);
+    }
+}
+
+void ModelManager::requestTextures(
+    u32 id,
+    const Camera &camera,
+    const glm::mat4 &transform,
+    f32 viewportHeight
+)
+{
+    auto model = getModel(id);
+    if (model) {
+        model->requestTextures(camera, transform, viewportHeight);
+    }
+}
+
 } // namespace gfx
\ No newline at end of file
@@ -15,19 +15,75 @@ public:
     ModelManager() = default;
     ~ModelManager() = default;
 
-    void init(Device &device, BindlessManager &bindlessManager);
+    void init(
+        Device &device,
+        BindlessManager &bindlessManager,
+        const TextureStreamerOptions &streamerOptions = {}
+    );
+
     void destroy();
 
-    u32 loadModel(const std::string &filepath);
+    // Streams texture levels requested by the previous frame's draws; call
+    // once per frame before the bindless descriptors are updated.
+    void update();
+
+    u32 loadModel(
+        const std::string &filepath,
+        const ModelLoadOptions &options = {}
+    );
+
+    // Safe while frames are in flight; the model's GPU resources go once
+    // those frames are done with them.
+    void unloadModel(u32 id);
 
     Model *getModel(u32 id);
     Model *getModel(const std::string &path);
 
     void drawModel(VkCommandBuffer cmd, u32 id);
 
+    void drawModel(
+        VkCommandBuffer cmd,
+        u32 id,
+        const Camera &camera,
+        const glm::mat4 &transform,
+        f32 viewportHeight
+    );
+
+    void drawModelPulled(
+        VkCommandBuffer cmd,
+        u32 id,
+        Pipeline &pipeline,
+        u32 pushOffset,
+        const Camera &camera,
+        const glm::mat4 &transform,
+        f32 viewportHeight
+    );
+
+    void drawModelMeshlets(
+        VkCommandBuffer cmd,
+        u32 id,
+        Pipeline &pipeline,
+        u32 pushOffset
+    );
+
+    void requestTextures(
+        u32 id,
+        const Camera &camera,
+        const glm::mat4 &transform,
+        f32 viewportHeight
+    );
+
+public:
+    TextureStreamer &getTextureStreamer() { return m_textureStreamer; }
+    TextureCache &getTextureCache() { return m_textureCache; }
+
 private:
     Device *m_device = nullptr;
     BindlessManager *m_bindlessManager = nullptr;
+    TextureStreamer m_textureStreamer;
+
+    // Shared by all models, so textures are deduplicated by content.
+    TextureCache m_textureCache;
 
     std::unordered_map<u32, std::unique_ptr<Model>> m_models;
     std::unordered_map<std::string, u32> m_pathToID;
@@ -1,4 +1,5 @@
 #include "pipeline.hpp"
+#include "device.hpp"
 
 namespace gfx
 {
@@ -61,8 +62,23 @@ Pipeline::Builder &Pipeline::Builder::setDepthWrite(bool enable)
     return *this;
 }
 
+Pipeline::Builder &Pipeline::Builder::addDescriptorSetLayout(
+    VkDescriptorSetLayout layout
+)
+{
+    m_descriptorSetLayouts.push_back(layout);
+    return *this;
+}
+
 Pipeline Pipeline::Builder::build()
 {
+    if (
+        m_shaderStages.size() == 1 &&
+        m_shaderStages[0].stage == VK_SHADER_STAGE_COMPUTE_BIT
+    ) {
+        return buildCompute();
+    }
+
     VkPipeline pipeline;
     VkPipelineLayout pipelineLayout;
 
@@ -134,26 +150,7 @@ Pipeline Pipeline::Builder::build()
     dynamicState.dynamicStateCount = static_cast<u32>(dynamicStates.size());
     dynamicState.pDynamicStates = dynamicStates.data();
 
-    auto &bindlessManager = m_device.getBindlessManager();
-    auto descriptorSetLayout = bindlessManager.getDescriptorSetLayout();
-
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-    pipelineLayoutInfo.pushConstantRangeCount = static_cast<u32>(
-        m_pushConstantRanges.size()
-    );
-    pipelineLayoutInfo.pPushConstantRanges = m_pushConstantRanges.data();
-
-    VkResult res = vkCreatePipelineLayout(
-        m_device.getDevice(),
-        &pipelineLayoutInfo,
-        nullptr,
-        &pipelineLayout
-    );
-
-    vk::check(res, "failed to create pipeline layout!");
+    pipelineLayout = createPipelineLayout();
 
     VkGraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -162,6 +159,14 @@ Pipeline Pipeline::Builder::build()
     pipelineInfo.pStages = m_shaderStages.data();
     pipelineInfo.pVertexInputState = &vertexInputInfo;
     pipelineInfo.pInputAssemblyState = &inputAssembly;
+
+    // Mesh shading pipelines have no vertex input or input assembly.
+    for (const auto &stage : m_shaderStages) {
+        if (stage.stage == VK_SHADER_STAGE_MESH_BIT_EXT) {
+            pipelineInfo.pVertexInputState = nullptr;
+            pipelineInfo.pInputAssemblyState = nullptr;
+        }
+    }
     pipelineInfo.pViewportState = &viewportState;
     pipelineInfo.pRasterizationState = &rasterizer;
     pipelineInfo.pMultisampleState = &multisampling;
@@ -173,7 +178,7 @@ Pipeline Pipeline::Builder::build()
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    res = vkCreateGraphicsPipelines(
+    VkResult res = vkCreateGraphicsPipelines(
         m_device.getDevice(),
         VK_NULL_HANDLE,
         1,
@@ -193,11 +198,81 @@ Pipeline Pipeline::Builder::build()
     pipelineObj.m_device = &m_device;
     pipelineObj.m_pipeline = pipeline;
     pipelineObj.m_pipelineLayout = pipelineLayout;
-    pipelineObj.m_descriptorSet = bindlessManager.getDescriptorSet();
+    pipelineObj.m_descriptorSet = m_device.getBindlessManager().getDescriptorSet();
 
     return pipelineObj;
 }
 
+Pipeline Pipeline::Builder::buildCompute()
+{
+    VkPipelineLayout pipelineLayout = createPipelineLayout();
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = m_shaderStages[0];
+    pipelineInfo.layout = pipelineLayout;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+    VkPipeline pipeline;
+    VkResult res = vkCreateComputePipelines(
+        m_device.getDevice(),
+        VK_NULL_HANDLE,
+        1,
+        &pipelineInfo,
+        nullptr,
+        &pipeline
+    );
+
+    vk::check(res, "failed to create compute pipeline!");
+
+    vkDestroyShaderModule(m_device.getDevice(), m_shaderStages[0].module, nullptr);
+
+    Pipeline pipelineObj;
+
+    pipelineObj.m_device = &m_device;
+    pipelineObj.m_pipeline = pipeline;
+    pipelineObj.m_pipelineLayout = pipelineLayout;
+    pipelineObj.m_descriptorSet = m_device.getBindlessManager().getDescriptorSet();
+    pipelineObj.m_bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+
+    return pipelineObj;
+}
+
+VkPipelineLayout Pipeline::Builder::createPipelineLayout()
+{
+    // The bindless set is always set 0; extra layouts follow it.
+    std::vector<VkDescriptorSetLayout> setLayouts = {
+        m_device.getBindlessManager().getDescriptorSetLayout()
+    };
+
+    setLayouts.insert(
+        setLayouts.end(),
+        m_descriptorSetLayouts.begin(),
+        m_descriptorSetLayouts.end()
+    );
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<u32>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<u32>(
+        m_pushConstantRanges.size()
+    );
+    pipelineLayoutInfo.pPushConstantRanges = m_pushConstantRanges.data();
+
+    VkPipelineLayout pipelineLayout;
+    VkResult res = vkCreatePipelineLayout(
+        m_device.getDevice(),
+        &pipelineLayoutInfo,
+        nullptr,
+        &pipelineLayout
+    );
+
+    vk::check(res, "failed to create pipeline layout!");
+
+    return pipelineLayout;
+}
+
 std::vector<char> Pipeline::Builder::readFile(const std::string &filename)
 {
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
@@ -243,13 +318,23 @@ void Pipeline::destroy()
     vkDestroyPipelineLayout(m_device->getDevice(), m_pipelineLayout, nullptr);
 }
 
+void Pipeline::deferDestroy()
+{
+    m_device->deferDestroy([pipeline = *this]() mutable {
+        pipeline.destroy();
+    });
+
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipelineLayout = VK_NULL_HANDLE;
+}
+
 void Pipeline::bind(VkCommandBuffer cmd)
 {
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+    vkCmdBindPipeline(cmd, m_bindPoint, m_pipeline);
 
     vkCmdBindDescriptorSets(
         cmd,
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        m_bindPoint,
         m_pipelineLayout,
         0,
         1,
@@ -259,19 +344,38 @@ void Pipeline::bind(VkCommandBuffer cmd)
     );
 }
 
+void Pipeline::bindDescriptorSet(
+    VkCommandBuffer cmd,
+    VkDescriptorSet descriptorSet,
+    u32 index
+)
+{
+    vkCmdBindDescriptorSets(
+        cmd,
+        m_bindPoint,
+        m_pipelineLayout,
+        index,
+        1,
+        &descriptorSet,
+        0,
+        nullptr
+    );
+}
+
 void Pipeline::push(
     VkCommandBuffer cmd,
-    VkShaderStageFlagBits stage,
+    VkShaderStageFlags stages,
     VkDeviceSize size,
-    void *data
+    const void *data,
+    u32 offset
 )
 {
     vkCmdPushConstants(
         cmd,
         m_pipelineLayout,
-        stage,
-        0,
-        size,
+        stages,
+        offset,
+        static_cast<u32>(size),
         data
     );
 }
@@ -6,12 +6,14 @@
 #include <vector>
 #include <fstream>
 
-#include "device.hpp"
+#include "core/types.hpp"
 #include "utils/utils.hpp"
 
 namespace gfx
 {
 
+class Device;
+
 struct VertexInput
 {
     VkVertexInputBindingDescription *binding = {};
@@ -36,6 +38,9 @@ public:
         Builder &addPushConstantRange(VkPushConstantRange range);
         Builder &setDepthTest(bool enable);
         Builder &setDepthWrite(bool enable);
+
+        // Bound after the bindless set, so the first one is set 1.
+        Builder &addDescriptorSetLayout(VkDescriptorSetLayout layout);
         
 
         Pipeline build();
@@ -55,6 +60,11 @@ public:
         bool m_depthTest = false;
         bool m_depthWrite = false;
 
+        std::vector<VkDescriptorSetLayout> m_descriptorSetLayouts;
+
+        Pipeline buildCompute();
+        VkPipelineLayout createPipelineLayout();
+
         std::vector<char> readFile(const std::string &filename);
         VkShaderModule createShaderModule(const std::vector<char> &code);
 
@@ -63,13 +73,23 @@ public:
     Pipeline() = default;
     void destroy();
 
+    // destroy() once the frames in flight are done with the pipeline.
+    void deferDestroy();
+
     void bind(VkCommandBuffer cmd);
 
+    void bindDescriptorSet(
+        VkCommandBuffer cmd,
+        VkDescriptorSet descriptorSet,
+        u32 index
+    );
+
     void push(
         VkCommandBuffer cmd,
-        VkShaderStageFlagBits stage,
+        VkShaderStageFlags stages,
         VkDeviceSize size,
-        void *data
+        const void *data,
+        u32 offset = 0
     );
 
 private:
@@ -79,6 +99,7 @@ private:
     VkPipeline m_pipeline;
     VkPipelineLayout m_pipelineLayout;
     VkDescriptorSet m_descriptorSet;
+    VkPipelineBindPoint m_bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 
 };
 
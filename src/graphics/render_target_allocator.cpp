@@ -0,0 +1,289 @@
+#include "render_target_allocator.hpp"
+#include "device.hpp"
+
+#include <algorithm>
+
+namespace gfx
+{
+
+void RenderTargetAllocator::init(Device &device)
+{
+    m_device = &device;
+
+    const VkPhysicalDeviceMemoryProperties *properties = nullptr;
+    vmaGetMemoryProperties(m_device->getAllocator(), &properties);
+
+    for (u32 i = 0; i < properties->memoryTypeCount; i++) {
+        if (properties->memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) {
+            m_hasLazyMemory = true;
+        }
+    }
+}
+
+void RenderTargetAllocator::destroy()
+{
+    release();
+
+    m_targets.clear();
+    m_freeIDs.clear();
+    m_isDirty = false;
+}
+
+u32 RenderTargetAllocator::add(const RenderTargetDesc &desc)
+{
+    Target target;
+    target.desc = desc;
+    target.isUsed = true;
+
+    m_isDirty = true;
+
+    if (!m_freeIDs.empty()) {
+        u32 id = m_freeIDs.back();
+        m_freeIDs.pop_back();
+
+        // The old image is still alive until the next build.
+        target.image = m_targets[id].image;
+        m_targets[id] = target;
+        return id;
+    }
+
+    m_targets.push_back(target);
+    return static_cast<u32>(m_targets.size() - 1);
+}
+
+void RenderTargetAllocator::resize(u32 id, u32 width, u32 height)
+{
+    RenderTargetDesc &desc = m_targets[id].desc;
+    if (desc.width == width && desc.height == height) {
+        return;
+    }
+
+    desc.width = width;
+    desc.height = height;
+    m_isDirty = true;
+}
+
+void RenderTargetAllocator::remove(u32 id)
+{
+    if (id >= m_targets.size() || !m_targets[id].isUsed) {
+        return;
+    }
+
+    m_targets[id].isUsed = false;
+    m_freeIDs.push_back(id);
+    m_isDirty = true;
+}
+
+void RenderTargetAllocator::build()
+{
+    if (!m_isDirty) {
+        return;
+    }
+
+    release();
+    m_isDirty = false;
+
+    struct Request
+    {
+        u32 id;
+        VkMemoryRequirements requirements;
+    };
+
+    std::vector<Request> requests;
+
+    for (u32 id = 0; id < m_targets.size(); id++) {
+        Target &target = m_targets[id];
+        if (!target.isUsed) {
+            continue;
+        }
+
+        const RenderTargetDesc &desc = target.desc;
+        VkImageUsageFlags usage = desc.usage;
+
+        if (isTransient(usage)) {
+            usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        }
+
+        if (isTransient(usage) && m_hasLazyMemory) {
+            target.image.init(
+                *m_device,
+                desc.width,
+                desc.height,
+                desc.format,
+                usage,
+                desc.aspectFlags,
+                1,
+                desc.samples,
+                VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED
+            );
+            continue;
+        }
+
+        target.image.initAliased(
+            *m_device,
+            desc.width,
+            desc.height,
+            desc.format,
+            usage,
+            desc.aspectFlags,
+            desc.samples
+        );
+
+        Request request{ id, {} };
+        vkGetImageMemoryRequirements(
+            m_device->getDevice(),
+            target.image.getImage(),
+            &request.requirements
+        );
+
+        m_unaliasedBytes += request.requirements.size;
+        requests.push_back(request);
+    }
+
+    // Largest first, so a slot is never smaller than a later occupant.
+    std::sort(requests.begin(), requests.end(), [](const Request &a, const Request &b) {
+        return a.requirements.size > b.requirements.size;
+    });
+
+    // A slot is a range of a block shared by targets that are never used
+    // in the same pass.
+    struct Slot
+    {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        std::vector<u32> ids;
+    };
+
+    struct Block
+    {
+        VkMemoryRequirements requirements{};
+        std::vector<Slot> slots;
+    };
+
+    std::vector<Block> blocks;
+
+    for (const Request &request : requests) {
+        const VkMemoryRequirements &requirements = request.requirements;
+        bool isPlaced = false;
+
+        for (Block &block : blocks) {
+            u32 memoryTypeBits = block.requirements.memoryTypeBits & requirements.memoryTypeBits;
+            if (!memoryTypeBits) {
+                continue;
+            }
+
+            for (Slot &slot : block.slots) {
+                if (
+                    slot.size < requirements.size ||
+                    slot.offset % requirements.alignment != 0
+                ) {
+                    continue;
+                }
+
+                bool isFree = std::none_of(slot.ids.begin(), slot.ids.end(), [&](u32 id) {
+                    return overlaps(id, request.id);
+                });
+
+                if (isFree) {
+                    slot.ids.push_back(request.id);
+                    isPlaced = true;
+                    break;
+                }
+            }
+
+            if (!isPlaced) {
+                Slot slot;
+                slot.offset = (block.requirements.size + requirements.alignment - 1) /
+                    requirements.alignment * requirements.alignment;
+                slot.size = requirements.size;
+                slot.ids.push_back(request.id);
+
+                block.requirements.size = slot.offset + slot.size;
+                block.slots.push_back(slot);
+                isPlaced = true;
+            }
+
+            block.requirements.alignment = std::max(
+                block.requirements.alignment,
+                requirements.alignment
+            );
+            block.requirements.memoryTypeBits = memoryTypeBits;
+            break;
+        }
+
+        if (!isPlaced) {
+            Block block;
+            block.requirements = requirements;
+            block.slots.push_back({ 0, requirements.size, { request.id } });
+            blocks.push_back(block);
+        }
+    }
+
+    // Dedicated, so the defragmenter never sees the blocks.
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    for (const Block &block : blocks) {
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        VkResult res = vmaAllocateMemory(
+            m_device->getAllocator(),
+            &block.requirements,
+            &allocInfo,
+            &allocation,
+            nullptr
+        );
+
+        vk::check(res, "Failed to allocate render target memory!");
+
+        m_device->getMemoryBudget().track(allocation, MemoryBudget::Category::RenderTarget);
+        m_allocations.push_back(allocation);
+        m_aliasedBytes += block.requirements.size;
+
+        for (const Slot &slot : block.slots) {
+            for (u32 id : slot.ids) {
+                m_targets[id].image.bindMemory(allocation, slot.offset);
+            }
+        }
+    }
+}
+
+void RenderTargetAllocator::release()
+{
+    for (Target &target : m_targets) {
+        if (target.image.getImage()) {
+            target.image.destroy();
+            target.image = Image{};
+        }
+    }
+
+    for (VmaAllocation allocation : m_allocations) {
+        m_device->getMemoryBudget().untrack(allocation);
+        vmaFreeMemory(m_device->getAllocator(), allocation);
+    }
+
+    m_allocations.clear();
+    m_aliasedBytes = 0;
+    m_unaliasedBytes = 0;
+}
+
+bool RenderTargetAllocator::overlaps(u32 a, u32 b) const
+{
+    const RenderTargetDesc &first = m_targets[a].desc;
+    const RenderTargetDesc &second = m_targets[b].desc;
+
+    return first.firstPass <= second.lastPass && second.firstPass <= first.lastPass;
+}
+
+bool RenderTargetAllocator::isTransient(VkImageUsageFlags usage)
+{
+    VkImageUsageFlags attachment =
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+        VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT |
+        VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+    return usage != 0 && (usage & ~attachment) == 0;
+}
+
+} // namespace gfx
\ No newline at end of file
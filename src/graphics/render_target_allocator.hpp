@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include <vector>
+
+#include "core/types.hpp"
+#include "image.hpp"
+
+namespace gfx
+{
+
+class Device;
+
+struct RenderTargetDesc
+{
+    u32 width = 0;
+    u32 height = 0;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkImageUsageFlags usage = 0;
+    VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+    // First and last pass of the frame that use the target. Targets whose
+    // ranges do not overlap may share memory.
+    u32 firstPass = 0;
+    u32 lastPass = ~0u;
+};
+
+// Owns the images and memory of render targets, which are rebuilt
+// together by build().
+//
+// Targets used only as attachments are transient: they get lazily
+// allocated memory where the device has it, which tile based GPUs only
+// back on chip. All other targets share memory with targets whose pass
+// ranges do not overlap theirs, so their contents are undefined when
+// their first pass begins; they are transitioned from the undefined
+// layout every frame.
+class RenderTargetAllocator
+{
+
+public:
+    RenderTargetAllocator() = default;
+    ~RenderTargetAllocator() = default;
+
+    void init(Device &device);
+    void destroy();
+
+    // The image exists after the next build().
+    u32 add(const RenderTargetDesc &desc);
+    void resize(u32 id, u32 width, u32 height);
+    void remove(u32 id);
+
+    // Recreates every target if any was added, resized or removed since
+    // the last build. The device must be idle.
+    void build();
+
+public:
+    Image &getImage(u32 id) { return m_targets[id].image; }
+    const Image &getImage(u32 id) const { return m_targets[id].image; }
+    const RenderTargetDesc &getDesc(u32 id) const { return m_targets[id].desc; }
+
+    bool hasLazyMemory() const { return m_hasLazyMemory; }
+
+    // Memory of the shared blocks, and what the same targets would take
+    // with one allocation each.
+    VkDeviceSize getAliasedBytes() const { return m_aliasedBytes; }
+    VkDeviceSize getUnaliasedBytes() const { return m_unaliasedBytes; }
+
+private:
+    struct Target
+    {
+        RenderTargetDesc desc;
+        Image image;
+        bool isUsed = false;
+    };
+
+    Device *m_device = nullptr;
+
+    std::vector<Target> m_targets;
+    std::vector<u32> m_freeIDs;
+    std::vector<VmaAllocation> m_allocations;
+
+    bool m_hasLazyMemory = false;
+    bool m_isDirty = false;
+
+    VkDeviceSize m_aliasedBytes = 0;
+    VkDeviceSize m_unaliasedBytes = 0;
+
+    void release();
+
+    bool overlaps(u32 a, u32 b) const;
+    static bool isTransient(VkImageUsageFlags usage);
+
+};
+
+} // namespace gfx
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "sampler_cache.hpp"
+#include "device.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace gfx
+{
+
+namespace
+{
+
+u32 getFloatBits(f32 value)
+{
+    u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+usize SamplerCache::KeyHash::operator()(const Key &key) const
+{
+    u32 words[] = {
+        key.flags,
+        static_cast<u32>(key.magFilter),
+        static_cast<u32>(key.minFilter),
+        static_cast<u32>(key.mipmapMode),
+        static_cast<u32>(key.addressModeU),
+        static_cast<u32>(key.addressModeV),
+        static_cast<u32>(key.addressModeW),
+        getFloatBits(key.mipLodBias),
+        getFloatBits(key.maxAnisotropy),
+        key.compareEnable,
+        static_cast<u32>(key.compareOp),
+        getFloatBits(key.minLod),
+        getFloatBits(key.maxLod),
+        static_cast<u32>(key.borderColor),
+        key.unnormalizedCoordinates
+    };
+
+    u32 hash = 2166136261u;
+    for (u32 word : words) {
+        hash ^= word;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+void SamplerCache::init(Device &device)
+{
+    m_device = &device;
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
+
+    m_maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+}
+
+void SamplerCache::destroy()
+{
+    for (auto &entry : m_samplers) {
+        vkDestroySampler(m_device->getDevice(), entry.second, nullptr);
+    }
+
+    m_samplers.clear();
+}
+
+VkSampler SamplerCache::getSampler(const VkSamplerCreateInfo &createInfo)
+{
+    if (createInfo.pNext) {
+        throw std::runtime_error("Sampler create info chains are not cached.");
+    }
+
+    // Equivalent states map to one key, so they share a sampler.
+    f32 maxAnisotropy = createInfo.anisotropyEnable
+        ? std::min(createInfo.maxAnisotropy, m_maxAnisotropy)
+        : 0.0f;
+
+    if (maxAnisotropy <= 1.0f) {
+        maxAnisotropy = 0.0f;
+    }
+
+    Key key;
+    key.flags = createInfo.flags;
+    key.magFilter = createInfo.magFilter;
+    key.minFilter = createInfo.minFilter;
+    key.mipmapMode = createInfo.mipmapMode;
+    key.addressModeU = createInfo.addressModeU;
+    key.addressModeV = createInfo.addressModeV;
+    key.addressModeW = createInfo.addressModeW;
+    key.mipLodBias = createInfo.mipLodBias;
+    key.maxAnisotropy = maxAnisotropy;
+    key.compareEnable = createInfo.compareEnable;
+    key.compareOp = createInfo.compareEnable ? createInfo.compareOp : VK_COMPARE_OP_NEVER;
+    key.minLod = createInfo.minLod;
+    key.maxLod = createInfo.maxLod;
+    key.borderColor = createInfo.borderColor;
+    key.unnormalizedCoordinates = createInfo.unnormalizedCoordinates;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_samplers.find(key);
+    if (it != m_samplers.end()) {
+        return it->second;
+    }
+
+    VkSamplerCreateInfo samplerInfo = createInfo;
+    samplerInfo.anisotropyEnable = maxAnisotropy > 0.0f;
+    samplerInfo.maxAnisotropy = std::max(maxAnisotropy, 1.0f);
+    samplerInfo.compareOp = key.compareOp;
+
+    VkSampler sampler;
+    VkResult res = vkCreateSampler(m_device->getDevice(), &samplerInfo, nullptr, &sampler);
+
+    vk::check(res, "Failed to create texture sampler");
+
+    m_samplers[key] = sampler;
+
+    return sampler;
+}
+
+} // namespace gfx
\ No newline at end of file
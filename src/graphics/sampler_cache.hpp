@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <mutex>
+#include <unordered_map>
+
+#include "core/types.hpp"
+
+namespace gfx
+{
+
+class Device;
+
+// Every sampler of the device, shared by all users with the same state.
+// Drivers allow only a few thousand samplers, while materials tend to
+// repeat a handful of combinations.
+class SamplerCache
+{
+
+public:
+    SamplerCache() = default;
+    ~SamplerCache() = default;
+
+    void init(Device &device);
+    void destroy();
+
+    // `pNext` chains are not supported. Anisotropy is clamped to the device
+    // limit and disabled at 1 or below. The cache owns the sampler.
+    VkSampler getSampler(const VkSamplerCreateInfo &createInfo);
+
+public:
+    f32 getMaxAnisotropy() const { return m_maxAnisotropy; }
+    u32 getSamplerCount() const { return static_cast<u32>(m_samplers.size()); }
+
+private:
+    struct Key
+    {
+        VkSamplerCreateFlags flags = 0;
+        VkFilter magFilter = VK_FILTER_NEAREST;
+        VkFilter minFilter = VK_FILTER_NEAREST;
+        VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        VkSamplerAddressMode addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        VkSamplerAddressMode addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        VkSamplerAddressMode addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        f32 mipLodBias = 0.0f;
+        f32 maxAnisotropy = 0.0f;
+        VkBool32 compareEnable = VK_FALSE;
+        VkCompareOp compareOp = VK_COMPARE_OP_NEVER;
+        f32 minLod = 0.0f;
+        f32 maxLod = 0.0f;
+        VkBorderColor borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+        VkBool32 unnormalizedCoordinates = VK_FALSE;
+
+        bool operator==(const Key &other) const
+        {
+            return flags == other.flags &&
+                magFilter == other.magFilter &&
+                minFilter == other.minFilter &&
+                mipmapMode == other.mipmapMode &&
+                addressModeU == other.addressModeU &&
+                addressModeV == other.addressModeV &&
+                addressModeW == other.addressModeW &&
+                mipLodBias == other.mipLodBias &&
+                maxAnisotropy == other.maxAnisotropy &&
+                compareEnable == other.compareEnable &&
+                compareOp == other.compareOp &&
+                minLod == other.minLod &&
+                maxLod == other.maxLod &&
+                borderColor == other.borderColor &&
+                unnormalizedCoordinates == other.unnormalizedCoordinates;
+        }
+    };
+
+    struct KeyHash
+    {
+        usize operator()(const Key &key) const;
+    };
+
+    Device *m_device = nullptr;
+    f32 m_maxAnisotropy = 1.0f;
+
+    std::unordered_map<Key, VkSampler, KeyHash> m_samplers;
+    std::mutex m_mutex;
+
+};
+
+} // namespace gfx
\ No newline at end of file
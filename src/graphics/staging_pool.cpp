@@ -0,0 +1,202 @@
+#include "staging_pool.hpp"
+#include "device.hpp"
+
+#include <algorithm>
+
+namespace gfx
+{
+
+void StagingPool::init(Device &device, VkDeviceSize capacity)
+{
+    m_device = &device;
+    m_capacity = capacity;
+
+    m_buffer.init(
+        device,
+        capacity,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VMA_MEMORY_USAGE_AUTO,
+        Buffer::HostAccess::SequentialWrite
+    );
+
+    m_data = static_cast<u8 *>(m_buffer.map());
+}
+
+void StagingPool::destroy()
+{
+    // The device is idle by now.
+    for (Dedicated &dedicated : m_dedicated) {
+        dedicated.buffer->destroy();
+    }
+
+    m_regions.clear();
+    m_dedicated.clear();
+
+    m_buffer.destroy();
+    m_data = nullptr;
+
+    m_head = 0;
+    m_tail = 0;
+    m_used = 0;
+}
+
+StagingAllocation StagingPool::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto allocateDedicated = [&]() {
+        auto buffer = std::make_unique<Buffer>();
+        buffer->init(
+            *m_device,
+            size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_AUTO,
+            Buffer::HostAccess::SequentialWrite
+        );
+
+        StagingAllocation allocation;
+        allocation.buffer = buffer->getBuffer();
+        allocation.size = size;
+        allocation.data = static_cast<u8 *>(buffer->map());
+
+        Dedicated dedicated;
+        dedicated.thread = std::this_thread::get_id();
+        dedicated.buffer = std::move(buffer);
+        m_dedicated.push_back(std::move(dedicated));
+
+        return allocation;
+    };
+
+    if (size > m_capacity / 2) {
+        return allocateDedicated();
+    }
+
+    reclaim(false);
+
+    Region region;
+    while (!tryAllocate(size, alignment, region)) {
+        // The oldest region is not submitted yet, nothing to wait for.
+        if (m_regions.empty() || m_regions.front().value == 0) {
+            return allocateDedicated();
+        }
+
+        reclaim(true);
+    }
+
+    region.thread = std::this_thread::get_id();
+    m_regions.push_back(region);
+
+    StagingAllocation allocation;
+    allocation.buffer = m_buffer.getBuffer();
+    allocation.offset = region.offset;
+    allocation.size = size;
+    allocation.data = m_data + region.offset;
+
+    return allocation;
+}
+
+void StagingPool::submit(u64 value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::thread::id thread = std::this_thread::get_id();
+
+    for (Region &region : m_regions) {
+        if (region.value == 0 && region.thread == thread) {
+            m_buffer.flush(region.offset, region.size);
+            region.value = value;
+        }
+    }
+
+    for (Dedicated &dedicated : m_dedicated) {
+        if (dedicated.value == 0 && dedicated.thread == thread) {
+            dedicated.buffer->flush();
+            dedicated.value = value;
+        }
+    }
+}
+
+void StagingPool::reclaim(bool wait)
+{
+    // The ring is released from the tail, so a region waits for every
+    // older one even when its own submit finished first.
+    while (!m_regions.empty()) {
+        Region &region = m_regions.front();
+
+        if (region.value == 0) {
+            break;
+        }
+
+        if (!m_device->isComplete(region.value)) {
+            if (!wait) {
+                break;
+            }
+
+            m_device->wait(region.value);
+            wait = false;
+        }
+
+        m_tail = region.end;
+        m_used -= region.bytes;
+
+        m_regions.pop_front();
+    }
+
+    auto release = [&](Dedicated &dedicated) {
+        if (dedicated.value == 0 || !m_device->isComplete(dedicated.value)) {
+            return false;
+        }
+
+        dedicated.buffer->destroy();
+        return true;
+    };
+
+    m_dedicated.erase(
+        std::remove_if(m_dedicated.begin(), m_dedicated.end(), release),
+        m_dedicated.end()
+    );
+}
+
+bool StagingPool::tryAllocate(VkDeviceSize size, VkDeviceSize alignment, Region &region)
+{
+    if (m_used == 0) {
+        m_head = 0;
+        m_tail = 0;
+    }
+
+    VkDeviceSize aligned = (m_head + alignment - 1) / alignment * alignment;
+    VkDeviceSize offset = 0;
+
+    if (m_used == 0 || m_head > m_tail) {
+        if (aligned + size <= m_capacity) {
+            offset = aligned;
+        } else if (size <= m_tail) {
+            // The rest of the ring is skipped and released with this region.
+            offset = 0;
+        } else {
+            return false;
+        }
+    } else if (m_head < m_tail && aligned + size <= m_tail) {
+        offset = aligned;
+    } else {
+        return false;
+    }
+
+    VkDeviceSize end = offset + size;
+
+    VkDeviceSize consumed = offset >= m_head
+        ? end - m_head
+        : (m_capacity - m_head) + end;
+
+    region.offset = offset;
+    region.size = size;
+    region.end = end;
+    region.bytes = consumed;
+
+    m_head = end;
+    m_used += consumed;
+
+    return true;
+}
+
+} // namespace gfx
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/types.hpp"
+#include "buffer.hpp"
+
+namespace gfx
+{
+
+class Device;
+
+struct StagingAllocation
+{
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    u8 *data = nullptr;
+};
+
+// Upload memory for every transfer from the host. Regions are carved out
+// of one persistently mapped ring buffer and handed back once the submit
+// that read them has finished, so loading does not create and destroy a
+// staging buffer per upload. Requests too large for the ring get a
+// buffer of their own with the same lifetime.
+//
+// Allocations belong to the next Device::submit() made on the thread that
+// allocated them, which calls submit() here with its timeline value. Each
+// thread records and submits its own uploads, so allocate right before
+// recording the copies that read the region, with no unrelated submit on
+// the same thread in between.
+class StagingPool
+{
+
+public:
+    StagingPool() = default;
+    ~StagingPool() = default;
+
+    void init(Device &device, VkDeviceSize capacity = 64ull << 20);
+    void destroy();
+
+    // Waits for older submits when the ring is full.
+    StagingAllocation allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+    // Flushes the calling thread's allocations made since its last submit
+    // and releases them once the device timeline reaches `value`.
+    void submit(u64 value);
+
+public:
+    VkDeviceSize getCapacity() const { return m_capacity; }
+    VkDeviceSize getUsedBytes() const { return m_used; }
+
+private:
+    // A value of 0 means the owning thread has not submitted it yet.
+    struct Region
+    {
+        std::thread::id thread;
+        u64 value = 0;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        VkDeviceSize end = 0;
+        VkDeviceSize bytes = 0;
+    };
+
+    struct Dedicated
+    {
+        std::thread::id thread;
+        u64 value = 0;
+        std::unique_ptr<Buffer> buffer;
+    };
+
+    Device *m_device = nullptr;
+
+    Buffer m_buffer;
+    u8 *m_data = nullptr;
+    VkDeviceSize m_capacity = 0;
+
+    // Regions in use run from m_tail to m_head, wrapping at m_capacity.
+    VkDeviceSize m_head = 0;
+    VkDeviceSize m_tail = 0;
+    VkDeviceSize m_used = 0;
+
+    // Ring regions in allocation order; released from the front.
+    std::deque<Region> m_regions;
+    std::vector<Dedicated> m_dedicated;
+    std::mutex m_mutex;
+
+    void reclaim(bool wait);
+    bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, Region &region);
+
+};
+
+} // namespace gfx
\ No newline at end of file
@@ -42,10 +42,6 @@ void Swapchain::init(
     for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         m_frames[i].imageSemaphore = vk::createSemaphore(device);
         m_frames[i].renderSemaphore = vk::createSemaphore(device);
-        m_frames[i].renderFence = vk::createFence(
-            device,
-            VK_FENCE_CREATE_SIGNALED_BIT
-        );
     }
 }
 
@@ -54,7 +50,6 @@ void Swapchain::destroy()
     for (auto frame : m_frames) {
         vkDestroySemaphore(m_device, frame.imageSemaphore, nullptr);
         vkDestroySemaphore(m_device, frame.renderSemaphore, nullptr);
-        vkDestroyFence(m_device, frame.renderFence, nullptr);
     }
 
     for (auto imageView : m_imageViews) {
@@ -99,29 +94,11 @@ void Swapchain::recreate(u32 width, u32 height)
     m_outOfDate = false;
 }
 
-void Swapchain::beginFrame(u32 &currentFrame)
-{
-    auto &frame = m_frames[currentFrame];
-
-    VkResult res = vkWaitForFences(
-        m_device,
-        1,
-        &frame.renderFence,
-        VK_TRUE,
-        U64_MAX
-    );
-
-    vk::check(res, "Failed to wait for fence.");
-}
-
 std::pair<u32, VkImage> Swapchain::acquireNextImage(u32 currentFrame)
 {
     auto &frame = m_frames[currentFrame];
 
-    VkResult res = vkResetFences(m_device, 1, &frame.renderFence);
-    vk::check(res, "Failed to reset fence.");
-
-    res = vkAcquireNextImageKHR(
+    VkResult res = vkAcquireNextImageKHR(
         m_device,
         m_swapchain,
         U64_MAX,
@@ -140,44 +117,6 @@ std::pair<u32, VkImage> Swapchain::acquireNextImage(u32 currentFrame)
     return {m_imageIndex, m_images[m_imageIndex]};
 }
 
-void Swapchain::submit(
-    u32 currentFrame,
-    VkCommandBuffer commandBuffer,
-    VkQueue graphicsQueue
-)
-{
-    if (m_outOfDate) {
-        return;
-    }
-
-    auto &frame = m_frames[currentFrame];
-
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-    VkSemaphore waitSemaphores[] = {frame.imageSemaphore};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    VkSemaphore signalSemaphores[] = {frame.renderSemaphore};
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
-
-    VkResult res = vkQueueSubmit(
-        graphicsQueue,
-        1,
-        &submitInfo,
-        frame.renderFence
-    );
-
-    vk::check(res, "Failed to submit draw command buffer.");
-}
-
 void Swapchain::present(u32 currentFrame, VkQueue presentQueue)
 {
     if (m_outOfDate) {
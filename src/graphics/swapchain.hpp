@@ -31,12 +31,7 @@ public:
 
     void recreate(u32 width, u32 height);
 
-    void beginFrame(u32 &currentFrame);
     std::pair<u32, VkImage> acquireNextImage(u32 currentFrame);
-    void submit(u32 currentFrame,
-        VkCommandBuffer commandBuffer,
-        VkQueue graphicsQueue
-    );
     void present(u32 currentFrame, VkQueue presentQueue);
 
 public:
@@ -47,12 +42,17 @@ public:
     VkExtent2D getExtent() const { return m_extent; }
     bool isOutOfDate() const { return m_outOfDate; }
 
+    // Signaled by acquireNextImage(); the frame's submit waits on it.
+    VkSemaphore getImageSemaphore(u32 frame) const { return m_frames[frame].imageSemaphore; }
+
+    // Signaled by the frame's submit; present() waits on it.
+    VkSemaphore getRenderSemaphore(u32 frame) const { return m_frames[frame].renderSemaphore; }
+
 private:
     struct FrameData
     {
         VkSemaphore imageSemaphore = VK_NULL_HANDLE;
         VkSemaphore renderSemaphore = VK_NULL_HANDLE;
-        VkFence renderFence = VK_NULL_HANDLE;
     };
 
 private:
@@ -0,0 +1,637 @@
+#include "block_compression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace gfx::texture
+{
+
+namespace
+{
+
+constexpr u32 BLOCK_PIXELS = BLOCK_DIMENSION * BLOCK_DIMENSION;
+constexpr u32 REFINE_ITERATIONS = 3;
+
+constexpr u32 BC7_WEIGHTS[16] = {
+    0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+};
+
+struct Block
+{
+    u8 pixels[BLOCK_PIXELS][4];
+};
+
+void loadBlock(
+    const u8 *pixels,
+    u32 width,
+    u32 height,
+    u32 blockX,
+    u32 blockY,
+    Block &block
+)
+{
+    for (u32 y = 0; y < BLOCK_DIMENSION; y++) {
+        u32 sy = std::min(blockY * BLOCK_DIMENSION + y, height - 1);
+        for (u32 x = 0; x < BLOCK_DIMENSION; x++) {
+            u32 sx = std::min(blockX * BLOCK_DIMENSION + x, width - 1);
+            std::memcpy(
+                block.pixels[y * BLOCK_DIMENSION + x],
+                pixels + (static_cast<usize>(sy) * width + sx) * 4,
+                4
+            );
+        }
+    }
+}
+
+// Dominant direction of the first `channels` components by power iteration
+// on the covariance matrix. The axis is zero for single-color blocks.
+void computePrincipalAxis(
+    const f32 (*points)[4],
+    u32 channels,
+    f32 mean[4],
+    f32 axis[4]
+)
+{
+    for (u32 c = 0; c < 4; c++) {
+        mean[c] = 0.0f;
+        axis[c] = 0.0f;
+    }
+
+    for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+        for (u32 c = 0; c < channels; c++) {
+            mean[c] += points[i][c];
+        }
+    }
+
+    for (u32 c = 0; c < channels; c++) {
+        mean[c] /= BLOCK_PIXELS;
+    }
+
+    f32 covariance[4][4] = {};
+    for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+        for (u32 a = 0; a < channels; a++) {
+            f32 da = points[i][a] - mean[a];
+            for (u32 b = 0; b < channels; b++) {
+                covariance[a][b] += da * (points[i][b] - mean[b]);
+            }
+        }
+    }
+
+    // Start from the column of the largest variance so the iteration does
+    // not begin orthogonal to the answer.
+    u32 start = 0;
+    for (u32 c = 1; c < channels; c++) {
+        if (covariance[c][c] > covariance[start][start]) {
+            start = c;
+        }
+    }
+
+    if (covariance[start][start] <= 0.0f) {
+        return;
+    }
+
+    f32 v[4] = {};
+    for (u32 c = 0; c < channels; c++) {
+        v[c] = covariance[c][start];
+    }
+
+    for (u32 iteration = 0; iteration < 8; iteration++) {
+        f32 next[4] = {};
+        f32 largest = 0.0f;
+
+        for (u32 a = 0; a < channels; a++) {
+            for (u32 b = 0; b < channels; b++) {
+                next[a] += covariance[a][b] * v[b];
+            }
+            largest = std::max(largest, std::abs(next[a]));
+        }
+
+        if (largest <= 0.0f) {
+            return;
+        }
+
+        for (u32 c = 0; c < channels; c++) {
+            v[c] = next[c] / largest;
+        }
+    }
+
+    f32 length = 0.0f;
+    for (u32 c = 0; c < channels; c++) {
+        length += v[c] * v[c];
+    }
+    length = std::sqrt(length);
+
+    for (u32 c = 0; c < channels; c++) {
+        axis[c] = v[c] / length;
+    }
+}
+
+// Endpoints spanning the block along its principal axis.
+void computeEndpoints(
+    const f32 (*points)[4],
+    u32 channels,
+    f32 e0[4],
+    f32 e1[4]
+)
+{
+    f32 mean[4];
+    f32 axis[4];
+    computePrincipalAxis(points, channels, mean, axis);
+
+    f32 minT = 0.0f;
+    f32 maxT = 0.0f;
+    for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+        f32 t = 0.0f;
+        for (u32 c = 0; c < channels; c++) {
+            t += (points[i][c] - mean[c]) * axis[c];
+        }
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+
+    for (u32 c = 0; c < 4; c++) {
+        e0[c] = mean[c] + axis[c] * minT;
+        e1[c] = mean[c] + axis[c] * maxT;
+    }
+}
+
+// Least squares endpoints for fixed interpolation weights, where pixel i
+// reconstructs as (1 - weights[i]) * e0 + weights[i] * e1. Returns false
+// when every pixel uses the same weight.
+bool solveEndpoints(
+    const f32 (*points)[4],
+    u32 channels,
+    const f32 *weights,
+    f32 e0[4],
+    f32 e1[4]
+)
+{
+    f32 aa = 0.0f;
+    f32 ab = 0.0f;
+    f32 bb = 0.0f;
+    f32 ax[4] = {};
+    f32 bx[4] = {};
+
+    for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+        f32 b = weights[i];
+        f32 a = 1.0f - b;
+
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+
+        for (u32 c = 0; c < channels; c++) {
+            ax[c] += a * points[i][c];
+            bx[c] += b * points[i][c];
+        }
+    }
+
+    f32 determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f) {
+        return false;
+    }
+
+    f32 inverse = 1.0f / determinant;
+    for (u32 c = 0; c < channels; c++) {
+        e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) * inverse, 0.0f, 255.0f);
+        e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) * inverse, 0.0f, 255.0f);
+    }
+
+    return true;
+}
+
+u16 packRgb565(const f32 color[3])
+{
+    u32 r = static_cast<u32>(std::clamp(std::round(color[0] * 31.0f / 255.0f), 0.0f, 31.0f));
+    u32 g = static_cast<u32>(std::clamp(std::round(color[1] * 63.0f / 255.0f), 0.0f, 63.0f));
+    u32 b = static_cast<u32>(std::clamp(std::round(color[2] * 31.0f / 255.0f), 0.0f, 31.0f));
+
+    return static_cast<u16>((r << 11) | (g << 5) | b);
+}
+
+void unpackRgb565(u16 value, i32 color[3])
+{
+    i32 r = (value >> 11) & 31;
+    i32 g = (value >> 5) & 63;
+    i32 b = value & 31;
+
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// Assigns the nearest of the four palette entries of a `c0 > c1` block and
+// returns the squared error.
+u32 fitBC1Indices(const Block &block, u16 c0, u16 c1, u8 indices[BLOCK_PIXELS])
+{
+    i32 palette[4][3];
+    unpackRgb565(c0, palette[0]);
+    unpackRgb565(c1, palette[1]);
+
+    for (u32 c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    u32 error = 0;
+    for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+        u32 best = U32_MAX;
+        for (u32 p = 0; p < 4; p++) {
+            u32 distance = 0;
+            for (u32 c = 0; c < 3; c++) {
+                i32 d = static_cast<i32>(block.pixels[i][c]) - palette[p][c];
+                distance += static_cast<u32>(d * d);
+            }
+
+            if (distance < best) {
+                best = distance;
+                indices[i] = static_cast<u8>(p);
+            }
+        }
+        error += best;
+    }
+
+    return error;
+}
+
+// Always produces a four color block (c0 > c1, or c0 == c1 with every
+// index 0) so the result is also valid as the color half of BC3.
+void encodeBC1Color(const Block &block, u8 *dst)
+{
+    constexpr f32 WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+    f32 points[BLOCK_PIXELS][4];
+    for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+        for (u32 c = 0; c < 4; c++) {
+            points[i][c] = block.pixels[i][c];
+        }
+    }
+
+    f32 e0[4];
+    f32 e1[4];
+    computeEndpoints(points, 3, e0, e1);
+
+    u16 bestC0 = 0;
+    u16 bestC1 = 0;
+    u8 bestIndices[BLOCK_PIXELS] = {};
+    u32 bestError = U32_MAX;
+
+    for (u32 iteration = 0; iteration < REFINE_ITERATIONS; iteration++) {
+        u16 c0 = packRgb565(e0);
+        u16 c1 = packRgb565(e1);
+        if (c0 < c1) {
+            std::swap(c0, c1);
+        }
+
+        u8 indices[BLOCK_PIXELS] = {};
+        u32 error = fitBC1Indices(block, c0, c1, indices);
+
+        // Equal endpoints select three color mode, where index 3 means
+        // transparent; every palette entry is c0 anyway.
+        if (c0 == c1) {
+            std::memset(indices, 0, sizeof(indices));
+        }
+
+        if (error >= bestError) {
+            break;
+        }
+
+        bestError = error;
+        bestC0 = c0;
+        bestC1 = c1;
+        std::memcpy(bestIndices, indices, sizeof(indices));
+
+        if (error == 0 || c0 == c1) {
+            break;
+        }
+
+        f32 weights[BLOCK_PIXELS];
+        for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+            weights[i] = WEIGHTS[indices[i]];
+        }
+
+        if (!solveEndpoints(points, 3, weights, e0, e1)) {
+            break;
+        }
+    }
+
+    u32 indexBits = 0;
+    for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+        indexBits |= static_cast<u32>(bestIndices[i]) << (i * 2);
+    }
+
+    dst[0] = static_cast<u8>(bestC0);
+    dst[1] = static_cast<u8>(bestC0 >> 8);
+    dst[2] = static_cast<u8>(bestC1);
+    dst[3] = static_cast<u8>(bestC1 >> 8);
+    std::memcpy(dst + 4, &indexBits, sizeof(indexBits));
+}
+
+// Eight value mode: endpoint 0 is the block maximum, endpoint 1 the
+// minimum, with six interpolated values in between.
+void encodeBC4(const u8 values[BLOCK_PIXELS], u8 *dst)
+{
+    u8 minValue = 255;
+    u8 maxValue = 0;
+    for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+        minValue = std::min(minValue, values[i]);
+        maxValue = std::max(maxValue, values[i]);
+    }
+
+    dst[0] = maxValue;
+    dst[1] = minValue;
+
+    u64 indexBits = 0;
+
+    if (maxValue != minValue) {
+        i32 palette[8];
+        palette[0] = maxValue;
+        palette[1] = minValue;
+        for (i32 i = 2; i < 8; i++) {
+            palette[i] = ((8 - i) * maxValue + (i - 1) * minValue + 3) / 7;
+        }
+
+        for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+            u32 best = 0;
+            i32 bestDistance = I32_MAX;
+            for (u32 p = 0; p < 8; p++) {
+                i32 distance = std::abs(static_cast<i32>(values[i]) - palette[p]);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indexBits |= static_cast<u64>(best) << (i * 3);
+        }
+    }
+
+    for (u32 i = 0; i < 6; i++) {
+        dst[2 + i] = static_cast<u8>(indexBits >> (i * 8));
+    }
+}
+
+void encodeBC1(const Block &block, u8 *dst)
+{
+    encodeBC1Color(block, dst);
+}
+
+void encodeBC3(const Block &block, u8 *dst)
+{
+    u8 alpha[BLOCK_PIXELS];
+    for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+        alpha[i] = block.pixels[i][3];
+    }
+
+    encodeBC4(alpha, dst);
+    encodeBC1Color(block, dst + 8);
+}
+
+void encodeBC5(const Block &block, u8 *dst)
+{
+    u8 red[BLOCK_PIXELS];
+    u8 green[BLOCK_PIXELS];
+    for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+        red[i] = block.pixels[i][0];
+        green[i] = block.pixels[i][1];
+    }
+
+    encodeBC4(red, dst);
+    encodeBC4(green, dst + 8);
+}
+
+struct BitWriter
+{
+    u8 *dst;
+    u32 position = 0;
+
+    void write(u32 value, u32 bits)
+    {
+        for (u32 i = 0; i < bits; i++, position++) {
+            if ((value >> i) & 1) {
+                dst[position >> 3] |= static_cast<u8>(1 << (position & 7));
+            }
+        }
+    }
+};
+
+struct BC7Mode6
+{
+    u32 endpoints[2][4];    // 7 bit values
+    u32 pbits[2];
+    u8 indices[BLOCK_PIXELS];
+    u32 error = U32_MAX;
+};
+
+u32 fitBC7Indices(const Block &block, BC7Mode6 &mode)
+{
+    i32 e[2][4];
+    for (u32 i = 0; i < 2; i++) {
+        for (u32 c = 0; c < 4; c++) {
+            e[i][c] = static_cast<i32>((mode.endpoints[i][c] << 1) | mode.pbits[i]);
+        }
+    }
+
+    i32 palette[16][4];
+    for (u32 p = 0; p < 16; p++) {
+        i32 w = static_cast<i32>(BC7_WEIGHTS[p]);
+        for (u32 c = 0; c < 4; c++) {
+            palette[p][c] = ((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6;
+        }
+    }
+
+    u32 error = 0;
+    for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+        u32 best = U32_MAX;
+        for (u32 p = 0; p < 16; p++) {
+            u32 distance = 0;
+            for (u32 c = 0; c < 4; c++) {
+                i32 d = static_cast<i32>(block.pixels[i][c]) - palette[p][c];
+                distance += static_cast<u32>(d * d);
+            }
+
+            if (distance < best) {
+                best = distance;
+                mode.indices[i] = static_cast<u8>(p);
+            }
+        }
+        error += best;
+    }
+
+    mode.error = error;
+    return error;
+}
+
+// Mode 6 only: one RGBA subset with 7 bit endpoints, a p-bit each and
+// 4 bit indices. It is the mode that suits smooth color and alpha best,
+// which is most of what materials contain.
+void encodeBC7(const Block &block, u8 *dst)
+{
+    f32 points[BLOCK_PIXELS][4];
+    for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+        for (u32 c = 0; c < 4; c++) {
+            points[i][c] = block.pixels[i][c];
+        }
+    }
+
+    f32 e0[4];
+    f32 e1[4];
+    computeEndpoints(points, 4, e0, e1);
+
+    BC7Mode6 best;
+
+    for (u32 iteration = 0; iteration < REFINE_ITERATIONS; iteration++) {
+        BC7Mode6 candidate;
+        BC7Mode6 iterationBest;
+
+        for (u32 p0 = 0; p0 < 2; p0++) {
+            for (u32 p1 = 0; p1 < 2; p1++) {
+                candidate.pbits[0] = p0;
+                candidate.pbits[1] = p1;
+
+                for (u32 c = 0; c < 4; c++) {
+                    candidate.endpoints[0][c] = static_cast<u32>(std::clamp(
+                        std::round((e0[c] - static_cast<f32>(p0)) * 0.5f), 0.0f, 127.0f
+                    ));
+                    candidate.endpoints[1][c] = static_cast<u32>(std::clamp(
+                        std::round((e1[c] - static_cast<f32>(p1)) * 0.5f), 0.0f, 127.0f
+                    ));
+                }
+
+                if (fitBC7Indices(block, candidate) < iterationBest.error) {
+                    iterationBest = candidate;
+                }
+            }
+        }
+
+        if (iterationBest.error >= best.error) {
+            break;
+        }
+
+        best = iterationBest;
+        if (best.error == 0) {
+            break;
+        }
+
+        f32 weights[BLOCK_PIXELS];
+        for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+            weights[i] = static_cast<f32>(BC7_WEIGHTS[best.indices[i]]) / 64.0f;
+        }
+
+        if (!solveEndpoints(points, 4, weights, e0, e1)) {
+            break;
+        }
+    }
+
+    // The most significant index bit of the first pixel is implicit zero.
+    if (best.indices[0] & 8) {
+        std::swap(best.endpoints[0], best.endpoints[1]);
+        std::swap(best.pbits[0], best.pbits[1]);
+        for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+            best.indices[i] = static_cast<u8>(15 - best.indices[i]);
+        }
+    }
+
+    std::memset(dst, 0, 16);
+    BitWriter writer{ dst };
+
+    writer.write(1 << 6, 7);
+    for (u32 c = 0; c < 4; c++) {
+        writer.write(best.endpoints[0][c], 7);
+        writer.write(best.endpoints[1][c], 7);
+    }
+    writer.write(best.pbits[0], 1);
+    writer.write(best.pbits[1], 1);
+
+    writer.write(best.indices[0], 3);
+    for (u32 i = 1; i < BLOCK_PIXELS; i++) {
+        writer.write(best.indices[i], 4);
+    }
+}
+
+void encodeBlock(BlockFormat format, const Block &block, u8 *dst)
+{
+    switch (format) {
+        case BlockFormat::BC1: encodeBC1(block, dst); break;
+        case BlockFormat::BC3: encodeBC3(block, dst); break;
+        case BlockFormat::BC5: encodeBC5(block, dst); break;
+        case BlockFormat::BC7: encodeBC7(block, dst); break;
+    }
+}
+
+} // namespace
+
+u32 getBlockBytes(BlockFormat format)
+{
+    switch (format) {
+        case BlockFormat::BC1: return 8;
+        case BlockFormat::BC3: return 16;
+        case BlockFormat::BC5: return 16;
+        case BlockFormat::BC7: return 16;
+    }
+
+    throw std::invalid_argument("Unknown block format.");
+}
+
+usize getEncodedSize(BlockFormat format, u32 width, u32 height)
+{
+    usize blocksX = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+    usize blocksY = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+
+    return blocksX * blocksY * getBlockBytes(format);
+}
+
+void encode(
+    BlockFormat format,
+    const u8 *pixels,
+    u32 width,
+    u32 height,
+    u8 *dst
+)
+{
+    if (width == 0 || height == 0) {
+        return;
+    }
+
+    u32 blocksX = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+    u32 blocksY = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+    u32 blockBytes = getBlockBytes(format);
+
+    auto encodeRows = [&](u32 begin, u32 end) {
+        Block block;
+        for (u32 by = begin; by < end; by++) {
+            for (u32 bx = 0; bx < blocksX; bx++) {
+                loadBlock(pixels, width, height, bx, by, block);
+                encodeBlock(
+                    format,
+                    block,
+                    dst + (static_cast<usize>(by) * blocksX + bx) * blockBytes
+                );
+            }
+        }
+    };
+
+    u32 threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, blocksY);
+    if (threadCount == 1) {
+        encodeRows(0, blocksY);
+        return;
+    }
+
+    u32 rowsPerThread = (blocksY + threadCount - 1) / threadCount;
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+
+    for (u32 begin = 0; begin < blocksY; begin += rowsPerThread) {
+        threads.emplace_back(encodeRows, begin, std::min(begin + rowsPerThread, blocksY));
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace gfx::texture
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+#include "core/types.hpp"
+
+namespace gfx::texture
+{
+
+enum class BlockFormat
+{
+    BC1,    // RGB, 8 bytes per block
+    BC3,    // RGBA with interpolated alpha, 16 bytes per block
+    BC5,    // Two independent channels (RG), 16 bytes per block
+    BC7     // RGBA, 16 bytes per block
+};
+
+constexpr u32 BLOCK_DIMENSION = 4;
+
+u32 getBlockBytes(BlockFormat format);
+
+// Size of a `width` x `height` image once encoded; partial blocks on the
+// right and bottom edges count as full blocks.
+usize getEncodedSize(BlockFormat format, u32 width, u32 height);
+
+// Encodes tightly packed RGBA8 `pixels` into `dst`, which must hold
+// `getEncodedSize` bytes. Edge blocks replicate the last row and column.
+// BC5 takes the red and green channels. Block rows are split across the
+// available hardware threads.
+void encode(
+    BlockFormat format,
+    const u8 *pixels,
+    u32 width,
+    u32 height,
+    u8 *dst
+);
+
+} // namespace gfx::texture
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "ktx2.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "stb_image.h"
+
+namespace gfx::texture
+{
+
+namespace
+{
+
+constexpr u8 KTX2_IDENTIFIER[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+constexpr usize KTX2_HEADER_SIZE = 80;
+constexpr usize KTX2_LEVEL_SIZE = 24;
+
+bool decodeZlib(const u8 *src, usize srcSize, u8 *dst, usize dstSize)
+{
+    if (srcSize > I32_MAX || dstSize > I32_MAX) {
+        return false;
+    }
+
+    int decoded = stbi_zlib_decode_buffer(
+        reinterpret_cast<char *>(dst),
+        static_cast<int>(dstSize),
+        reinterpret_cast<const char *>(src),
+        static_cast<int>(srcSize)
+    );
+
+    return decoded == static_cast<int>(dstSize);
+}
+
+std::array<SupercompressionDecoder, 4> &getDecoders()
+{
+    static std::array<SupercompressionDecoder, 4> decoders = {
+        nullptr,
+        nullptr,
+        nullptr,
+        decodeZlib
+    };
+
+    return decoders;
+}
+
+template<typename T>
+T read(const u8 *data, usize offset)
+{
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+} // namespace
+
+Ktx2Header readKtx2Header(std::istream &file)
+{
+    std::istream::pos_type start = file.tellg();
+    file.seekg(0, std::ios::end);
+    u64 fileSize = static_cast<u64>(file.tellg() - start);
+    file.seekg(start);
+
+    u8 data[KTX2_HEADER_SIZE];
+    if (!file.read(reinterpret_cast<char *>(data), KTX2_HEADER_SIZE)) {
+        throw std::runtime_error("KTX2 file is truncated.");
+    }
+
+    if (std::memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+        throw std::runtime_error("Not a KTX2 file.");
+    }
+
+    Ktx2Header header;
+    header.vkFormat = read<u32>(data, 12);
+    header.typeSize = read<u32>(data, 16);
+    header.width = read<u32>(data, 20);
+    header.height = read<u32>(data, 24);
+    header.depth = read<u32>(data, 28);
+    header.layerCount = read<u32>(data, 32);
+    header.faceCount = read<u32>(data, 36);
+    header.levelCount = read<u32>(data, 40);
+    header.supercompression = static_cast<Supercompression>(read<u32>(data, 44));
+
+    if (header.width == 0 || (header.faceCount != 1 && header.faceCount != 6)) {
+        throw std::runtime_error("Invalid KTX2 header.");
+    }
+
+    if (header.levelCount > 32) {
+        throw std::runtime_error("Invalid KTX2 level count.");
+    }
+
+    u32 levelCount = header.levelCount > 0 ? header.levelCount : 1;
+
+    std::vector<u8> index(levelCount * KTX2_LEVEL_SIZE);
+    if (!file.read(reinterpret_cast<char *>(index.data()), index.size())) {
+        throw std::runtime_error("KTX2 file is truncated.");
+    }
+
+    header.levels.resize(levelCount);
+    for (u32 i = 0; i < levelCount; i++) {
+        Ktx2Level &level = header.levels[i];
+        level.byteOffset = read<u64>(index.data(), i * KTX2_LEVEL_SIZE);
+        level.byteLength = read<u64>(index.data(), i * KTX2_LEVEL_SIZE + 8);
+        level.uncompressedByteLength = read<u64>(index.data(), i * KTX2_LEVEL_SIZE + 16);
+
+        // Lengths are used as read sizes, so a level must lie inside the
+        // file and raw levels must fill exactly their uncompressed size.
+        if (level.byteOffset > fileSize || level.byteLength > fileSize - level.byteOffset) {
+            throw std::runtime_error("KTX2 level lies outside the file.");
+        }
+
+        if (
+            header.supercompression == Supercompression::None &&
+            level.byteLength != level.uncompressedByteLength
+        ) {
+            throw std::runtime_error("Invalid KTX2 level length.");
+        }
+    }
+
+    return header;
+}
+
+void setSupercompressionDecoder(
+    Supercompression scheme,
+    SupercompressionDecoder decoder
+)
+{
+    u32 index = static_cast<u32>(scheme);
+    if (scheme == Supercompression::None || index >= getDecoders().size()) {
+        throw std::invalid_argument("Invalid supercompression scheme.");
+    }
+
+    getDecoders()[index] = std::move(decoder);
+}
+
+void decodeSupercompressed(
+    Supercompression scheme,
+    const std::vector<DecodeJob> &jobs
+)
+{
+    u32 index = static_cast<u32>(scheme);
+    if (index >= getDecoders().size() || !getDecoders()[index]) {
+        throw std::runtime_error(
+            "No decoder for KTX2 supercompression scheme " + std::to_string(index)
+        );
+    }
+
+    const SupercompressionDecoder &decoder = getDecoders()[index];
+    std::atomic<bool> failed = false;
+
+    std::vector<std::thread> threads;
+    threads.reserve(jobs.size());
+
+    for (const DecodeJob &job : jobs) {
+        threads.emplace_back([&decoder, &failed, job]() {
+            if (!decoder(job.src, job.srcSize, job.dst, job.dstSize)) {
+                failed = true;
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (failed) {
+        throw std::runtime_error("Failed to decode supercompressed KTX2 level.");
+    }
+}
+
+} // namespace gfx::texture
\ No newline at end of file
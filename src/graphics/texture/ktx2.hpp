@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <vector>
+
+#include "core/types.hpp"
+
+namespace gfx::texture
+{
+
+enum class Supercompression : u32
+{
+    None = 0,
+    BasisLZ = 1,
+    Zstandard = 2,
+    Zlib = 3
+};
+
+struct Ktx2Level
+{
+    u64 byteOffset = 0;
+    u64 byteLength = 0;
+    u64 uncompressedByteLength = 0;
+};
+
+// Fields as stored in the file: `layerCount` is 0 for non-array textures,
+// `levelCount` is 0 when the loader should generate the mip chain, and
+// `levels` always holds at least one entry, level 0 first.
+struct Ktx2Header
+{
+    u32 vkFormat = 0;
+    u32 typeSize = 0;
+    u32 width = 0;
+    u32 height = 0;
+    u32 depth = 0;
+    u32 layerCount = 0;
+    u32 faceCount = 0;
+    u32 levelCount = 0;
+    Supercompression supercompression = Supercompression::None;
+    std::vector<Ktx2Level> levels;
+};
+
+// Reads the header and level index from the start of `file`. Throws when
+// a level lies outside the file or a raw level's length does not match
+// its uncompressed length.
+Ktx2Header readKtx2Header(std::istream &file);
+
+// Returns false when `src` does not decode to exactly `dstSize` bytes.
+using SupercompressionDecoder = std::function<bool(
+    const u8 *src,
+    usize srcSize,
+    u8 *dst,
+    usize dstSize
+)>;
+
+// Zlib is decoded out of the box. Zstandard needs a decoder to be set
+// before loading; BasisLZ is not supported.
+void setSupercompressionDecoder(
+    Supercompression scheme,
+    SupercompressionDecoder decoder
+);
+
+struct DecodeJob
+{
+    const u8 *src = nullptr;
+    usize srcSize = 0;
+    u8 *dst = nullptr;
+    usize dstSize = 0;
+};
+
+// Decodes each job on its own worker thread.
+void decodeSupercompressed(
+    Supercompression scheme,
+    const std::vector<DecodeJob> &jobs
+);
+
+} // namespace gfx::texture
\ No newline at end of file
@@ -0,0 +1,433 @@
+#include "mipmaps.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    #include <immintrin.h>
+    #define TEXTURE_SSE2 1
+    #if defined(__GNUC__) || defined(__clang__)
+        #define TEXTURE_AVX 1
+        #define TEXTURE_TARGET_AVX __attribute__((target("avx")))
+    #endif
+#endif
+
+namespace gfx::texture
+{
+
+namespace
+{
+
+// Radius in destination texels and window shape of the Kaiser windowed
+// sinc, the usual choice of offline texture tools.
+constexpr f32 KAISER_RADIUS = 3.0f;
+constexpr f32 KAISER_ALPHA = 4.0f;
+
+constexpr f32 PI = 3.14159265358979323846f;
+
+constexpr f32 MAX_COVERAGE_SCALE = 4.0f;
+constexpr u32 COVERAGE_ITERATIONS = 12;
+
+// `count` taps per destination texel; indices are already clamped to the
+// source so edges repeat the border texel.
+struct FilterTaps
+{
+    u32 count = 0;
+    std::vector<u32> indices;
+    std::vector<f32> weights;
+};
+
+f32 besselI0(f32 x)
+{
+    f32 sum = 1.0f;
+    f32 term = 1.0f;
+    f32 half = x * 0.5f;
+
+    for (u32 k = 1; k < 32; k++) {
+        f32 factor = half / static_cast<f32>(k);
+        term *= factor * factor;
+        sum += term;
+
+        if (term < sum * 1e-8f) {
+            break;
+        }
+    }
+
+    return sum;
+}
+
+f32 sinc(f32 x)
+{
+    if (std::abs(x) < 1e-6f) {
+        return 1.0f;
+    }
+
+    x *= PI;
+    return std::sin(x) / x;
+}
+
+f32 kaiser(f32 x)
+{
+    f32 t = x / KAISER_RADIUS;
+    if (t * t >= 1.0f) {
+        return 0.0f;
+    }
+
+    return sinc(x) * besselI0(KAISER_ALPHA * std::sqrt(1.0f - t * t)) /
+        besselI0(KAISER_ALPHA);
+}
+
+FilterTaps buildTaps(u32 srcSize, u32 dstSize, MipFilter filter)
+{
+    f32 scale = static_cast<f32>(srcSize) / static_cast<f32>(dstSize);
+    f32 radius = (filter == MipFilter::Box ? 0.5f : KAISER_RADIUS) * scale;
+
+    FilterTaps taps;
+    taps.count = static_cast<u32>(std::ceil(radius * 2.0f)) + 1;
+    taps.indices.resize(static_cast<usize>(dstSize) * taps.count, 0);
+    taps.weights.resize(static_cast<usize>(dstSize) * taps.count, 0.0f);
+
+    for (u32 x = 0; x < dstSize; x++) {
+        f32 center = (static_cast<f32>(x) + 0.5f) * scale;
+        i32 first = static_cast<i32>(std::floor(center - radius));
+
+        u32 *indices = &taps.indices[static_cast<usize>(x) * taps.count];
+        f32 *weights = &taps.weights[static_cast<usize>(x) * taps.count];
+        f32 total = 0.0f;
+
+        for (u32 t = 0; t < taps.count; t++) {
+            i32 i = first + static_cast<i32>(t);
+            f32 position = static_cast<f32>(i);
+
+            f32 weight;
+            if (filter == MipFilter::Box) {
+                f32 lo = std::max(position, center - radius);
+                f32 hi = std::min(position + 1.0f, center + radius);
+                weight = std::max(hi - lo, 0.0f);
+            } else {
+                weight = kaiser((position + 0.5f - center) / scale);
+            }
+
+            indices[t] = static_cast<u32>(std::clamp(i, 0, static_cast<i32>(srcSize) - 1));
+            weights[t] = weight;
+            total += weight;
+        }
+
+        for (u32 t = 0; t < taps.count; t++) {
+            weights[t] /= total;
+        }
+    }
+
+    return taps;
+}
+
+f32 srgbToLinear(f32 c)
+{
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+f32 linearToSrgb(f32 c)
+{
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+u8 toUnorm8(f32 value)
+{
+    return static_cast<u8>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+bool hasAVX()
+{
+#if defined(TEXTURE_AVX)
+    static const bool supported = __builtin_cpu_supports("avx");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+#if defined(TEXTURE_AVX)
+// Returns how many floats were handled, a multiple of 8.
+TEXTURE_TARGET_AVX
+usize multiplyAddAVX(f32 *acc, const f32 *src, f32 weight, usize count)
+{
+    __m256 weight8 = _mm256_set1_ps(weight);
+
+    usize i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 sum = _mm256_add_ps(
+            _mm256_loadu_ps(acc + i),
+            _mm256_mul_ps(_mm256_loadu_ps(src + i), weight8)
+        );
+        _mm256_storeu_ps(acc + i, sum);
+    }
+
+    return i;
+}
+#endif
+
+// acc[i] += src[i] * weight over `count` floats, a multiple of 4.
+void multiplyAdd(f32 *acc, const f32 *src, f32 weight, usize count)
+{
+    usize i = 0;
+
+#if defined(TEXTURE_AVX)
+    if (hasAVX()) {
+        i = multiplyAddAVX(acc, src, weight, count);
+    }
+#endif
+
+#if defined(TEXTURE_SSE2)
+    __m128 weight4 = _mm_set1_ps(weight);
+    for (; i < count; i += 4) {
+        __m128 sum = _mm_add_ps(
+            _mm_loadu_ps(acc + i),
+            _mm_mul_ps(_mm_loadu_ps(src + i), weight4)
+        );
+        _mm_storeu_ps(acc + i, sum);
+    }
+#else
+    for (; i < count; i++) {
+        acc[i] += src[i] * weight;
+    }
+#endif
+}
+
+// One RGBA texel is one 4-wide vector.
+void filterRow(const f32 *src, f32 *dst, u32 dstWidth, const FilterTaps &taps)
+{
+    for (u32 x = 0; x < dstWidth; x++) {
+        const u32 *indices = &taps.indices[static_cast<usize>(x) * taps.count];
+        const f32 *weights = &taps.weights[static_cast<usize>(x) * taps.count];
+
+#if defined(TEXTURE_SSE2)
+        __m128 sum = _mm_setzero_ps();
+        for (u32 t = 0; t < taps.count; t++) {
+            sum = _mm_add_ps(
+                sum,
+                _mm_mul_ps(_mm_loadu_ps(src + indices[t] * 4), _mm_set1_ps(weights[t]))
+            );
+        }
+        _mm_storeu_ps(dst + x * 4, sum);
+#else
+        f32 sum[4] = {};
+        for (u32 t = 0; t < taps.count; t++) {
+            for (u32 c = 0; c < 4; c++) {
+                sum[c] += src[indices[t] * 4 + c] * weights[t];
+            }
+        }
+        std::memcpy(dst + x * 4, sum, sizeof(sum));
+#endif
+    }
+}
+
+f32 computeCoverage(const f32 *alpha, usize count, f32 cutoff, f32 scale)
+{
+    usize passed = 0;
+    for (usize i = 0; i < count; i++) {
+        passed += alpha[i] * scale > cutoff;
+    }
+
+    return static_cast<f32>(passed) / static_cast<f32>(count);
+}
+
+// Scale that brings the coverage of `alpha` closest to `target`; coverage
+// only grows with the scale, so a bisection is enough.
+f32 findCoverageScale(const f32 *alpha, usize count, f32 cutoff, f32 target)
+{
+    f32 lo = 0.0f;
+    f32 hi = MAX_COVERAGE_SCALE;
+
+    for (u32 i = 0; i < COVERAGE_ITERATIONS; i++) {
+        f32 mid = (lo + hi) * 0.5f;
+        if (computeCoverage(alpha, count, cutoff, mid) < target) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return hi;
+}
+
+// Filters the linear RGBA level `src` into `dst`, and encodes the result
+// into the 8 bit `texels` of the level.
+void resampleLevel(
+    const f32 *src,
+    const MipLevel &srcLevel,
+    f32 *dst,
+    u8 *texels,
+    const MipLevel &dstLevel,
+    const MipOptions &options,
+    f32 targetCoverage
+)
+{
+    FilterTaps xTaps = buildTaps(srcLevel.width, dstLevel.width, options.filter);
+    FilterTaps yTaps = buildTaps(srcLevel.height, dstLevel.height, options.filter);
+
+    usize rowFloats = static_cast<usize>(dstLevel.width) * 4;
+
+    // Horizontally filtered source rows. The rows of one output row are
+    // contiguous and fewer than the slot count, so they never evict each
+    // other.
+    u32 slots = yTaps.count;
+    std::vector<f32> cache(slots * rowFloats);
+    std::vector<i64> cachedRows(slots, -1);
+
+    std::vector<f32> accumulator(rowFloats);
+    std::vector<f32> alpha(static_cast<usize>(dstLevel.width) * dstLevel.height);
+
+    auto getRow = [&](u32 row) -> const f32 * {
+        u32 slot = row % slots;
+        f32 *filtered = &cache[slot * rowFloats];
+
+        if (cachedRows[slot] != row) {
+            const f32 *texels = src + static_cast<usize>(row) * srcLevel.width * 4;
+            filterRow(texels, filtered, dstLevel.width, xTaps);
+            cachedRows[slot] = row;
+        }
+
+        return filtered;
+    };
+
+    for (u32 y = 0; y < dstLevel.height; y++) {
+        std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+
+        for (u32 t = 0; t < yTaps.count; t++) {
+            usize tap = static_cast<usize>(y) * yTaps.count + t;
+            if (yTaps.weights[tap] != 0.0f) {
+                multiplyAdd(
+                    accumulator.data(),
+                    getRow(yTaps.indices[tap]),
+                    yTaps.weights[tap],
+                    rowFloats
+                );
+            }
+        }
+
+        f32 *linear = dst + static_cast<usize>(y) * rowFloats;
+        u8 *row = texels + static_cast<usize>(y) * rowFloats;
+
+        for (u32 x = 0; x < dstLevel.width; x++) {
+            for (u32 c = 0; c < 4; c++) {
+                linear[x * 4 + c] = std::clamp(accumulator[x * 4 + c], 0.0f, 1.0f);
+            }
+
+            for (u32 c = 0; c < 3; c++) {
+                f32 value = linear[x * 4 + c];
+                row[x * 4 + c] = toUnorm8(options.srgb ? linearToSrgb(value) : value);
+            }
+
+            alpha[static_cast<usize>(y) * dstLevel.width + x] = linear[x * 4 + 3];
+        }
+    }
+
+    f32 alphaScale = 1.0f;
+    if (options.alphaCutoff > 0.0f) {
+        alphaScale = findCoverageScale(
+            alpha.data(),
+            alpha.size(),
+            options.alphaCutoff,
+            targetCoverage
+        );
+    }
+
+    // Only the encoded level is scaled; the next level is filtered from
+    // the unscaled alpha and finds its own scale.
+    for (usize i = 0; i < alpha.size(); i++) {
+        texels[i * 4 + 3] = toUnorm8(alpha[i] * alphaScale);
+    }
+}
+
+} // namespace
+
+u32 getMipLevelCount(u32 width, u32 height)
+{
+    u32 size = std::max(width, height);
+
+    u32 levels = 1;
+    while (size > 1) {
+        size >>= 1;
+        levels++;
+    }
+
+    return levels;
+}
+
+MipChain generateMipChain(
+    const u8 *pixels,
+    u32 width,
+    u32 height,
+    const MipOptions &options
+)
+{
+    MipChain chain;
+    chain.levels.resize(getMipLevelCount(width, height));
+
+    usize size = 0;
+    for (u32 level = 0; level < chain.levels.size(); level++) {
+        MipLevel &mip = chain.levels[level];
+        mip.offset = size;
+        mip.width = std::max(width >> level, 1u);
+        mip.height = std::max(height >> level, 1u);
+
+        size += static_cast<usize>(mip.width) * mip.height * 4;
+    }
+
+    chain.data.resize(size);
+    std::memcpy(chain.data.data(), pixels, static_cast<usize>(width) * height * 4);
+
+    f32 colorTable[256];
+    for (u32 i = 0; i < 256; i++) {
+        f32 value = static_cast<f32>(i) / 255.0f;
+        colorTable[i] = options.srgb ? srgbToLinear(value) : value;
+    }
+
+    f32 targetCoverage = 0.0f;
+    if (options.alphaCutoff > 0.0f) {
+        usize count = static_cast<usize>(width) * height;
+        std::vector<f32> alpha(count);
+        for (usize i = 0; i < count; i++) {
+            alpha[i] = pixels[i * 4 + 3] / 255.0f;
+        }
+
+        targetCoverage = computeCoverage(alpha.data(), count, options.alphaCutoff, 1.0f);
+    }
+
+    // The previous level is kept in linear float, so neither 8 bit
+    // rounding nor the sRGB round trip compound down the chain.
+    usize count = static_cast<usize>(width) * height;
+    std::vector<f32> previous(count * 4);
+    for (usize i = 0; i < count; i++) {
+        previous[i * 4 + 0] = colorTable[pixels[i * 4 + 0]];
+        previous[i * 4 + 1] = colorTable[pixels[i * 4 + 1]];
+        previous[i * 4 + 2] = colorTable[pixels[i * 4 + 2]];
+        previous[i * 4 + 3] = pixels[i * 4 + 3] / 255.0f;
+    }
+
+    std::vector<f32> current;
+
+    for (u32 level = 1; level < chain.levels.size(); level++) {
+        const MipLevel &src = chain.levels[level - 1];
+        const MipLevel &dst = chain.levels[level];
+
+        current.resize(static_cast<usize>(dst.width) * dst.height * 4);
+
+        resampleLevel(
+            previous.data(),
+            src,
+            current.data(),
+            chain.data.data() + dst.offset,
+            dst,
+            options,
+            targetCoverage
+        );
+
+        previous.swap(current);
+    }
+
+    return chain;
+}
+
+} // namespace gfx::texture
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "core/types.hpp"
+
+namespace gfx::texture
+{
+
+enum class MipFilter
+{
+    Box,
+    Kaiser
+};
+
+struct MipOptions
+{
+    MipFilter filter = MipFilter::Kaiser;
+
+    // Color channels are sRGB encoded and filtered in linear space; alpha
+    // is always linear.
+    bool srgb = false;
+
+    // When above 0, alpha on every level is scaled so the fraction of
+    // texels passing this alpha test matches level 0.
+    f32 alphaCutoff = 0.0f;
+};
+
+struct MipLevel
+{
+    usize offset = 0;
+    u32 width = 0;
+    u32 height = 0;
+};
+
+// RGBA8 levels, level 0 included, tightly packed largest first as
+// Image::copyFromBuffer expects.
+struct MipChain
+{
+    std::vector<u8> data;
+    std::vector<MipLevel> levels;
+};
+
+// Full chain down to 1x1.
+u32 getMipLevelCount(u32 width, u32 height);
+
+// Each level is resampled from the previous one with a separable filter,
+// keeping the previous level in linear float; odd sizes are handled by
+// the filter footprint instead of dropping the last row or column.
+MipChain generateMipChain(
+    const u8 *pixels,
+    u32 width,
+    u32 height,
+    const MipOptions &options = {}
+);
+
+} // namespace gfx::texture
\ No newline at end of file
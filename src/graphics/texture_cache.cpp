@@ -0,0 +1,204 @@
+#include "texture_cache.hpp"
+#include "device.hpp"
+#include "bindless_manager.hpp"
+#include "texture_streamer.hpp"
+
+#include <cstring>
+
+namespace gfx
+{
+
+namespace
+{
+
+constexpr u64 HASH_PRIME = 0x9E3779B97F4A7C15ull;
+
+u64 mix(u64 value)
+{
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+} // namespace
+
+usize TextureKeyHash::operator()(const TextureKey &key) const
+{
+    u64 hash = key.hash;
+    hash = mix(hash ^ (static_cast<u64>(key.width) << 32 | key.height));
+    hash = mix(hash ^ reinterpret_cast<u64>(key.sampler));
+    return static_cast<usize>(hash);
+}
+
+void TextureCache::init(
+    Device &device,
+    BindlessManager &bindlessManager,
+    TextureStreamer *textureStreamer
+)
+{
+    m_device = &device;
+    m_bindlessManager = &bindlessManager;
+    m_textureStreamer = textureStreamer;
+}
+
+void TextureCache::destroy()
+{
+    for (auto &entry : m_keyToID) {
+        Texture &texture = m_textures[entry.second];
+
+        if (texture.streamID != ~0u) {
+            m_textureStreamer->removeTexture(texture.streamID);
+        } else {
+            m_bindlessManager->removeResource(texture.handle);
+            m_device->getDefragmenter().removeImage(texture.image);
+            texture.image.destroy();
+        }
+    }
+
+    m_keyToID.clear();
+    m_textures.clear();
+    m_freeIDs.clear();
+}
+
+u32 TextureCache::acquire(const TextureKey &key)
+{
+    auto it = m_keyToID.find(key);
+    if (it == m_keyToID.end()) {
+        return ~0u;
+    }
+
+    m_textures[it->second].refCount++;
+    return it->second;
+}
+
+u32 TextureCache::add(
+    const TextureKey &key,
+    const void *data,
+    u32 levelCount,
+    VkFormat format,
+    bool stream
+)
+{
+    u32 id = acquire(key);
+    if (id != ~0u) {
+        return id;
+    }
+
+    Texture texture;
+    texture.key = key;
+
+    if (stream && m_textureStreamer) {
+        texture.streamID = m_textureStreamer->addTexture(
+            data,
+            key.width,
+            key.height,
+            levelCount,
+            format,
+            key.sampler
+        );
+    } else {
+        // Transfer source usage lets the defragmenter copy the image.
+        texture.image.init(
+            *m_device,
+            data,
+            key.width,
+            key.height,
+            levelCount,
+            format,
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+        );
+        texture.handle = m_bindlessManager->addTexture(texture.image, key.sampler);
+    }
+
+    id = insert(std::move(texture));
+
+    if (m_textures[id].streamID == ~0u) {
+        m_device->getDefragmenter().addImage(m_textures[id].image);
+    }
+
+    return id;
+}
+
+u32 TextureCache::acquireDefault()
+{
+    u32 whitePixel = 0xFFFFFFFF;
+
+    TextureKey key;
+    key.hash = hash(&whitePixel, sizeof(whitePixel), HASH_PRIME);
+    key.width = 1;
+    key.height = 1;
+
+    return add(key, &whitePixel, 1, VK_FORMAT_R8G8B8A8_UNORM, false);
+}
+
+void TextureCache::release(u32 id)
+{
+    Texture &texture = m_textures[id];
+    if (--texture.refCount > 0) {
+        return;
+    }
+
+    if (texture.streamID != ~0u) {
+        m_textureStreamer->removeTexture(texture.streamID);
+    } else {
+        m_bindlessManager->removeResource(texture.handle);
+        m_device->getDefragmenter().removeImage(texture.image);
+        texture.image.deferDestroy();
+    }
+
+    m_keyToID.erase(texture.key);
+    texture = Texture{};
+    m_freeIDs.push_back(id);
+}
+
+u64 TextureCache::hash(const void *data, usize size, u64 seed)
+{
+    // Eight bytes per step; textures are hashed in full on every load.
+    const u8 *bytes = static_cast<const u8 *>(data);
+    u64 hash = mix(seed ^ (size * HASH_PRIME));
+
+    usize i = 0;
+    for (; i + 8 <= size; i += 8) {
+        u64 word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ mix(word)) * HASH_PRIME;
+    }
+
+    u64 tail = 0;
+    memcpy(&tail, bytes + i, size - i);
+
+    return mix(hash ^ mix(tail));
+}
+
+u32 TextureCache::getHandle(u32 id) const
+{
+    const Texture &texture = m_textures[id];
+    if (texture.streamID != ~0u) {
+        return m_textureStreamer->getHandle(texture.streamID);
+    }
+
+    return texture.handle;
+}
+
+u32 TextureCache::insert(Texture &&texture)
+{
+    texture.refCount = 1;
+
+    u32 id;
+    if (!m_freeIDs.empty()) {
+        id = m_freeIDs.back();
+        m_freeIDs.pop_back();
+        m_textures[id] = std::move(texture);
+    } else {
+        id = static_cast<u32>(m_textures.size());
+        m_textures.push_back(std::move(texture));
+    }
+
+    m_keyToID[m_textures[id].key] = id;
+    return id;
+}
+
+} // namespace gfx
\ No newline at end of file
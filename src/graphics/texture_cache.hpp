@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "core/types.hpp"
+#include "image.hpp"
+
+namespace gfx
+{
+
+class Device;
+class BindlessManager;
+class TextureStreamer;
+
+// Identifies a texture by what ends up on the device: `hash` covers the
+// source pixels and every setting that changes how they are processed.
+struct TextureKey
+{
+    u64 hash = 0;
+    u32 width = 0;
+    u32 height = 0;
+    VkSampler sampler = VK_NULL_HANDLE;
+
+    bool operator==(const TextureKey &other) const
+    {
+        return hash == other.hash &&
+            width == other.width &&
+            height == other.height &&
+            sampler == other.sampler;
+    }
+};
+
+struct TextureKeyHash
+{
+    usize operator()(const TextureKey &key) const;
+};
+
+// Textures shared by every model, so identical images loaded from
+// different files are processed and uploaded once. Each acquire() or
+// add() takes a reference that release() drops; the texture is destroyed
+// with its last reference.
+class TextureCache
+{
+
+public:
+    TextureCache() = default;
+    ~TextureCache() = default;
+
+    // Without a streamer every texture is uploaded as a whole.
+    void init(
+        Device &device,
+        BindlessManager &bindlessManager,
+        TextureStreamer *textureStreamer = nullptr
+    );
+
+    void destroy();
+
+    // Returns ~0u when the texture is not cached yet.
+    u32 acquire(const TextureKey &key);
+
+    // `data` holds `levelCount` tightly packed levels, largest first. With
+    // `stream` set and a streamer, only the coarse levels are uploaded now.
+    u32 add(
+        const TextureKey &key,
+        const void *data,
+        u32 levelCount,
+        VkFormat format,
+        bool stream
+    );
+
+    // Opaque white 1x1 texture for untextured materials.
+    u32 acquireDefault();
+
+    // The image of the last reference is destroyed once the frames in
+    // flight are done with it.
+    void release(u32 id);
+
+    static u64 hash(const void *data, usize size, u64 seed = 0);
+
+public:
+    // Streamed textures change handle whenever their resident levels do.
+    u32 getHandle(u32 id) const;
+
+    // ~0u for textures uploaded as a whole.
+    u32 getStreamID(u32 id) const { return m_textures[id].streamID; }
+
+    TextureStreamer *getTextureStreamer() const { return m_textureStreamer; }
+    u32 getTextureCount() const { return static_cast<u32>(m_keyToID.size()); }
+
+private:
+    struct Texture
+    {
+        TextureKey key;
+        Image image;
+        u32 handle = ~0u;
+        u32 streamID = ~0u;
+        u32 refCount = 0;
+    };
+
+    Device *m_device = nullptr;
+    BindlessManager *m_bindlessManager = nullptr;
+    TextureStreamer *m_textureStreamer = nullptr;
+
+    // A deque keeps images at a fixed address for the defragmenter.
+    std::deque<Texture> m_textures;
+    std::vector<u32> m_freeIDs;
+    std::unordered_map<TextureKey, u32, TextureKeyHash> m_keyToID;
+
+    u32 insert(Texture &&texture);
+
+};
+
+} // namespace gfx
\ No newline at end of file
@@ -0,0 +1,414 @@
+#include "texture_streamer.hpp"
+#include "device.hpp"
+#include "bindless_manager.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace gfx
+{
+
+void TextureStreamer::init(
+    Device &device,
+    BindlessManager &bindlessManager,
+    const TextureStreamerOptions &options
+)
+{
+    m_device = &device;
+    m_bindlessManager = &bindlessManager;
+    m_options = options;
+
+    for (auto &frame : m_uploadFrames) {
+        frame.commandPool = vk::createCommandPool(
+            device.getDevice(),
+            device.getQueueFamilyIndices().graphicsFamily.value(),
+            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+        );
+        frame.commandBuffer = vk::createCommandBuffer(
+            device.getDevice(),
+            frame.commandPool
+        );
+    }
+
+    // Fires every frame while under pressure; the next update evicts.
+    m_pressureCallback = device.getMemoryBudget().addPressureCallback(
+        [this](const MemoryPressure &pressure) {
+            m_pressureBytes = pressure.excess;
+        }
+    );
+}
+
+void TextureStreamer::destroy()
+{
+    m_device->getMemoryBudget().removePressureCallback(m_pressureCallback);
+
+    for (auto &frame : m_uploadFrames) {
+        m_device->wait(frame.timelineValue);
+        vkDestroyCommandPool(m_device->getDevice(), frame.commandPool, nullptr);
+    }
+
+    for (auto &texture : m_textures) {
+        if (texture.isUsed) {
+            texture.image.destroy();
+        }
+    }
+    m_textures.clear();
+    m_freeIDs.clear();
+
+    m_residentBytes = 0;
+}
+
+u32 TextureStreamer::addTexture(
+    const void *data,
+    u32 width,
+    u32 height,
+    u32 levelCount,
+    VkFormat format,
+    VkSampler sampler
+)
+{
+    Texture texture;
+    texture.width = width;
+    texture.height = height;
+    texture.levelCount = levelCount;
+    texture.format = format;
+    texture.sampler = sampler;
+    texture.tailLevel = levelCount - 1;
+    texture.levelOffsets.resize(levelCount + 1);
+
+    VkDeviceSize size = 0;
+    for (u32 level = 0; level < levelCount; level++) {
+        u32 levelWidth = std::max(width >> level, 1u);
+        u32 levelHeight = std::max(height >> level, 1u);
+
+        if (
+            level < texture.tailLevel &&
+            std::max(levelWidth, levelHeight) <= m_options.residentDimension
+        ) {
+            texture.tailLevel = level;
+        }
+
+        texture.levelOffsets[level] = size;
+        size += vk::getImageSize(format, levelWidth, levelHeight);
+    }
+    texture.levelOffsets[levelCount] = size;
+
+    const u8 *bytes = static_cast<const u8 *>(data);
+    u32 tail = texture.tailLevel;
+
+    texture.image.init(
+        *m_device,
+        bytes + texture.levelOffsets[tail],
+        std::max(width >> tail, 1u),
+        std::max(height >> tail, 1u),
+        levelCount - tail,
+        format
+    );
+
+    texture.handles[0] = m_bindlessManager->addTexture(texture.image, sampler);
+
+    // Small textures are resident as a whole and never swap.
+    if (tail > 0) {
+        texture.data.assign(bytes, bytes + size);
+        texture.handles[1] = m_bindlessManager->addTexture(texture.image, sampler);
+    } else {
+        texture.handles[1] = texture.handles[0];
+    }
+
+    texture.baseLevel = tail;
+    texture.requestedLevel = static_cast<f32>(tail);
+    texture.requestFrame = m_frame;
+    texture.swapFrame = m_frame;
+    texture.isUsed = true;
+
+    m_residentBytes += getChainSize(texture, tail);
+
+    u32 id;
+    if (!m_freeIDs.empty()) {
+        id = m_freeIDs.back();
+        m_freeIDs.pop_back();
+        m_textures[id] = std::move(texture);
+    } else {
+        id = static_cast<u32>(m_textures.size());
+        m_textures.push_back(std::move(texture));
+    }
+
+    return id;
+}
+
+void TextureStreamer::removeTexture(u32 id)
+{
+    if (id >= m_textures.size() || !m_textures[id].isUsed) {
+        return;
+    }
+
+    Texture &texture = m_textures[id];
+
+    texture.image.deferDestroy();
+    m_residentBytes -= getChainSize(texture, texture.baseLevel);
+
+    m_bindlessManager->removeResource(texture.handles[0]);
+    m_bindlessManager->removeResource(texture.handles[1]);
+
+    texture = Texture{};
+    m_freeIDs.push_back(id);
+}
+
+void TextureStreamer::request(u32 id, f32 uvPerPixel)
+{
+    Texture &texture = m_textures[id];
+
+    f32 texels = uvPerPixel * std::sqrt(
+        static_cast<f32>(texture.width) * static_cast<f32>(texture.height)
+    );
+    f32 level = texels > 0.0f
+        ? std::log2(texels)
+        : static_cast<f32>(texture.tailLevel);
+
+    if (texture.requestFrame != m_frame) {
+        texture.requestedLevel = level;
+        texture.requestFrame = m_frame;
+    } else {
+        texture.requestedLevel = std::min(texture.requestedLevel, level);
+    }
+}
+
+void TextureStreamer::update()
+{
+    m_frame++;
+
+    // Uploads of this slot from MAX_FRAMES_IN_FLIGHT updates ago are still
+    // running; try again next frame instead of stalling.
+    UploadFrame &frame = m_uploadFrames[m_frame % MAX_FRAMES_IN_FLIGHT];
+    if (!m_device->isComplete(frame.timelineValue)) {
+        return;
+    }
+
+    struct Candidate
+    {
+        u32 id;
+        u32 level;
+    };
+
+    std::vector<Candidate> demotions;
+    std::vector<Candidate> promotions;
+    std::vector<u32> evictable;
+
+    for (u32 id = 0; id < m_textures.size(); id++) {
+        const Texture &texture = m_textures[id];
+
+        // The idle slot is still referenced by pending frames.
+        if (!texture.isUsed || m_frame - texture.swapFrame <= MAX_FRAMES_IN_FLIGHT) {
+            continue;
+        }
+
+        u32 level = getTargetLevel(texture);
+        if (level > texture.baseLevel) {
+            demotions.push_back({ id, level });
+        } else if (level < texture.baseLevel) {
+            promotions.push_back({ id, level });
+        } else if (texture.baseLevel < texture.tailLevel) {
+            evictable.push_back(id);
+        }
+    }
+
+    VkDeviceSize budget = getBudget();
+    m_pressureBytes = 0;
+    VkDeviceSize projectedBytes = m_residentBytes;
+    for (const Candidate &candidate : demotions) {
+        const Texture &texture = m_textures[candidate.id];
+        projectedBytes -= getChainSize(texture, texture.baseLevel) -
+            getChainSize(texture, candidate.level);
+    }
+
+    // Over budget, the least recently requested textures give up their
+    // finest level first.
+    std::sort(evictable.begin(), evictable.end(), [&](u32 a, u32 b) {
+        return m_textures[a].requestFrame < m_textures[b].requestFrame;
+    });
+
+    for (u32 id : evictable) {
+        if (projectedBytes <= budget) {
+            break;
+        }
+
+        const Texture &texture = m_textures[id];
+        demotions.push_back({ id, texture.baseLevel + 1 });
+        projectedBytes -= getChainSize(texture, texture.baseLevel) -
+            getChainSize(texture, texture.baseLevel + 1);
+    }
+
+    // Largest shortfall first.
+    std::sort(promotions.begin(), promotions.end(), [&](const Candidate &a, const Candidate &b) {
+        return m_textures[a.id].baseLevel - a.level > m_textures[b.id].baseLevel - b.level;
+    });
+
+    u32 uploadCount = 0;
+    VkDeviceSize uploadBytes = 0;
+
+    // The first upload of a frame may exceed the byte limit, otherwise a
+    // large level 0 would never fit.
+    auto canUpload = [&](VkDeviceSize size) {
+        return uploadCount < m_options.maxUploadsPerFrame &&
+            (uploadCount == 0 || uploadBytes + size <= m_options.maxUploadBytesPerFrame);
+    };
+
+    for (const Candidate &candidate : demotions) {
+        Texture &texture = m_textures[candidate.id];
+        VkDeviceSize size = getChainSize(texture, candidate.level);
+
+        if (!canUpload(size)) {
+            break;
+        }
+
+        swapLevels(texture, candidate.level, frame);
+        uploadCount++;
+        uploadBytes += size;
+    }
+
+    for (const Candidate &candidate : promotions) {
+        Texture &texture = m_textures[candidate.id];
+        VkDeviceSize currentSize = getChainSize(texture, texture.baseLevel);
+
+        // Step towards the requested level as far as the limits allow.
+        for (u32 level = candidate.level; level < texture.baseLevel; level++) {
+            VkDeviceSize size = getChainSize(texture, level);
+
+            if (canUpload(size) && m_residentBytes - currentSize + size <= budget) {
+                swapLevels(texture, level, frame);
+                uploadCount++;
+                uploadBytes += size;
+                break;
+            }
+        }
+    }
+
+    if (!frame.isRecording) {
+        return;
+    }
+
+    VkResult res = vkEndCommandBuffer(frame.commandBuffer);
+    vk::check(res, "Failed to end texture streaming command buffer");
+
+    // Submitted ahead of the frame on the same queue, so the barriers in
+    // the upload cover the frame's fragment shader reads.
+    frame.timelineValue = m_device->submit(frame.commandBuffer);
+
+    frame.isRecording = false;
+
+    m_bindlessManager->update();
+}
+
+u32 TextureStreamer::getHandle(u32 id) const
+{
+    const Texture &texture = m_textures[id];
+    return texture.handles[texture.currentHandle];
+}
+
+u32 TextureStreamer::getResidentLevel(u32 id) const
+{
+    return m_textures[id].baseLevel;
+}
+
+VkDeviceSize TextureStreamer::getChainSize(const Texture &texture, u32 baseLevel) const
+{
+    return texture.levelOffsets[texture.levelCount] - texture.levelOffsets[baseLevel];
+}
+
+u32 TextureStreamer::getTargetLevel(const Texture &texture) const
+{
+    if (m_frame - texture.requestFrame > m_options.idleFrames) {
+        return texture.tailLevel;
+    }
+
+    f32 level = std::clamp(
+        std::floor(texture.requestedLevel),
+        0.0f,
+        static_cast<f32>(texture.tailLevel)
+    );
+
+    return static_cast<u32>(level);
+}
+
+VkDeviceSize TextureStreamer::getBudget() const
+{
+    VkDeviceSize available = m_device->getMemoryBudget().getAvailableBytes();
+
+    VkDeviceSize budget = m_residentBytes + static_cast<VkDeviceSize>(
+        static_cast<f64>(available) * m_options.budgetFraction
+    );
+
+    // Near the device budget, streaming gives back what is over it.
+    budget -= std::min(budget, m_pressureBytes);
+
+    return std::min(budget, m_options.budget);
+}
+
+void TextureStreamer::swapLevels(Texture &texture, u32 baseLevel, UploadFrame &frame)
+{
+    if (!frame.isRecording) {
+        vkResetCommandPool(m_device->getDevice(), frame.commandPool, 0);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        VkResult res = vkBeginCommandBuffer(frame.commandBuffer, &beginInfo);
+        vk::check(res, "Failed to begin texture streaming command buffer");
+
+        frame.isRecording = true;
+    }
+
+    VkDeviceSize size = getChainSize(texture, baseLevel);
+
+    StagingAllocation staging = m_device->getStagingPool().allocate(size);
+    memcpy(staging.data, texture.data.data() + texture.levelOffsets[baseLevel], size);
+
+    Image image;
+    image.init(
+        *m_device,
+        std::max(texture.width >> baseLevel, 1u),
+        std::max(texture.height >> baseLevel, 1u),
+        texture.format,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        texture.levelCount - baseLevel
+    );
+
+    image.transitionLayout(
+        frame.commandBuffer,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_2_NONE,
+        VK_PIPELINE_STAGE_2_COPY_BIT
+    );
+
+    image.copyFromBuffer(
+        frame.commandBuffer,
+        staging.buffer,
+        staging.offset,
+        image.getMipLevels()
+    );
+
+    image.transitionLayout(
+        frame.commandBuffer,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_2_COPY_BIT,
+        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT
+    );
+
+    u32 nextHandle = 1 - texture.currentHandle;
+    m_bindlessManager->updateTexture(texture.handles[nextHandle], image, texture.sampler);
+
+    // Frames recorded before the swap may still sample the old image.
+    texture.image.deferDestroy();
+    m_residentBytes += size;
+    m_residentBytes -= getChainSize(texture, texture.baseLevel);
+
+    texture.image = image;
+    texture.baseLevel = baseLevel;
+    texture.currentHandle = nextHandle;
+    texture.swapFrame = m_frame;
+}
+
+} // namespace gfx
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <vector>
+
+#include "core/types.hpp"
+#include "buffer.hpp"
+#include "image.hpp"
+#include "global.hpp"
+
+namespace gfx
+{
+
+class Device;
+class BindlessManager;
+
+struct TextureStreamerOptions
+{
+    // Upper bound on the memory of streamed textures. The device local
+    // heap budget reported by VMA lowers it further when other
+    // allocations grow; `budgetFraction` is the share of the free heap
+    // budget streaming may claim.
+    VkDeviceSize budget = 512ull << 20;
+    f32 budgetFraction = 0.8f;
+
+    // Levels no larger than this stay resident for the lifetime of a
+    // texture, so there is always something to sample.
+    u32 residentDimension = 128;
+
+    u32 maxUploadsPerFrame = 4;
+    VkDeviceSize maxUploadBytesPerFrame = 32ull << 20;
+
+    // Textures not requested for this many frames drop back to their
+    // resident levels.
+    u32 idleFrames = 120;
+};
+
+// Keeps the full mip chain of each texture in system memory and only the
+// levels recently requested on the device. A texture is promoted or
+// demoted by uploading its new chain into a fresh image; the old image is
+// released once no frame in flight can sample it.
+class TextureStreamer
+{
+
+public:
+    TextureStreamer() = default;
+    ~TextureStreamer() = default;
+
+    void init(
+        Device &device,
+        BindlessManager &bindlessManager,
+        const TextureStreamerOptions &options = {}
+    );
+
+    void destroy();
+
+    // `data` holds `levelCount` tightly packed levels, largest first, as
+    // for Image::init. The resident levels are uploaded before returning.
+    u32 addTexture(
+        const void *data,
+        u32 width,
+        u32 height,
+        u32 levelCount,
+        VkFormat format,
+        VkSampler sampler = VK_NULL_HANDLE
+    );
+
+    void removeTexture(u32 id);
+
+    // `uvPerPixel` is how far the texture coordinates move across one
+    // screen pixel. The finest level requested during a frame wins.
+    void request(u32 id, f32 uvPerPixel);
+
+    // Call once per frame before the bindless descriptors are updated.
+    // Records and submits the uploads chosen for this frame without
+    // waiting for them.
+    void update();
+
+public:
+    // Changes whenever a new image becomes resident; query it per draw.
+    u32 getHandle(u32 id) const;
+
+    u32 getResidentLevel(u32 id) const;
+    VkDeviceSize getResidentBytes() const { return m_residentBytes; }
+
+private:
+    struct Texture
+    {
+        std::vector<u8> data;
+        std::vector<VkDeviceSize> levelOffsets;
+
+        u32 width = 0;
+        u32 height = 0;
+        u32 levelCount = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkSampler sampler = VK_NULL_HANDLE;
+
+        Image image;
+        u32 baseLevel = 0;
+        u32 tailLevel = 0;
+
+        // Descriptors of pending frames cannot be rewritten, so each
+        // texture alternates between two bindless slots.
+        std::array<u32, 2> handles = { ~0u, ~0u };
+        u32 currentHandle = 0;
+        u64 swapFrame = 0;
+
+        f32 requestedLevel = 0.0f;
+        u64 requestFrame = 0;
+
+        bool isUsed = false;
+    };
+
+    struct UploadFrame
+    {
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        u64 timelineValue = 0;
+        bool isRecording = false;
+    };
+
+    Device *m_device = nullptr;
+    BindlessManager *m_bindlessManager = nullptr;
+
+    TextureStreamerOptions m_options;
+
+    std::vector<Texture> m_textures;
+    std::vector<u32> m_freeIDs;
+
+    std::array<UploadFrame, MAX_FRAMES_IN_FLIGHT> m_uploadFrames;
+
+    VkDeviceSize m_residentBytes = 0;
+    u64 m_frame = 0;
+
+    u32 m_pressureCallback = ~0u;
+    VkDeviceSize m_pressureBytes = 0;
+
+    VkDeviceSize getChainSize(const Texture &texture, u32 baseLevel) const;
+    u32 getTargetLevel(const Texture &texture) const;
+    VkDeviceSize getBudget() const;
+
+    void swapLevels(Texture &texture, u32 baseLevel, UploadFrame &frame);
+
+};
+
+} // namespace gfx
\ No newline at end of file
@@ -65,6 +65,22 @@ static int rateDeviceSuitability(VkPhysicalDevice device, VkSurfaceKHR surface)
     return score;
 }
 
+static bool isExtensionSupported(VkPhysicalDevice device, const char *name)
+{
+    u32 extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+    for (const auto& extension : availableExtensions) {
+        if (strcmp(extension.extensionName, name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 VkInstance createInstance(const std::string &appName, const Version &version)
 {
     VkApplicationInfo appInfo{};
@@ -157,7 +173,95 @@ VkPhysicalDevice pickPhysicalDevice(VkInstance instance, VkSurfaceKHR surface)
     throw std::runtime_error("Failed to find a suitable GPU");
 }
 
-VkDevice createLogicalDevice(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface)
+DeviceFeatures queryDeviceFeatures(VkPhysicalDevice physicalDevice)
+{
+    DeviceFeatures features;
+
+    VkPhysicalDeviceIndexTypeUint8FeaturesEXT indexTypeUint8Features{};
+    indexTypeUint8Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INDEX_TYPE_UINT8_FEATURES_EXT;
+
+    VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures{};
+    meshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2 deviceFeatures{};
+    deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+
+    // Only chain structures of supported extensions.
+    if (isExtensionSupported(physicalDevice, VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME)) {
+        indexTypeUint8Features.pNext = deviceFeatures.pNext;
+        deviceFeatures.pNext = &indexTypeUint8Features;
+    }
+
+    if (isExtensionSupported(physicalDevice, VK_EXT_MESH_SHADER_EXTENSION_NAME)) {
+        meshShaderFeatures.pNext = deviceFeatures.pNext;
+        deviceFeatures.pNext = &meshShaderFeatures;
+    }
+
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &deviceFeatures);
+
+    features.indexTypeUint8 = indexTypeUint8Features.indexTypeUint8 == VK_TRUE;
+    features.meshShader = meshShaderFeatures.meshShader == VK_TRUE &&
+        meshShaderFeatures.taskShader == VK_TRUE;
+    features.textureCompressionBC =
+        deviceFeatures.features.textureCompressionBC == VK_TRUE;
+    features.storageImageWithoutFormat =
+        deviceFeatures.features.shaderStorageImageReadWithoutFormat == VK_TRUE &&
+        deviceFeatures.features.shaderStorageImageWriteWithoutFormat == VK_TRUE;
+    features.fragmentStores =
+        deviceFeatures.features.fragmentStoresAndAtomics == VK_TRUE;
+
+    VkPhysicalDeviceSubgroupProperties subgroupProperties{};
+    subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &subgroupProperties;
+
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    VkSubgroupFeatureFlags quadOperations =
+        VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_QUAD_BIT;
+
+    features.subgroupQuadCompute =
+        (subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) &&
+        (subgroupProperties.supportedOperations & quadOperations) == quadOperations;
+
+    // Sparse binds go through the graphics queue, whichever graphics
+    // family ends up picked.
+    u32 queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        physicalDevice,
+        &queueFamilyCount,
+        queueFamilies.data()
+    );
+
+    bool sparseQueue = true;
+    for (const auto &family : queueFamilies) {
+        if (
+            (family.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+            !(family.queueFlags & VK_QUEUE_SPARSE_BINDING_BIT)
+        ) {
+            sparseQueue = false;
+        }
+    }
+
+    features.sparseResidency = sparseQueue &&
+        deviceFeatures.features.sparseBinding == VK_TRUE &&
+        deviceFeatures.features.sparseResidencyImage2D == VK_TRUE;
+
+    features.memoryBudget =
+        isExtensionSupported(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    return features;
+}
+
+VkDevice createLogicalDevice(
+    VkPhysicalDevice physicalDevice,
+    VkSurfaceKHR surface,
+    const DeviceFeatures &features
+)
 {
     QueueFamilyIndices indices = findQueueFamilies(physicalDevice, surface);
     
@@ -197,17 +301,56 @@ VkDevice createLogicalDevice(VkPhysicalDevice physicalDevice, VkSurfaceKHR surfa
     vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
     vulkan12Features.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
     vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    vulkan12Features.bufferDeviceAddress = VK_TRUE;
+    vulkan12Features.timelineSemaphore = VK_TRUE;
     vulkan12Features.pNext = &vulkan13Features;
 
     VkPhysicalDeviceFeatures2 deviceFeatures{};
     deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
     deviceFeatures.features.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.features.textureCompressionBC =
+        features.textureCompressionBC ? VK_TRUE : VK_FALSE;
+    deviceFeatures.features.shaderStorageImageReadWithoutFormat =
+        features.storageImageWithoutFormat ? VK_TRUE : VK_FALSE;
+    deviceFeatures.features.shaderStorageImageWriteWithoutFormat =
+        features.storageImageWithoutFormat ? VK_TRUE : VK_FALSE;
+    deviceFeatures.features.sparseBinding =
+        features.sparseResidency ? VK_TRUE : VK_FALSE;
+    deviceFeatures.features.sparseResidencyImage2D =
+        features.sparseResidency ? VK_TRUE : VK_FALSE;
+    deviceFeatures.features.fragmentStoresAndAtomics =
+        features.fragmentStores ? VK_TRUE : VK_FALSE;
     deviceFeatures.pNext = &vulkan12Features;
     
     std::vector<const char*> deviceExtensions = {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME,
         VK_KHR_MAINTENANCE_3_EXTENSION_NAME
     };
+
+    VkPhysicalDeviceIndexTypeUint8FeaturesEXT indexTypeUint8Features{};
+    indexTypeUint8Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INDEX_TYPE_UINT8_FEATURES_EXT;
+    indexTypeUint8Features.indexTypeUint8 = VK_TRUE;
+
+    if (features.indexTypeUint8) {
+        indexTypeUint8Features.pNext = vulkan13Features.pNext;
+        vulkan13Features.pNext = &indexTypeUint8Features;
+        deviceExtensions.push_back(VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME);
+    }
+
+    VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures{};
+    meshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+    meshShaderFeatures.taskShader = VK_TRUE;
+    meshShaderFeatures.meshShader = VK_TRUE;
+
+    if (features.meshShader) {
+        meshShaderFeatures.pNext = vulkan13Features.pNext;
+        vulkan13Features.pNext = &meshShaderFeatures;
+        deviceExtensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+    }
+
+    if (features.memoryBudget) {
+        deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
     
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -680,6 +823,30 @@ VkSemaphore createSemaphore(VkDevice device)
     return semaphore;
 }
 
+VkSemaphore createTimelineSemaphore(VkDevice device, u64 initialValue)
+{
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = initialValue;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    VkSemaphore semaphore;
+    VkResult res = vkCreateSemaphore(
+        device,
+        &semaphoreInfo,
+        nullptr,
+        &semaphore
+    );
+
+    check(res, "Failed to create timeline semaphore");
+
+    return semaphore;
+}
+
 VkFence createFence(VkDevice device, VkFenceCreateFlags flags)
 {
     VkFenceCreateInfo fenceInfo{};
@@ -731,7 +898,8 @@ VkCommandBuffer createCommandBuffer(
 VmaAllocator createAllocator(
     VkInstance instance,
     VkDevice device,
-    VkPhysicalDevice physicalDevice
+    VkPhysicalDevice physicalDevice,
+    const DeviceFeatures &features
 ) {
 
     VmaVulkanFunctions vulkanFunctions{};
@@ -771,6 +939,12 @@ VmaAllocator createAllocator(
     allocatorInfo.physicalDevice = physicalDevice;
     allocatorInfo.device = device;
     allocatorInfo.pVulkanFunctions = &vulkanFunctions;
+    allocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+
+    // Without it VMA estimates budgets from its own allocations only.
+    if (features.memoryBudget) {
+        allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
     
     VmaAllocator allocator;
     VkResult res = vmaCreateAllocator(&allocatorInfo, &allocator);
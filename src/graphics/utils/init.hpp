@@ -11,6 +11,7 @@
 #include <set>
 #include <map>
 #include <string>
+#include <cstring>
 #include <optional>
 #include <stdexcept>
 #include <algorithm>
@@ -47,9 +48,35 @@ VkPhysicalDevice pickPhysicalDevice(
     VkSurfaceKHR surface
 );
 
+struct DeviceFeatures
+{
+    bool indexTypeUint8 = false;
+    bool meshShader = false;
+    bool textureCompressionBC = false;
+
+    // Storage image loads and stores without a format qualifier.
+    bool storageImageWithoutFormat = false;
+
+    // Subgroup quad operations in compute shaders.
+    bool subgroupQuadCompute = false;
+
+    // Partially resident 2D images, bound through the graphics queue.
+    bool sparseResidency = false;
+
+    // Storage buffer writes from fragment shaders, for virtual texture
+    // feedback.
+    bool fragmentStores = false;
+
+    // VK_EXT_memory_budget, for heap budgets that track other processes.
+    bool memoryBudget = false;
+};
+
+DeviceFeatures queryDeviceFeatures(VkPhysicalDevice physicalDevice);
+
 VkDevice createLogicalDevice(
     VkPhysicalDevice physicalDevice,
-    VkSurfaceKHR surface
+    VkSurfaceKHR surface,
+    const DeviceFeatures &features
 );
 
 struct QueueFamilyIndices
@@ -114,6 +141,7 @@ std::vector<VkImageView> createSwapchainImageViews(
 );
 
 VkSemaphore createSemaphore(VkDevice device);
+VkSemaphore createTimelineSemaphore(VkDevice device, u64 initialValue = 0);
 VkFence createFence(VkDevice device, VkFenceCreateFlags flags = 0);
 
 VkCommandPool createCommandPool(
@@ -131,7 +159,8 @@ VkCommandBuffer createCommandBuffer(
 VmaAllocator createAllocator(
     VkInstance instance,
     VkDevice device,
-    VkPhysicalDevice physicalDevice
+    VkPhysicalDevice physicalDevice,
+    const DeviceFeatures &features
 );
 
 } // namespace vk
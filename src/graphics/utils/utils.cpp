@@ -87,6 +87,70 @@ void check(VkResult result, const std::string &msg)
     throw std::runtime_error(errorMsg);
 }
 
+FormatBlock getFormatBlock(VkFormat format)
+{
+    switch (format) {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SRGB:
+            return { 1, 1, 1 };
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SRGB:
+            return { 1, 1, 2 };
+        case VK_FORMAT_R8G8B8_UNORM:
+        case VK_FORMAT_R8G8B8_SRGB:
+            return { 1, 1, 3 };
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_D32_SFLOAT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+            return { 1, 1, 4 };
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+            return { 1, 1, 8 };
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return { 1, 1, 16 };
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK:
+            return { 4, 4, 8 };
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC5_SNORM_BLOCK:
+        case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+        case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return { 4, 4, 16 };
+        default:
+            throw std::invalid_argument(
+                "Unsupported image format: " + std::to_string(format)
+            );
+    }
+}
+
+bool isBlockCompressed(VkFormat format)
+{
+    return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK &&
+        format <= VK_FORMAT_BC7_SRGB_BLOCK;
+}
+
+VkDeviceSize getImageSize(VkFormat format, u32 width, u32 height)
+{
+    FormatBlock block = getFormatBlock(format);
+
+    VkDeviceSize blocksX = (width + block.width - 1) / block.width;
+    VkDeviceSize blocksY = (height + block.height - 1) / block.height;
+
+    return blocksX * blocksY * block.bytes;
+}
+
 } // namespace vk
 
 } // namespace gfx
\ No newline at end of file
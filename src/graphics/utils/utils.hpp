@@ -15,6 +15,21 @@ namespace vk
 
 void check(VkResult result, const std::string &msg);
 
+// Texel block of a format; uncompressed formats have 1x1 blocks.
+struct FormatBlock
+{
+    u32 width = 1;
+    u32 height = 1;
+    u32 bytes = 0;
+};
+
+FormatBlock getFormatBlock(VkFormat format);
+bool isBlockCompressed(VkFormat format);
+
+// Tightly packed size of one `width` x `height` level, rounded up to whole
+// blocks.
+VkDeviceSize getImageSize(VkFormat format, u32 width, u32 height);
+
 } // namespace vk
 
 } // namespace gfx
\ No newline at end of file
@@ -0,0 +1,958 @@
+#include "virtual_texture.hpp"
+#include "device.hpp"
+#include "bindless_manager.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace gfx
+{
+
+namespace
+{
+
+// Header words, mirrored in virtual_texture.glsl.
+constexpr u32 HEADER_MODE = 0;
+constexpr u32 HEADER_WIDTH = 1;
+constexpr u32 HEADER_HEIGHT = 2;
+constexpr u32 HEADER_LEVEL_COUNT = 3;
+constexpr u32 HEADER_TAIL_LEVEL = 4;
+constexpr u32 HEADER_TILE_WIDTH = 5;
+constexpr u32 HEADER_TILE_HEIGHT = 6;
+constexpr u32 HEADER_IMAGE = 7;
+constexpr u32 HEADER_TAIL_IMAGE = 8;
+constexpr u32 HEADER_TAIL_BASE = 9;
+constexpr u32 HEADER_FEEDBACK = 10;
+constexpr u32 HEADER_CACHE_TILES_X = 11;
+constexpr u32 HEADER_LEVEL_OFFSETS = 12;
+
+constexpr VkImageUsageFlags IMAGE_USAGE =
+    VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+u32 divideRoundUp(u32 value, u32 divisor)
+{
+    return (value + divisor - 1) / divisor;
+}
+
+bool getSparseRequirements(
+    VkDevice device,
+    VkImage image,
+    VkSparseImageMemoryRequirements &requirements
+)
+{
+    u32 count = 0;
+    vkGetImageSparseMemoryRequirements(device, image, &count, nullptr);
+    std::vector<VkSparseImageMemoryRequirements> all(count);
+    vkGetImageSparseMemoryRequirements(device, image, &count, all.data());
+
+    for (const auto &candidate : all) {
+        if (candidate.formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) {
+            requirements = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace
+
+void VirtualTexture::init(
+    Device &device,
+    BindlessManager &bindlessManager,
+    u32 width,
+    u32 height,
+    u32 levelCount,
+    VkFormat format,
+    TileProvider provider,
+    const VirtualTextureOptions &options
+)
+{
+    if (levelCount == 0 || levelCount > MAX_LEVELS) {
+        throw std::runtime_error("Invalid virtual texture level count.");
+    }
+
+    m_device = &device;
+    m_bindlessManager = &bindlessManager;
+    m_options = options;
+    m_provider = std::move(provider);
+
+    m_width = width;
+    m_height = height;
+    m_levelCount = levelCount;
+    m_format = format;
+
+    m_mode = !options.forceFallback && isSparseSupported(device, format)
+        ? Mode::Sparse
+        : Mode::Fallback;
+
+    if (m_mode == Mode::Sparse) {
+        initSparse();
+    }
+
+    // The sparse path also ends up here when the image has no mip tail
+    // to keep the coarsest levels resident.
+    if (m_mode == Mode::Fallback) {
+        initFallback();
+    }
+
+    m_slots.resize(m_options.cacheTiles);
+    for (u32 slot = m_options.cacheTiles; slot > 0; slot--) {
+        m_freeSlots.push_back(slot - 1);
+    }
+
+    initPageTable();
+
+    for (auto &frame : m_uploadFrames) {
+        frame.commandPool = vk::createCommandPool(
+            device.getDevice(),
+            device.getQueueFamilyIndices().graphicsFamily.value(),
+            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+        );
+        frame.commandBuffer = vk::createCommandBuffer(
+            device.getDevice(),
+            frame.commandPool
+        );
+    }
+
+    std::cout << "Virtual texture: " << width << "x" << height << ", "
+        << (m_mode == Mode::Sparse ? "sparse" : "page table") << ", "
+        << m_tileWidth << "x" << m_tileHeight << " tiles, "
+        << m_pageCount << " pages above level " << m_tailLevel << std::endl;
+}
+
+void VirtualTexture::destroy()
+{
+    for (auto &frame : m_uploadFrames) {
+        m_device->wait(frame.timelineValue);
+        vkDestroyCommandPool(m_device->getDevice(), frame.commandPool, nullptr);
+    }
+
+    m_bindlessManager->removeResource(m_pageTableHandle);
+    m_bindlessManager->removeResource(m_feedbackHandle);
+    m_bindlessManager->removeResource(m_imageHandle);
+    m_bindlessManager->removeResource(m_tailHandle);
+
+    m_pageTableBuffer.destroy();
+    m_feedbackBuffer.destroy();
+
+    m_image.destroy();
+
+    if (m_mode == Mode::Fallback) {
+        m_tailImage.destroy();
+    }
+
+    if (!m_tileMemory.empty()) {
+        for (VmaAllocation allocation : m_tileMemory) {
+            m_device->getMemoryBudget().untrack(allocation);
+        }
+
+        vmaFreeMemoryPages(
+            m_device->getAllocator(),
+            m_tileMemory.size(),
+            m_tileMemory.data()
+        );
+        m_tileMemory.clear();
+    }
+
+    if (m_mipTailMemory) {
+        m_device->getMemoryBudget().untrack(m_mipTailMemory);
+        vmaFreeMemory(m_device->getAllocator(), m_mipTailMemory);
+        m_mipTailMemory = VK_NULL_HANDLE;
+    }
+
+    m_slots.clear();
+    m_freeSlots.clear();
+    m_pendingPages.clear();
+}
+
+bool VirtualTexture::isSparseSupported(Device &device, VkFormat format)
+{
+    if (!device.getFeatures().sparseResidency) {
+        return false;
+    }
+
+    u32 count = 0;
+    vkGetPhysicalDeviceSparseImageFormatProperties(
+        device.getPhysicalDevice(),
+        format,
+        VK_IMAGE_TYPE_2D,
+        VK_SAMPLE_COUNT_1_BIT,
+        IMAGE_USAGE,
+        VK_IMAGE_TILING_OPTIMAL,
+        &count,
+        nullptr
+    );
+
+    std::vector<VkSparseImageFormatProperties> properties(count);
+    vkGetPhysicalDeviceSparseImageFormatProperties(
+        device.getPhysicalDevice(),
+        format,
+        VK_IMAGE_TYPE_2D,
+        VK_SAMPLE_COUNT_1_BIT,
+        IMAGE_USAGE,
+        VK_IMAGE_TILING_OPTIMAL,
+        &count,
+        properties.data()
+    );
+
+    for (const auto &property : properties) {
+        if (
+            (property.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) &&
+            !(property.flags & VK_SPARSE_IMAGE_FORMAT_NONSTANDARD_BLOCK_SIZE_BIT)
+        ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void VirtualTexture::request(u32 level, f32 u0, f32 v0, f32 u1, f32 v1)
+{
+    if (level >= m_tailLevel) {
+        return;
+    }
+
+    const Level &info = m_levels[level];
+
+    auto toPage = [](f32 coord, u32 size, u32 tile, u32 pages) {
+        f32 texel = std::clamp(coord, 0.0f, 1.0f) * static_cast<f32>(size);
+        return std::min(static_cast<u32>(texel) / tile, pages - 1);
+    };
+
+    u32 x0 = toPage(std::min(u0, u1), info.width, m_tileWidth, info.pagesX);
+    u32 x1 = toPage(std::max(u0, u1), info.width, m_tileWidth, info.pagesX);
+    u32 y0 = toPage(std::min(v0, v1), info.height, m_tileHeight, info.pagesY);
+    u32 y1 = toPage(std::max(v0, v1), info.height, m_tileHeight, info.pagesY);
+
+    for (u32 y = y0; y <= y1; y++) {
+        for (u32 x = x0; x <= x1; x++) {
+            touchPage(getPage(level, x, y));
+        }
+    }
+}
+
+void VirtualTexture::update()
+{
+    m_frame++;
+
+    // Loads of this slot from MAX_FRAMES_IN_FLIGHT updates ago are still
+    // running; try again next frame instead of stalling.
+    UploadFrame &frame = m_uploadFrames[m_frame % MAX_FRAMES_IN_FLIGHT];
+    if (!m_device->isComplete(frame.timelineValue)) {
+        return;
+    }
+
+    readFeedback();
+
+    std::vector<VkSparseImageMemoryBind> binds;
+
+    // Slots retired before any frame still in flight was recorded can
+    // hold a new tile. Their old sparse binding goes first in the batch.
+    for (u32 slot = 0; slot < m_slots.size(); slot++) {
+        Slot &info = m_slots[slot];
+        if (!info.isRetiring || m_frame - info.retireFrame <= MAX_FRAMES_IN_FLIGHT) {
+            continue;
+        }
+
+        if (m_mode == Mode::Sparse) {
+            unbindPage(info.page, binds);
+        }
+
+        info.page = ~0u;
+        info.isRetiring = false;
+        m_freeSlots.push_back(slot);
+    }
+
+    auto isDone = [&](u32 page) {
+        bool isStale = m_frame - m_pageRequests[page] > m_options.requestFrames;
+        if (m_pageSlots[page] != ~0u || isStale) {
+            m_pagePending[page] = false;
+            return true;
+        }
+        return false;
+    };
+
+    m_pendingPages.erase(
+        std::remove_if(m_pendingPages.begin(), m_pendingPages.end(), isDone),
+        m_pendingPages.end()
+    );
+
+    // Coarse tiles first, they are what finer requests fall back to.
+    std::sort(m_pendingPages.begin(), m_pendingPages.end(), [&](u32 a, u32 b) {
+        u32 levelA = getPageLevel(a);
+        u32 levelB = getPageLevel(b);
+        if (levelA != levelB) {
+            return levelA > levelB;
+        }
+        return m_pageRequests[a] > m_pageRequests[b];
+    });
+
+    u32 loadCount = std::min(
+        static_cast<u32>(m_pendingPages.size()),
+        m_options.maxUploadsPerFrame
+    );
+
+    // Slots retired now become usable a few frames later.
+    if (m_freeSlots.size() < loadCount) {
+        retireSlots(loadCount - static_cast<u32>(m_freeSlots.size()));
+    }
+
+    loadCount = std::min(loadCount, static_cast<u32>(m_freeSlots.size()));
+
+    if (loadCount == 0 && binds.empty() && m_dirtyPages.empty()) {
+        return;
+    }
+
+    std::sort(m_dirtyPages.begin(), m_dirtyPages.end());
+
+    VkDeviceSize stagingSize = 0;
+    for (u32 i = 0; i < loadCount; i++) {
+        u32 page = m_pendingPages[i];
+        u32 level = getPageLevel(page);
+        const Level &info = m_levels[level];
+        u32 local = page - info.firstPage;
+
+        u32 x = (local % info.pagesX) * m_tileWidth;
+        u32 y = (local / info.pagesX) * m_tileHeight;
+
+        stagingSize += vk::getImageSize(
+            m_format,
+            std::min(m_tileWidth, info.width - x),
+            std::min(m_tileHeight, info.height - y)
+        );
+    }
+
+    // Page table words follow the tiles; new entries are written below.
+    VkDeviceSize tableOffset = (stagingSize + 3) & ~VkDeviceSize(3);
+    VkDeviceSize tableSize = (m_dirtyPages.size() + loadCount) * sizeof(u32);
+
+    StagingAllocation stagingAllocation =
+        m_device->getStagingPool().allocate(tableOffset + tableSize);
+
+    u8 *staging = stagingAllocation.data;
+
+    std::vector<VkBufferImageCopy> copies;
+    VkDeviceSize offset = 0;
+
+    for (u32 i = 0; i < loadCount; i++) {
+        u32 page = m_pendingPages[i];
+        u32 slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+
+        offset += loadPage(page, slot, staging, offset, binds, copies);
+
+        m_pagePending[page] = false;
+        m_dirtyPages.push_back(page);
+    }
+
+    m_pendingPages.erase(m_pendingPages.begin(), m_pendingPages.begin() + loadCount);
+
+    std::sort(m_dirtyPages.begin(), m_dirtyPages.end());
+    m_dirtyPages.erase(
+        std::unique(m_dirtyPages.begin(), m_dirtyPages.end()),
+        m_dirtyPages.end()
+    );
+
+    std::vector<VkBufferCopy> tableCopies;
+    u32 *words = reinterpret_cast<u32 *>(staging + tableOffset);
+
+    for (usize i = 0; i < m_dirtyPages.size(); i++) {
+        u32 word = HEADER_WORDS + m_dirtyPages[i];
+        words[i] = m_pageTable[word];
+
+        tableCopies.push_back({
+            tableOffset + i * sizeof(u32),
+            word * sizeof(u32),
+            sizeof(u32)
+        });
+    }
+
+    m_dirtyPages.clear();
+
+    // Offsets above are relative to the allocation.
+    for (VkBufferImageCopy &copy : copies) {
+        copy.bufferOffset += stagingAllocation.offset;
+    }
+
+    for (VkBufferCopy &copy : tableCopies) {
+        copy.srcOffset += stagingAllocation.offset;
+    }
+
+    vkResetCommandPool(m_device->getDevice(), frame.commandPool, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VkResult res = vkBeginCommandBuffer(frame.commandBuffer, &beginInfo);
+    vk::check(res, "Failed to begin virtual texture command buffer");
+
+    VkCommandBuffer cmd = frame.commandBuffer;
+
+    // Frames recorded earlier may still read the page table and the
+    // image; the barrier waits for them before anything is overwritten.
+    VkMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.memoryBarrierCount = 1;
+    dependencyInfo.pMemoryBarriers = &barrier;
+
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+
+    if (!copies.empty()) {
+        m_image.transitionLayout(
+            cmd,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_2_COPY_BIT
+        );
+
+        vkCmdCopyBufferToImage(
+            cmd,
+            stagingAllocation.buffer,
+            m_image.getImage(),
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<u32>(copies.size()),
+            copies.data()
+        );
+
+        m_image.transitionLayout(
+            cmd,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_2_COPY_BIT,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
+        );
+    }
+
+    if (!tableCopies.empty()) {
+        vkCmdCopyBuffer(
+            cmd,
+            stagingAllocation.buffer,
+            m_pageTableBuffer.getBuffer(),
+            static_cast<u32>(tableCopies.size()),
+            tableCopies.data()
+        );
+    }
+
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+
+    res = vkEndCommandBuffer(cmd);
+    vk::check(res, "Failed to end virtual texture command buffer");
+
+    // Tiles must be bound before their copies run.
+    std::vector<VkSemaphoreSubmitInfo> waits;
+
+    if (!binds.empty()) {
+        VkSparseImageMemoryBindInfo imageBind{};
+        imageBind.image = m_image.getImage();
+        imageBind.bindCount = static_cast<u32>(binds.size());
+        imageBind.pBinds = binds.data();
+
+        VkBindSparseInfo bindInfo{};
+        bindInfo.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+        bindInfo.imageBindCount = 1;
+        bindInfo.pImageBinds = &imageBind;
+
+        VkSemaphoreSubmitInfo bindWait{};
+        bindWait.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        bindWait.semaphore = m_device->getTimeline();
+        bindWait.value = m_device->bindSparse(bindInfo);
+        bindWait.stageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+        waits.push_back(bindWait);
+    }
+
+    frame.timelineValue = m_device->submit(cmd, waits);
+}
+
+u32 VirtualTexture::getResidentTileCount() const
+{
+    u32 count = 0;
+    for (const Slot &slot : m_slots) {
+        count += slot.page != ~0u && !slot.isRetiring;
+    }
+
+    return count;
+}
+
+void VirtualTexture::initSparse()
+{
+    m_image.initSparse(*m_device, m_width, m_height, m_levelCount, m_format, IMAGE_USAGE);
+
+    VkSparseImageMemoryRequirements sparse{};
+    bool hasRequirements = getSparseRequirements(
+        m_device->getDevice(),
+        m_image.getImage(),
+        sparse
+    );
+
+    // Without a mip tail nothing is guaranteed to be resident.
+    if (!hasRequirements || sparse.imageMipTailFirstLod >= m_levelCount) {
+        std::cout << "Virtual texture has no sparse mip tail, using page table" << std::endl;
+        m_image.destroy();
+        m_image = Image{};
+        m_mode = Mode::Fallback;
+        return;
+    }
+
+    m_tileWidth = sparse.formatProperties.imageGranularity.width;
+    m_tileHeight = sparse.formatProperties.imageGranularity.height;
+    m_tailLevel = sparse.imageMipTailFirstLod;
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(m_device->getDevice(), m_image.getImage(), &requirements);
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    // One tile of memory per cache slot, each exactly one sparse block.
+    VkMemoryRequirements tileRequirements = requirements;
+    tileRequirements.size = requirements.alignment;
+
+    m_tileMemory.resize(m_options.cacheTiles);
+    VkResult res = vmaAllocateMemoryPages(
+        m_device->getAllocator(),
+        &tileRequirements,
+        &allocInfo,
+        m_tileMemory.size(),
+        m_tileMemory.data(),
+        nullptr
+    );
+
+    vk::check(res, "Failed to allocate virtual texture tiles");
+
+    VkMemoryRequirements tailRequirements = requirements;
+    tailRequirements.size = sparse.imageMipTailSize;
+
+    VmaAllocationInfo tailInfo{};
+    res = vmaAllocateMemory(
+        m_device->getAllocator(),
+        &tailRequirements,
+        &allocInfo,
+        &m_mipTailMemory,
+        &tailInfo
+    );
+
+    vk::check(res, "Failed to allocate virtual texture mip tail");
+
+    for (VmaAllocation allocation : m_tileMemory) {
+        m_device->getMemoryBudget().track(allocation, MemoryBudget::Category::Texture);
+    }
+    m_device->getMemoryBudget().track(m_mipTailMemory, MemoryBudget::Category::Texture);
+
+    VkSparseMemoryBind tailBind{};
+    tailBind.resourceOffset = sparse.imageMipTailOffset;
+    tailBind.size = sparse.imageMipTailSize;
+    tailBind.memory = tailInfo.deviceMemory;
+    tailBind.memoryOffset = tailInfo.offset;
+
+    VkSparseImageOpaqueMemoryBindInfo opaqueBind{};
+    opaqueBind.image = m_image.getImage();
+    opaqueBind.bindCount = 1;
+    opaqueBind.pBinds = &tailBind;
+
+    VkBindSparseInfo bindInfo{};
+    bindInfo.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+    bindInfo.imageOpaqueBindCount = 1;
+    bindInfo.pImageOpaqueBinds = &opaqueBind;
+
+    m_device->wait(m_device->bindSparse(bindInfo));
+
+    // The tail levels are uploaded once and stay resident.
+    std::vector<VkBufferImageCopy> copies;
+    VkDeviceSize tailSize = 0;
+
+    for (u32 level = m_tailLevel; level < m_levelCount; level++) {
+        u32 width = std::max(m_width >> level, 1u);
+        u32 height = std::max(m_height >> level, 1u);
+
+        VkBufferImageCopy copy{};
+        copy.bufferOffset = tailSize;
+        copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy.imageSubresource.mipLevel = level;
+        copy.imageSubresource.layerCount = 1;
+        copy.imageExtent = { width, height, 1 };
+        copies.push_back(copy);
+
+        tailSize += vk::getImageSize(m_format, width, height);
+    }
+
+    StagingAllocation staging = m_device->getStagingPool().allocate(tailSize);
+    for (VkBufferImageCopy &copy : copies) {
+        m_provider(
+            copy.imageSubresource.mipLevel,
+            0,
+            0,
+            copy.imageExtent.width,
+            copy.imageExtent.height,
+            staging.data + copy.bufferOffset
+        );
+
+        copy.bufferOffset += staging.offset;
+    }
+
+    VkCommandBuffer cmd = m_device->beginSingleTimeCommands();
+
+    m_image.transitionLayout(
+        cmd,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_2_NONE,
+        VK_PIPELINE_STAGE_2_COPY_BIT
+    );
+
+    vkCmdCopyBufferToImage(
+        cmd,
+        staging.buffer,
+        m_image.getImage(),
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<u32>(copies.size()),
+        copies.data()
+    );
+
+    m_image.transitionLayout(
+        cmd,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_2_COPY_BIT,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
+    );
+
+    m_device->endSingleTimeCommands(cmd);
+
+    m_imageHandle = m_bindlessManager->addTexture(m_image);
+    m_tailHandle = m_imageHandle;
+}
+
+void VirtualTexture::initFallback()
+{
+    m_tileWidth = m_options.tileSize;
+    m_tileHeight = m_options.tileSize;
+
+    // The first level fitting in one tile and everything below it is a
+    // regular image; a partial chain keeps at least its last level.
+    m_tailLevel = m_levelCount - 1;
+    for (u32 level = 0; level < m_levelCount; level++) {
+        if (
+            std::max(m_width >> level, 1u) <= m_tileWidth &&
+            std::max(m_height >> level, 1u) <= m_tileHeight
+        ) {
+            m_tailLevel = level;
+            break;
+        }
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_device->getPhysicalDevice(), &properties);
+
+    u32 maxTiles = properties.limits.maxImageDimension2D / m_tileWidth;
+    m_options.cacheTiles = std::min(m_options.cacheTiles, maxTiles * maxTiles);
+
+    m_cacheTilesX = static_cast<u32>(
+        std::ceil(std::sqrt(static_cast<f32>(m_options.cacheTiles)))
+    );
+    u32 cacheTilesY = divideRoundUp(m_options.cacheTiles, m_cacheTilesX);
+
+    m_image.init(
+        *m_device,
+        m_cacheTilesX * m_tileWidth,
+        cacheTilesY * m_tileHeight,
+        m_format,
+        IMAGE_USAGE
+    );
+
+    m_image.transitionLayout(
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+    );
+
+    std::vector<u8> tail;
+    for (u32 level = m_tailLevel; level < m_levelCount; level++) {
+        u32 width = std::max(m_width >> level, 1u);
+        u32 height = std::max(m_height >> level, 1u);
+
+        usize offset = tail.size();
+        tail.resize(offset + vk::getImageSize(m_format, width, height));
+        m_provider(level, 0, 0, width, height, tail.data() + offset);
+    }
+
+    m_tailImage.init(
+        *m_device,
+        tail.data(),
+        std::max(m_width >> m_tailLevel, 1u),
+        std::max(m_height >> m_tailLevel, 1u),
+        m_levelCount - m_tailLevel,
+        m_format
+    );
+
+    m_imageHandle = m_bindlessManager->addTexture(m_image);
+    m_tailHandle = m_bindlessManager->addTexture(m_tailImage);
+}
+
+void VirtualTexture::initPageTable()
+{
+    m_levels.resize(m_tailLevel);
+    m_pageCount = 0;
+
+    for (u32 level = 0; level < m_tailLevel; level++) {
+        Level &info = m_levels[level];
+        info.width = std::max(m_width >> level, 1u);
+        info.height = std::max(m_height >> level, 1u);
+        info.pagesX = divideRoundUp(info.width, m_tileWidth);
+        info.pagesY = divideRoundUp(info.height, m_tileHeight);
+        info.firstPage = m_pageCount;
+
+        m_pageCount += info.pagesX * info.pagesY;
+    }
+
+    m_pageSlots.assign(m_pageCount, ~0u);
+    m_pageRequests.assign(m_pageCount, 0);
+    m_pagePending.assign(m_pageCount, false);
+
+    m_pageTable.assign(HEADER_WORDS + m_pageCount, 0);
+    m_pageTable[HEADER_MODE] = static_cast<u32>(m_mode);
+    m_pageTable[HEADER_WIDTH] = m_width;
+    m_pageTable[HEADER_HEIGHT] = m_height;
+    m_pageTable[HEADER_LEVEL_COUNT] = m_levelCount;
+    m_pageTable[HEADER_TAIL_LEVEL] = m_tailLevel;
+    m_pageTable[HEADER_TILE_WIDTH] = m_tileWidth;
+    m_pageTable[HEADER_TILE_HEIGHT] = m_tileHeight;
+    m_pageTable[HEADER_IMAGE] = m_bindlessManager->getIndex(m_imageHandle);
+    m_pageTable[HEADER_TAIL_IMAGE] = m_bindlessManager->getIndex(m_tailHandle);
+    m_pageTable[HEADER_TAIL_BASE] = m_mode == Mode::Sparse ? 0 : m_tailLevel;
+    m_pageTable[HEADER_CACHE_TILES_X] = m_cacheTilesX;
+
+    for (u32 level = 0; level < m_tailLevel; level++) {
+        m_pageTable[HEADER_LEVEL_OFFSETS + level] = HEADER_WORDS + m_levels[level].firstPage;
+    }
+
+    VkDeviceSize size = m_pageTable.size() * sizeof(u32);
+
+    // Read back on the host, so it lives in cached system memory.
+    m_feedbackBuffer.init(
+        *m_device,
+        size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VMA_MEMORY_USAGE_GPU_TO_CPU,
+        Buffer::HostAccess::Random
+    );
+
+    memset(m_feedbackBuffer.map(), 0, size);
+    m_feedbackBuffer.flush();
+
+    m_feedbackHandle = m_bindlessManager->addSSBO(m_feedbackBuffer);
+    m_pageTable[HEADER_FEEDBACK] = m_bindlessManager->getIndex(m_feedbackHandle);
+
+    m_pageTableBuffer.init(
+        *m_device,
+        size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+    );
+
+    m_pageTableBuffer.upload(m_pageTable.data(), size);
+
+    m_pageTableHandle = m_bindlessManager->addSSBO(m_pageTableBuffer);
+}
+
+u32 VirtualTexture::getPageTableIndex() const
+{
+    return m_bindlessManager->getIndex(m_pageTableHandle);
+}
+
+u32 VirtualTexture::getPage(u32 level, u32 pageX, u32 pageY) const
+{
+    const Level &info = m_levels[level];
+    return info.firstPage + pageY * info.pagesX + pageX;
+}
+
+u32 VirtualTexture::getPageLevel(u32 page) const
+{
+    u32 level = 0;
+    while (level + 1 < m_levels.size() && m_levels[level + 1].firstPage <= page) {
+        level++;
+    }
+
+    return level;
+}
+
+void VirtualTexture::touchPage(u32 page)
+{
+    // The coarser tiles under a requested one are what it falls back to,
+    // so they are kept and loaded along with it.
+    u32 level = getPageLevel(page);
+    u32 local = page - m_levels[level].firstPage;
+    u32 pageX = local % m_levels[level].pagesX;
+    u32 pageY = local / m_levels[level].pagesX;
+
+    for (; level < m_tailLevel; level++) {
+        page = getPage(level, pageX, pageY);
+        m_pageRequests[page] = m_frame;
+
+        if (m_pageSlots[page] != ~0u) {
+            m_slots[m_pageSlots[page]].lastUsed = m_frame;
+        } else if (!m_pagePending[page]) {
+            m_pagePending[page] = true;
+            m_pendingPages.push_back(page);
+        }
+
+        pageX /= 2;
+        pageY /= 2;
+    }
+}
+
+void VirtualTexture::readFeedback()
+{
+    // Shaders keep writing while this runs; a request cleared right
+    // after it was set is simply made again next frame.
+    m_feedbackBuffer.invalidate();
+
+    u32 *words = static_cast<u32 *>(m_feedbackBuffer.map()) + HEADER_WORDS;
+    for (u32 page = 0; page < m_pageCount; page++) {
+        if (words[page] != 0) {
+            words[page] = 0;
+            touchPage(page);
+        }
+    }
+
+    m_feedbackBuffer.flush();
+}
+
+void VirtualTexture::retireSlots(u32 count)
+{
+    // Tiles requested in the last frames are still on screen.
+    std::vector<u32> candidates;
+    for (u32 slot = 0; slot < m_slots.size(); slot++) {
+        const Slot &info = m_slots[slot];
+        if (
+            info.page != ~0u &&
+            !info.isRetiring &&
+            m_frame - info.lastUsed > MAX_FRAMES_IN_FLIGHT
+        ) {
+            candidates.push_back(slot);
+        }
+    }
+
+    count = std::min(count, static_cast<u32>(candidates.size()));
+    std::partial_sort(
+        candidates.begin(),
+        candidates.begin() + count,
+        candidates.end(),
+        [&](u32 a, u32 b) { return m_slots[a].lastUsed < m_slots[b].lastUsed; }
+    );
+
+    for (u32 i = 0; i < count; i++) {
+        Slot &info = m_slots[candidates[i]];
+        info.isRetiring = true;
+        info.retireFrame = m_frame;
+
+        m_pageSlots[info.page] = ~0u;
+        m_pageTable[HEADER_WORDS + info.page] = 0;
+        m_dirtyPages.push_back(info.page);
+    }
+}
+
+VkDeviceSize VirtualTexture::loadPage(
+    u32 page,
+    u32 slot,
+    u8 *staging,
+    VkDeviceSize offset,
+    std::vector<VkSparseImageMemoryBind> &binds,
+    std::vector<VkBufferImageCopy> &copies
+)
+{
+    u32 level = getPageLevel(page);
+    const Level &info = m_levels[level];
+    u32 local = page - info.firstPage;
+
+    u32 x = (local % info.pagesX) * m_tileWidth;
+    u32 y = (local / info.pagesX) * m_tileHeight;
+    u32 width = std::min(m_tileWidth, info.width - x);
+    u32 height = std::min(m_tileHeight, info.height - y);
+
+    m_provider(level, x, y, width, height, staging + offset);
+
+    VkBufferImageCopy copy{};
+    copy.bufferOffset = offset;
+    copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy.imageSubresource.layerCount = 1;
+
+    if (m_mode == Mode::Sparse) {
+        VmaAllocationInfo memory;
+        vmaGetAllocationInfo(m_device->getAllocator(), m_tileMemory[slot], &memory);
+
+        VkSparseImageMemoryBind bind{};
+        bind.subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        bind.subresource.mipLevel = level;
+        bind.offset = { static_cast<i32>(x), static_cast<i32>(y), 0 };
+        bind.extent = { width, height, 1 };
+        bind.memory = memory.deviceMemory;
+        bind.memoryOffset = memory.offset;
+        binds.push_back(bind);
+
+        copy.imageSubresource.mipLevel = level;
+        copy.imageOffset = { static_cast<i32>(x), static_cast<i32>(y), 0 };
+        copy.imageExtent = { width, height, 1 };
+    } else {
+        // Partial edge tiles are copied as whole blocks, which the atlas
+        // always has room for.
+        vk::FormatBlock block = vk::getFormatBlock(m_format);
+        u32 slotX = slot % m_cacheTilesX;
+        u32 slotY = slot / m_cacheTilesX;
+
+        copy.imageOffset = {
+            static_cast<i32>(slotX * m_tileWidth),
+            static_cast<i32>(slotY * m_tileHeight),
+            0
+        };
+        copy.imageExtent = {
+            divideRoundUp(width, block.width) * block.width,
+            divideRoundUp(height, block.height) * block.height,
+            1
+        };
+    }
+
+    copies.push_back(copy);
+
+    m_slots[slot].page = page;
+    m_slots[slot].lastUsed = m_frame;
+    m_pageSlots[page] = slot;
+    m_pageTable[HEADER_WORDS + page] = RESIDENT_BIT | slot;
+
+    return vk::getImageSize(m_format, width, height);
+}
+
+void VirtualTexture::unbindPage(u32 page, std::vector<VkSparseImageMemoryBind> &binds) const
+{
+    u32 level = getPageLevel(page);
+    const Level &info = m_levels[level];
+    u32 local = page - info.firstPage;
+
+    u32 x = (local % info.pagesX) * m_tileWidth;
+    u32 y = (local / info.pagesX) * m_tileHeight;
+
+    VkSparseImageMemoryBind bind{};
+    bind.subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    bind.subresource.mipLevel = level;
+    bind.offset = { static_cast<i32>(x), static_cast<i32>(y), 0 };
+    bind.extent = {
+        std::min(m_tileWidth, info.width - x),
+        std::min(m_tileHeight, info.height - y),
+        1
+    };
+    bind.memory = VK_NULL_HANDLE;
+    binds.push_back(bind);
+}
+
+} // namespace gfx
\ No newline at end of file
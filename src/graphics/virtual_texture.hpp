@@ -0,0 +1,216 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include <array>
+#include <functional>
+#include <vector>
+
+#include "core/types.hpp"
+#include "buffer.hpp"
+#include "image.hpp"
+#include "global.hpp"
+
+namespace gfx
+{
+
+class Device;
+class BindlessManager;
+
+struct VirtualTextureOptions
+{
+    // Tile edge of the software path; the sparse path uses the tile shape
+    // of the device. Must be a multiple of the format's block size.
+    u32 tileSize = 128;
+
+    // Tiles resident at once, shared by all levels.
+    u32 cacheTiles = 1024;
+
+    u32 maxUploadsPerFrame = 16;
+
+    // Requested tiles not loaded within this many frames are dropped.
+    u32 requestFrames = 30;
+
+    // Use the page table indirection even when sparse residency works.
+    bool forceFallback = false;
+};
+
+// Very large textures of which only the sampled tiles are resident. With
+// sparse residency the tiles are bound straight into one sparse image;
+// otherwise they live in a cache atlas behind a page table indirection.
+//
+// Shaders sample through virtual_texture.glsl with getPageTableIndex().
+// The page table (an SSBO mirrored from m_pageTable) starts with a header
+// of HEADER_WORDS words, followed by one entry per tile for every level
+// finer than the tail. Entries are RESIDENT_BIT | cache slot. Shaders
+// mark the tiles they want in a feedback buffer of the same layout, which
+// update() reads back a few frames later.
+class VirtualTexture
+{
+
+public:
+    enum class Mode : u32
+    {
+        Sparse,
+        Fallback
+    };
+
+    // Fills `dst` with the texels of `level` in the rectangle at (x, y),
+    // tightly packed in the texture format. Block compressed formats
+    // receive whole blocks, rounded up past the level edge.
+    using TileProvider = std::function<void(
+        u32 level,
+        u32 x,
+        u32 y,
+        u32 width,
+        u32 height,
+        u8 *dst
+    )>;
+
+    VirtualTexture() = default;
+    ~VirtualTexture() = default;
+
+    // The levels from the tail on are resident from the start.
+    void init(
+        Device &device,
+        BindlessManager &bindlessManager,
+        u32 width,
+        u32 height,
+        u32 levelCount,
+        VkFormat format,
+        TileProvider provider,
+        const VirtualTextureOptions &options = {}
+    );
+
+    void destroy();
+
+    // CPU side request for the tiles of `level` under a texture
+    // coordinate rectangle, in addition to the shader feedback.
+    void request(u32 level, f32 u0, f32 v0, f32 u1, f32 v1);
+
+    // Call once per frame before the bindless descriptors are updated.
+    // Reads feedback, evicts the least recently used tiles and submits
+    // the loads chosen for this frame without waiting for them.
+    void update();
+
+    static bool isSparseSupported(Device &device, VkFormat format);
+
+public:
+    Mode getMode() const { return m_mode; }
+    u32 getHandle() const { return m_pageTableHandle; }
+
+    // Element of the bindless storage buffer array holding the page table.
+    u32 getPageTableIndex() const;
+
+    u32 getTileWidth() const { return m_tileWidth; }
+    u32 getTileHeight() const { return m_tileHeight; }
+    u32 getTailLevel() const { return m_tailLevel; }
+    u32 getResidentTileCount() const;
+
+public:
+    static constexpr u32 MAX_LEVELS = 20;
+    static constexpr u32 HEADER_WORDS = 12 + MAX_LEVELS;
+    static constexpr u32 RESIDENT_BIT = 0x80000000u;
+
+private:
+    struct Level
+    {
+        u32 width = 0;
+        u32 height = 0;
+        u32 pagesX = 0;
+        u32 pagesY = 0;
+        u32 firstPage = 0;
+    };
+
+    struct Slot
+    {
+        u32 page = ~0u;
+        u64 lastUsed = 0;
+        u64 retireFrame = 0;
+        bool isRetiring = false;
+    };
+
+    struct UploadFrame
+    {
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        u64 timelineValue = 0;
+    };
+
+    Device *m_device = nullptr;
+    BindlessManager *m_bindlessManager = nullptr;
+
+    VirtualTextureOptions m_options;
+    TileProvider m_provider;
+    Mode m_mode = Mode::Fallback;
+
+    u32 m_width = 0;
+    u32 m_height = 0;
+    u32 m_levelCount = 0;
+    VkFormat m_format = VK_FORMAT_UNDEFINED;
+
+    u32 m_tileWidth = 0;
+    u32 m_tileHeight = 0;
+    u32 m_tailLevel = 0;
+    u32 m_cacheTilesX = 0;
+
+    std::vector<Level> m_levels;
+    u32 m_pageCount = 0;
+
+    // Header and entries as last sent to the device.
+    std::vector<u32> m_pageTable;
+    std::vector<u32> m_dirtyPages;
+
+    std::vector<u32> m_pageSlots;
+    std::vector<u64> m_pageRequests;
+    std::vector<bool> m_pagePending;
+    std::vector<u32> m_pendingPages;
+
+    std::vector<Slot> m_slots;
+    std::vector<u32> m_freeSlots;
+
+    // Sparse image or cache atlas, and the tail levels of the fallback.
+    Image m_image;
+    Image m_tailImage;
+
+    std::vector<VmaAllocation> m_tileMemory;
+    VmaAllocation m_mipTailMemory = VK_NULL_HANDLE;
+
+    Buffer m_pageTableBuffer;
+    Buffer m_feedbackBuffer;
+
+    u32 m_imageHandle = ~0u;
+    u32 m_tailHandle = ~0u;
+    u32 m_pageTableHandle = ~0u;
+    u32 m_feedbackHandle = ~0u;
+
+    std::array<UploadFrame, MAX_FRAMES_IN_FLIGHT> m_uploadFrames;
+    u64 m_frame = 0;
+
+    void initSparse();
+    void initFallback();
+    void initPageTable();
+
+    u32 getPage(u32 level, u32 pageX, u32 pageY) const;
+    u32 getPageLevel(u32 page) const;
+
+    void touchPage(u32 page);
+    void readFeedback();
+    void retireSlots(u32 count);
+
+    // Writes the tile into `staging` at `offset` and returns its size.
+    VkDeviceSize loadPage(
+        u32 page,
+        u32 slot,
+        u8 *staging,
+        VkDeviceSize offset,
+        std::vector<VkSparseImageMemoryBind> &binds,
+        std::vector<VkBufferImageCopy> &copies
+    );
+
+    void unbindPage(u32 page, std::vector<VkSparseImageMemoryBind> &binds) const;
+
+};
+
+} // namespace gfx
\ No newline at end of file
@@ -6,19 +6,29 @@
 #include "graphics/bindless_manager.hpp"
 #include "graphics/camera.hpp"
 #include "graphics/model_manager.hpp"
+#include "graphics/virtual_texture.hpp"
+#include "graphics/texture/mipmaps.hpp"
 
 struct CamUBO
 {
     alignas(16) glm::mat4 view;
     alignas(16) glm::mat4 proj;
+    alignas(16) glm::vec4 position;
 };
 
 struct PushConstant
 {
     alignas(16) glm::mat4 model;
-    alignas(4) u32 index;
+    alignas(8) VkDeviceAddress camera;
+    alignas(4) u32 vertexFormat;
 };
 
+// Offset of the page table index in virtual_texture.frag.
+constexpr u32 VIRTUAL_TEXTURE_PUSH_OFFSET =
+    sizeof(PushConstant) + sizeof(gfx::Mesh::VertexPullPushConstants);
+
+static_assert(VIRTUAL_TEXTURE_PUSH_OFFSET == 88);
+
 int main()
 {
     core::Window window;
@@ -31,43 +41,136 @@ int main()
 
     gfx::ModelManager modelManager;
     modelManager.init(device, bindlessManager);
-    u32 cubeID = modelManager.loadModel("assets/models/bingus.gltf");
+    u32 cubeID = modelManager.loadModel(
+        "assets/models/bingus.gltf",
+        { .vertexFormat = gfx::VertexFormat::Packed }
+    );
+    gfx::Model *cubeModel = modelManager.getModel(cubeID);
 
     gfx::Camera camera;
     camera.setPosition({0.0f, 0.0f, 10.0f});
 
-    gfx::Buffer cameraBuffer;
-    cameraBuffer.init(
-        device,
-        sizeof(CamUBO),
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VMA_MEMORY_USAGE_CPU_TO_GPU
-    );
+    bool packed = cubeModel->getVertexFormat() == gfx::VertexFormat::Packed;
+
+    auto binding = packed ?
+        gfx::Mesh::PackedVertex::getBindingDescription() :
+        gfx::Mesh::Vertex::getBindingDescription();
+    auto attributes = packed ?
+        gfx::Mesh::PackedVertex::getAttributeDescriptions() :
+        gfx::Mesh::Vertex::getAttributeDescriptions();
+
+    // Vertex pulling reads vertices in the shader, so the pipeline has no
+    // vertex input state and draws either vertex format.
+    bool pullVertices = true;
+
+    gfx::Pipeline pipeline;
+    if (pullVertices) {
+        pipeline = gfx::Pipeline::Builder(device)
+            .setShader("assets/shaders/mesh_pull.vert.spv", VK_SHADER_STAGE_VERTEX_BIT)
+            .setShader("assets/shaders/mesh.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
+            .setColorFormat(device.getSwapchain().getFormat())
+            .addPushConstantRange({
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                .offset = 0,
+                .size = sizeof(PushConstant) + sizeof(gfx::Mesh::VertexPullPushConstants)
+            })
+            .setDepthTest(true)
+            .setDepthWrite(true)
+            .build();
+    } else {
+        pipeline = gfx::Pipeline::Builder(device)
+            .setShader("assets/shaders/mesh.vert.spv", VK_SHADER_STAGE_VERTEX_BIT)
+            .setShader("assets/shaders/mesh.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
+            .setColorFormat(device.getSwapchain().getFormat())
+            .setVertexInput({
+                .binding = &binding,
+                .attribute = attributes.data(),
+                .attributeCount = static_cast<u32>(attributes.size())
+            })
+            .addPushConstantRange({
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                .offset = 0,
+                .size = sizeof(PushConstant)
+            })
+            .setDepthTest(true)
+            .setDepthWrite(true)
+            .build();
+    }
+
+    // Task/mesh shading with per-meshlet culling when the device supports
+    // it, the vertex pipeline above otherwise.
+    bool useMeshlets = device.getFeatures().meshShader && cubeModel->hasMeshlets();
+
+    gfx::Pipeline meshletPipeline;
+    if (useMeshlets) {
+        meshletPipeline = gfx::Pipeline::Builder(device)
+            .setShader("assets/shaders/meshlet.task.spv", VK_SHADER_STAGE_TASK_BIT_EXT)
+            .setShader("assets/shaders/meshlet.mesh.spv", VK_SHADER_STAGE_MESH_BIT_EXT)
+            .setShader("assets/shaders/mesh.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
+            .setColorFormat(device.getSwapchain().getFormat())
+            .addPushConstantRange({
+                .stageFlags = VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT,
+                .offset = 0,
+                .size = sizeof(PushConstant) + sizeof(gfx::Mesh::MeshletPushConstants)
+            })
+            .setDepthTest(true)
+            .setDepthWrite(true)
+            .build();
+    }
+
+    // A procedural virtual texture drawn on the model through the vertex
+    // pulling path instead of its own texture; V toggles between them.
+    bool useVirtualTexture = device.getFeatures().fragmentStores;
+    bool showVirtualTexture = useVirtualTexture;
+
+    gfx::VirtualTexture virtualTexture;
+    gfx::Pipeline virtualTexturePipeline;
+    if (useVirtualTexture) {
+        constexpr u32 size = 16384;
+
+        // 64 texel checkers tinted per level, so the resident levels show.
+        auto provider = [](u32 level, u32 x, u32 y, u32 width, u32 height, u8 *dst) {
+            for (u32 j = 0; j < height; j++) {
+                for (u32 i = 0; i < width; i++) {
+                    bool light = (((x + i) >> 6) ^ ((y + j) >> 6)) & 1;
+
+                    u8 *texel = dst + (static_cast<usize>(j) * width + i) * 4;
+                    texel[0] = static_cast<u8>(level * 17);
+                    texel[1] = light ? 220 : 60;
+                    texel[2] = static_cast<u8>(255 - level * 17);
+                    texel[3] = 255;
+                }
+            }
+        };
 
-    u32 cameraUboIndex = bindlessManager.addUBO(cameraBuffer);
-
-    std::cout << "Camera UBO Index: " << cameraUboIndex << std::endl;
-
-    auto binding = gfx::Mesh::Vertex::getBindingDescription();
-    auto attributes = gfx::Mesh::Vertex::getAttributeDescriptions();
-
-    gfx::Pipeline pipeline = gfx::Pipeline::Builder(device)
-        .setShader("assets/shaders/mesh.vert.spv", VK_SHADER_STAGE_VERTEX_BIT)
-        .setShader("assets/shaders/mesh.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
-        .setColorFormat(device.getSwapchain().getFormat())
-        .setVertexInput({
-            .binding = &binding,
-            .attribute = attributes.data(),
-            .attributeCount = static_cast<u32>(attributes.size())
-        })
-        .addPushConstantRange({
-            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
-            .offset = 0,
-            .size = sizeof(PushConstant)
-        })
-        .setDepthTest(true)
-        .setDepthWrite(true)
-        .build();
+        virtualTexture.init(
+            device,
+            bindlessManager,
+            size,
+            size,
+            gfx::texture::getMipLevelCount(size, size),
+            VK_FORMAT_R8G8B8A8_UNORM,
+            provider
+        );
+
+        virtualTexturePipeline = gfx::Pipeline::Builder(device)
+            .setShader("assets/shaders/mesh_pull.vert.spv", VK_SHADER_STAGE_VERTEX_BIT)
+            .setShader("assets/shaders/virtual_texture.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
+            .setColorFormat(device.getSwapchain().getFormat())
+            .addPushConstantRange({
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                .offset = 0,
+                .size = VIRTUAL_TEXTURE_PUSH_OFFSET
+            })
+            .addPushConstantRange({
+                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .offset = VIRTUAL_TEXTURE_PUSH_OFFSET,
+                .size = sizeof(u32)
+            })
+            .setDepthTest(true)
+            .setDepthWrite(true)
+            .build();
+    }
 
     f32 deltaTime = 0.0f;
     f32 lastFrame = 0.0f;
@@ -136,14 +239,17 @@ int main()
             camera.setPitch(pitch);
         }
 
+        if (useVirtualTexture && window.isKeyJustPressed(GLFW_KEY_V)) {
+            showVirtualTexture = !showVirtualTexture;
+        }
+
         camera.setAspect(window.getAspect());
         camera.update();
 
-        CamUBO *cameraData = static_cast<CamUBO *>(cameraBuffer.map());
-        cameraData->view = camera.getView();
-        cameraData->proj = camera.getProjection();
-        cameraBuffer.unmap();
-
+        modelManager.update();
+        if (useVirtualTexture) {
+            virtualTexture.update();
+        }
         bindlessManager.update();
 
         VkCommandBuffer cmd = device.beginFrame();
@@ -151,30 +257,128 @@ int main()
             continue;
         }
 
-        pipeline.bind(cmd);
-
-        PushConstant pc = {
-            .model = glm::mat4(1.0f),
-            .index = cameraUboIndex
-        };
-
-        pipeline.push(
-            cmd,
-            VK_SHADER_STAGE_VERTEX_BIT,
-            sizeof(PushConstant),
-            &pc
-        );
-
-        modelManager.drawModel(cmd, cubeID);
+        // Written after beginFrame, once the GPU is done with the frame
+        // that last used this memory.
+        auto cameraData = device.getFrameAllocator().allocate<CamUBO>();
+        cameraData.data->view = camera.getView();
+        cameraData.data->proj = camera.getProjection();
+        cameraData.data->position = glm::vec4(camera.getPosition(), 1.0f);
+
+        if (showVirtualTexture) {
+            virtualTexturePipeline.bind(cmd);
+
+            PushConstant pc = {
+                .model = cubeModel->getDequantizeTransform(),
+                .camera = cameraData.address,
+                .vertexFormat = static_cast<u32>(cubeModel->getVertexFormat())
+            };
+
+            virtualTexturePipeline.push(
+                cmd,
+                VK_SHADER_STAGE_VERTEX_BIT,
+                sizeof(PushConstant),
+                &pc
+            );
+
+            u32 pageTable = virtualTexture.getPageTableIndex();
+            virtualTexturePipeline.push(
+                cmd,
+                VK_SHADER_STAGE_FRAGMENT_BIT,
+                sizeof(pageTable),
+                &pageTable,
+                VIRTUAL_TEXTURE_PUSH_OFFSET
+            );
+
+            modelManager.drawModelPulled(
+                cmd,
+                cubeID,
+                virtualTexturePipeline,
+                sizeof(PushConstant),
+                camera,
+                glm::mat4(1.0f),
+                static_cast<f32>(height)
+            );
+        } else if (useMeshlets) {
+            meshletPipeline.bind(cmd);
+
+            // Meshlet vertices are dequantized in the mesh shader.
+            PushConstant pc = {
+                .model = glm::mat4(1.0f),
+                .camera = cameraData.address,
+                .vertexFormat = static_cast<u32>(cubeModel->getVertexFormat())
+            };
+
+            meshletPipeline.push(
+                cmd,
+                VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT,
+                sizeof(PushConstant),
+                &pc
+            );
+
+            modelManager.requestTextures(
+                cubeID,
+                camera,
+                glm::mat4(1.0f),
+                static_cast<f32>(height)
+            );
+
+            modelManager.drawModelMeshlets(
+                cmd,
+                cubeID,
+                meshletPipeline,
+                sizeof(PushConstant)
+            );
+        } else {
+            pipeline.bind(cmd);
+
+            PushConstant pc = {
+                .model = cubeModel->getDequantizeTransform(),
+                .camera = cameraData.address,
+                .vertexFormat = static_cast<u32>(cubeModel->getVertexFormat())
+            };
+
+            pipeline.push(
+                cmd,
+                VK_SHADER_STAGE_VERTEX_BIT,
+                sizeof(PushConstant),
+                &pc
+            );
+
+            if (pullVertices) {
+                modelManager.drawModelPulled(
+                    cmd,
+                    cubeID,
+                    pipeline,
+                    sizeof(PushConstant),
+                    camera,
+                    glm::mat4(1.0f),
+                    static_cast<f32>(height)
+                );
+            } else {
+                modelManager.drawModel(
+                    cmd,
+                    cubeID,
+                    camera,
+                    glm::mat4(1.0f),
+                    static_cast<f32>(height)
+                );
+            }
+        }
 
         device.endFrame();
     }
 
     device.waitIdle();
 
-    cameraBuffer.destroy();
     modelManager.destroy();
     pipeline.destroy();
+    if (useMeshlets) {
+        meshletPipeline.destroy();
+    }
+    if (useVirtualTexture) {
+        virtualTexturePipeline.destroy();
+        virtualTexture.destroy();
+    }
     device.destroy();
     window.destroy();
 
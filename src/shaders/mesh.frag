@@ -1,12 +1,21 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : enable
 
 layout(location = 0) out vec4 outColor;
 
 layout(location = 0) in vec2 fragUV;
+layout(location = 1) flat in uint fragTexture;
+layout(location = 2) in vec3 fragNormal;
 
 layout(binding = 2) uniform sampler2D textures[];
 
+// Normals stay in model space; the demo draws its models unrotated.
+const vec3 LIGHT_DIR = normalize(vec3(0.4, 1.0, 0.6));
+
 void main()
 {
-    outColor = texture(textures[1], fragUV);
+    vec4 color = texture(textures[fragTexture], fragUV);
+
+    float diffuse = max(dot(normalize(fragNormal), LIGHT_DIR), 0.0);
+    outColor = vec4(color.rgb * (0.3 + 0.7 * diffuse), color.a);
 }
\ No newline at end of file
@@ -1,28 +1,62 @@
 #version 450
 #extension GL_EXT_nonuniform_qualifier : enable
+#extension GL_EXT_buffer_reference : require
 
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inUV;
 
-layout(set = 0, binding = 0) uniform CamUniforms {
+struct Camera
+{
     mat4 view;
     mat4 proj;
-} camUBO[];
+    vec4 position;
+};
+
+// Written through the frame allocator each frame, passed by address.
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer CameraRef {
+    Camera data;
+};
 
 layout(push_constant) uniform PushConstants {
     mat4 model;
-    uint camUBOIndex;
+    CameraRef camera;
+    uint vertexFormat;
 } pc;
 
 layout(location = 0) out vec2 fragUV;
+layout(location = 1) flat out uint fragTexture;
+layout(location = 2) out vec3 fragNormal;
+
+const uint VERTEX_FORMAT_PACKED = 1;
+
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main()
 {
-    mat4 view = camUBO[0].view;
-    mat4 proj = camUBO[0].proj;
+    Camera camera = pc.camera.data;
+    mat4 view = camera.view;
+    mat4 proj = camera.proj;
     mat4 model = pc.model;
 
+    // Packed positions are unorm in the model bounds; pc.model already
+    // contains the dequantize transform.
+    vec3 normal = inNormal;
+    if (pc.vertexFormat == VERTEX_FORMAT_PACKED) {
+        normal = decodeOctahedral(inNormal.xy);
+    }
+
     gl_Position = proj * view * model * vec4(inPos, 1.0);
     fragUV = inUV;
+    fragNormal = normal;
+
+    // Draws pass the bindless texture index as their first instance.
+    fragTexture = uint(gl_InstanceIndex);
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+
+// Vertex pulling variant of mesh.vert: no vertex input state, vertices are
+// read from the mesh's vertex buffer through its device address.
+
+struct Camera
+{
+    mat4 view;
+    mat4 proj;
+    vec4 position;
+};
+
+// Written through the frame allocator each frame, passed by address.
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer CameraRef {
+    Camera data;
+};
+
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer VertexRef {
+    uint words[];
+};
+
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+    CameraRef camera;
+    uint vertexFormat;
+    layout(offset = 80) VertexRef vertices;
+} pc;
+
+layout(location = 0) out vec2 fragUV;
+layout(location = 1) flat out uint fragTexture;
+layout(location = 2) out vec3 fragNormal;
+
+const uint VERTEX_FORMAT_PACKED = 1;
+
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+float loadVertexFloat(uint offset)
+{
+    return uintBitsToFloat(pc.vertices.words[offset]);
+}
+
+void main()
+{
+    Camera camera = pc.camera.data;
+
+    // gl_VertexIndex already includes the draw's vertex offset, which is
+    // the per-draw base when several meshes share one buffer.
+    uint vertexIndex = gl_VertexIndex;
+
+    vec3 pos;
+    vec3 normal;
+    vec2 uv;
+
+    // Packed positions are unorm in the model bounds; pc.model already
+    // contains the dequantize transform.
+    if (pc.vertexFormat == VERTEX_FORMAT_PACKED) {
+        uint b = vertexIndex * 4;
+        vec2 xy = unpackUnorm2x16(pc.vertices.words[b + 0]);
+        vec2 zw = unpackUnorm2x16(pc.vertices.words[b + 1]);
+
+        pos = vec3(xy, zw.x);
+        normal = decodeOctahedral(unpackSnorm2x16(pc.vertices.words[b + 2]));
+        uv = unpackHalf2x16(pc.vertices.words[b + 3]);
+    } else {
+        uint b = vertexIndex * 8;
+        pos = vec3(loadVertexFloat(b + 0), loadVertexFloat(b + 1), loadVertexFloat(b + 2));
+        normal = vec3(loadVertexFloat(b + 3), loadVertexFloat(b + 4), loadVertexFloat(b + 5));
+        uv = vec2(loadVertexFloat(b + 6), loadVertexFloat(b + 7));
+    }
+
+    gl_Position = camera.proj * camera.view * pc.model * vec4(pos, 1.0);
+    fragUV = uv;
+    fragNormal = normal;
+
+    // Draws pass the bindless texture index as their first instance.
+    fragTexture = uint(gl_InstanceIndex);
+}
\ No newline at end of file
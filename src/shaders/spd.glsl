@@ -0,0 +1,397 @@
+// Single pass downsampler. Every 256 invocation workgroup reduces a 64x64
+// tile of level 0 to one texel of level 6, and the last workgroup of each
+// array layer to finish reduces level 6 to the end of the chain, so up to
+// 12 levels are written by one dispatch.
+//
+// Included by spd.comp, which reduces 2x2 blocks with subgroup quad
+// operations, and by spd_shared.comp, which only uses shared memory.
+
+#extension GL_EXT_shader_image_load_formatted : require
+
+layout(local_size_x = 256) in;
+
+const uint REDUCTION_AVERAGE = 0;
+const uint REDUCTION_MIN = 1;
+const uint REDUCTION_MAX = 2;
+
+const uint MAX_LEVELS = 13;
+
+// Level 6 is read back by the last workgroup, so it is also bound on its
+// own as coherent.
+layout(set = 1, binding = 0) uniform image2DArray levels[MAX_LEVELS];
+layout(set = 1, binding = 1) coherent uniform image2DArray level6;
+
+// One counter per array layer, reset by the last workgroup.
+layout(set = 1, binding = 2) coherent buffer Counters {
+    uint counters[];
+};
+
+layout(push_constant) uniform PushConstants {
+    uint levelCount;
+    uint workGroupCount;
+    uint reduction;
+    uint srgb;
+} pc;
+
+shared vec4 intermediate[16][16];
+shared uint finishedCount;
+
+vec4 toLinear(vec4 color)
+{
+    if (pc.srgb == 0) {
+        return color;
+    }
+
+    vec3 low = color.rgb / 12.92;
+    vec3 high = pow((color.rgb + 0.055) / 1.055, vec3(2.4));
+    return vec4(mix(high, low, lessThanEqual(color.rgb, vec3(0.04045))), color.a);
+}
+
+vec4 toSrgb(vec4 color)
+{
+    if (pc.srgb == 0) {
+        return color;
+    }
+
+    vec3 low = color.rgb * 12.92;
+    vec3 high = 1.055 * pow(color.rgb, vec3(1.0 / 2.4)) - 0.055;
+    return vec4(mix(high, low, lessThanEqual(color.rgb, vec3(0.0031308))), color.a);
+}
+
+vec4 reduce4(vec4 v0, vec4 v1, vec4 v2, vec4 v3)
+{
+    if (pc.reduction == REDUCTION_MIN) {
+        return min(min(v0, v1), min(v2, v3));
+    }
+
+    if (pc.reduction == REDUCTION_MAX) {
+        return max(max(v0, v1), max(v2, v3));
+    }
+
+    return (v0 + v1 + v2 + v3) * 0.25;
+}
+
+#if SPD_SUBGROUP_QUAD
+vec4 reduceQuad(vec4 v)
+{
+    return reduce4(
+        v,
+        subgroupQuadSwapHorizontal(v),
+        subgroupQuadSwapVertical(v),
+        subgroupQuadSwapDiagonal(v)
+    );
+}
+#endif
+
+// Reads past the right and bottom edges repeat the border texel.
+vec4 loadLevel0(ivec2 texel, uint slice)
+{
+    ivec2 size = imageSize(levels[0]).xy;
+    return toLinear(imageLoad(levels[0], ivec3(min(texel, size - 1), slice)));
+}
+
+vec4 loadLevel6(ivec2 texel, uint slice)
+{
+    ivec2 size = imageSize(level6).xy;
+    return toLinear(imageLoad(level6, ivec3(min(texel, size - 1), slice)));
+}
+
+vec4 reduceLoadLevel0(uvec2 texel, uint slice)
+{
+    ivec2 p = ivec2(texel);
+    return reduce4(
+        loadLevel0(p + ivec2(0, 0), slice),
+        loadLevel0(p + ivec2(1, 0), slice),
+        loadLevel0(p + ivec2(0, 1), slice),
+        loadLevel0(p + ivec2(1, 1), slice)
+    );
+}
+
+vec4 reduceLoadLevel6(uvec2 texel, uint slice)
+{
+    ivec2 p = ivec2(texel);
+    return reduce4(
+        loadLevel6(p + ivec2(0, 0), slice),
+        loadLevel6(p + ivec2(1, 0), slice),
+        loadLevel6(p + ivec2(0, 1), slice),
+        loadLevel6(p + ivec2(1, 1), slice)
+    );
+}
+
+// Texels past the edge of odd sized levels are computed but never stored.
+void store(uvec2 texel, vec4 value, uint level, uint slice)
+{
+    ivec2 size = imageSize(levels[level]).xy;
+    if (any(greaterThanEqual(ivec2(texel), size))) {
+        return;
+    }
+
+    if (level == 6) {
+        imageStore(level6, ivec3(texel, slice), toSrgb(value));
+    } else {
+        imageStore(levels[level], ivec3(texel, slice), toSrgb(value));
+    }
+}
+
+vec4 reduceIntermediate(uvec2 i0, uvec2 i1, uvec2 i2, uvec2 i3)
+{
+    return reduce4(
+        intermediate[i0.x][i0.y],
+        intermediate[i1.x][i1.y],
+        intermediate[i2.x][i2.y],
+        intermediate[i3.x][i3.y]
+    );
+}
+
+// Morton order inside an 8x8 block, so every quad of invocations covers
+// a 2x2 block of texels.
+uvec2 remap8x8(uint index)
+{
+    return uvec2(
+        bitfieldInsert(bitfieldExtract(index, 2, 3), index, 0, 1),
+        bitfieldInsert(bitfieldExtract(index, 3, 3), bitfieldExtract(index, 1, 2), 0, 2)
+    );
+}
+
+// Levels 1 and 2 straight from level 0, four 16x16 quadrants of level 1
+// per workgroup. Level 2 is left in shared memory as a 16x16 block.
+void downsampleLevels1And2(uint x, uint y, uvec2 group, uint index, uint slice)
+{
+    vec4 v[4];
+
+    for (uint i = 0; i < 4; i++) {
+        uvec2 texel = group * 32 + uvec2(i % 2, i / 2) * 16 + uvec2(x, y);
+        v[i] = reduceLoadLevel0(texel * 2, slice);
+        store(texel, v[i], 1, slice);
+    }
+
+    if (pc.levelCount <= 1) {
+        return;
+    }
+
+#if SPD_SUBGROUP_QUAD
+    for (uint i = 0; i < 4; i++) {
+        v[i] = reduceQuad(v[i]);
+    }
+
+    if (index % 4 == 0) {
+        for (uint i = 0; i < 4; i++) {
+            uvec2 texel = uvec2(i % 2, i / 2) * 8 + uvec2(x, y) / 2;
+            store(group * 16 + texel, v[i], 2, slice);
+            intermediate[texel.x][texel.y] = v[i];
+        }
+    }
+#else
+    for (uint i = 0; i < 4; i++) {
+        intermediate[x][y] = v[i];
+        barrier();
+
+        if (index < 64) {
+            v[i] = reduceIntermediate(
+                uvec2(x * 2 + 0, y * 2 + 0),
+                uvec2(x * 2 + 1, y * 2 + 0),
+                uvec2(x * 2 + 0, y * 2 + 1),
+                uvec2(x * 2 + 1, y * 2 + 1)
+            );
+            store(group * 16 + uvec2(i % 2, i / 2) * 8 + uvec2(x, y), v[i], 2, slice);
+        }
+
+        barrier();
+    }
+
+    if (index < 64) {
+        for (uint i = 0; i < 4; i++) {
+            uvec2 texel = uvec2(i % 2, i / 2) * 8 + uvec2(x, y);
+            intermediate[texel.x][texel.y] = v[i];
+        }
+    }
+#endif
+}
+
+// The next four functions each halve the block in shared memory. Results
+// are spread over the block to avoid bank conflicts: the 8x8 level lands
+// at (2x + y % 2, 2y), the 4x4 level at (4x + y, 4y) and the 2x2 level at
+// (x + 2y, 0).
+void downsampleTo8x8(uint x, uint y, uvec2 group, uint index, uint level, uint slice)
+{
+#if SPD_SUBGROUP_QUAD
+    vec4 v = reduceQuad(intermediate[x][y]);
+
+    if (index % 4 == 0) {
+        store(group * 8 + uvec2(x, y) / 2, v, level, slice);
+        intermediate[x + (y / 2) % 2][y] = v;
+    }
+#else
+    if (index < 64) {
+        vec4 v = reduceIntermediate(
+            uvec2(x * 2 + 0, y * 2 + 0),
+            uvec2(x * 2 + 1, y * 2 + 0),
+            uvec2(x * 2 + 0, y * 2 + 1),
+            uvec2(x * 2 + 1, y * 2 + 1)
+        );
+        store(group * 8 + uvec2(x, y), v, level, slice);
+        intermediate[x * 2 + y % 2][y * 2] = v;
+    }
+#endif
+}
+
+void downsampleTo4x4(uint x, uint y, uvec2 group, uint index, uint level, uint slice)
+{
+#if SPD_SUBGROUP_QUAD
+    if (index < 64) {
+        vec4 v = reduceQuad(intermediate[x * 2 + y % 2][y * 2]);
+
+        if (index % 4 == 0) {
+            store(group * 4 + uvec2(x, y) / 2, v, level, slice);
+            intermediate[x * 2 + y / 2][y * 2] = v;
+        }
+    }
+#else
+    if (index < 16) {
+        vec4 v = reduceIntermediate(
+            uvec2(x * 4 + 0, y * 4 + 0),
+            uvec2(x * 4 + 2, y * 4 + 0),
+            uvec2(x * 4 + 1, y * 4 + 2),
+            uvec2(x * 4 + 3, y * 4 + 2)
+        );
+        store(group * 4 + uvec2(x, y), v, level, slice);
+        intermediate[x * 4 + y][y * 4] = v;
+    }
+#endif
+}
+
+void downsampleTo2x2(uint x, uint y, uvec2 group, uint index, uint level, uint slice)
+{
+#if SPD_SUBGROUP_QUAD
+    if (index < 16) {
+        vec4 v = reduceQuad(intermediate[x * 4 + y][y * 4]);
+
+        if (index % 4 == 0) {
+            store(group * 2 + uvec2(x, y) / 2, v, level, slice);
+            intermediate[x / 2 + y][0] = v;
+        }
+    }
+#else
+    if (index < 4) {
+        vec4 v = reduceIntermediate(
+            uvec2(x * 8 + y * 2 + 0, y * 8 + 0),
+            uvec2(x * 8 + y * 2 + 4, y * 8 + 0),
+            uvec2(x * 8 + y * 2 + 1, y * 8 + 4),
+            uvec2(x * 8 + y * 2 + 5, y * 8 + 4)
+        );
+        store(group * 2 + uvec2(x, y), v, level, slice);
+        intermediate[x + y * 2][0] = v;
+    }
+#endif
+}
+
+void downsampleTo1x1(uvec2 group, uint index, uint level, uint slice)
+{
+#if SPD_SUBGROUP_QUAD
+    if (index < 4) {
+        vec4 v = reduceQuad(intermediate[index][0]);
+
+        if (index == 0) {
+            store(group, v, level, slice);
+        }
+    }
+#else
+    if (index == 0) {
+        vec4 v = reduceIntermediate(uvec2(0, 0), uvec2(1, 0), uvec2(2, 0), uvec2(3, 0));
+        store(group, v, level, slice);
+    }
+#endif
+}
+
+// Levels `level` to `level + 3` from the 16x16 block in shared memory.
+void downsampleNextFour(uint x, uint y, uvec2 group, uint index, uint level, uint slice)
+{
+    if (pc.levelCount < level) {
+        return;
+    }
+
+    barrier();
+    downsampleTo8x8(x, y, group, index, level, slice);
+
+    if (pc.levelCount < level + 1) {
+        return;
+    }
+
+    barrier();
+    downsampleTo4x4(x, y, group, index, level + 1, slice);
+
+    if (pc.levelCount < level + 2) {
+        return;
+    }
+
+    barrier();
+    downsampleTo2x2(x, y, group, index, level + 2, slice);
+
+    if (pc.levelCount < level + 3) {
+        return;
+    }
+
+    barrier();
+    downsampleTo1x1(group, index, level + 3, slice);
+}
+
+// Levels 7 and 8 from the at most 64x64 texels of level 6. Level 8 is
+// left in shared memory as a 16x16 block.
+void downsampleLevels7And8(uint x, uint y, uint slice)
+{
+    vec4 v[4];
+
+    for (uint i = 0; i < 4; i++) {
+        uvec2 texel = uvec2(x, y) * 2 + uvec2(i % 2, i / 2);
+        v[i] = reduceLoadLevel6(texel * 2, slice);
+        store(texel, v[i], 7, slice);
+    }
+
+    if (pc.levelCount <= 7) {
+        return;
+    }
+
+    vec4 v8 = reduce4(v[0], v[1], v[2], v[3]);
+    store(uvec2(x, y), v8, 8, slice);
+    intermediate[x][y] = v8;
+}
+
+void main()
+{
+    uint index = gl_LocalInvocationIndex;
+    uvec2 group = gl_WorkGroupID.xy;
+    uint slice = gl_WorkGroupID.z;
+
+    uvec2 texel = remap8x8(index % 64);
+    uint x = texel.x + 8 * ((index >> 6) % 2);
+    uint y = texel.y + 8 * (index >> 7);
+
+    downsampleLevels1And2(x, y, group, index, slice);
+    downsampleNextFour(x, y, group, index, 3, slice);
+
+    if (pc.levelCount <= 6) {
+        return;
+    }
+
+    // Level 6 was written by invocation 0, which publishes it before
+    // counting the workgroup as finished.
+    if (index == 0) {
+        memoryBarrierImage();
+        finishedCount = atomicAdd(counters[slice], 1);
+    }
+
+    barrier();
+
+    if (finishedCount != pc.workGroupCount - 1) {
+        return;
+    }
+
+    if (index == 0) {
+        counters[slice] = 0;
+    }
+
+    memoryBarrierImage();
+
+    downsampleLevels7And8(x, y, slice);
+    downsampleNextFour(x, y, uvec2(0, 0), index, 9, slice);
+}
\ No newline at end of file
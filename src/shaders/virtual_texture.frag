@@ -0,0 +1,22 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Samples a VirtualTexture instead of the mesh texture.
+
+layout(location = 0) out vec4 outColor;
+
+layout(location = 0) in vec2 fragUV;
+
+layout(binding = 2) uniform sampler2D textures[];
+
+// After the vertex pulling block of mesh_pull.vert.
+layout(push_constant) uniform PushConstants {
+    layout(offset = 88) uint pageTable;
+} pc;
+
+#include "virtual_texture.glsl"
+
+void main()
+{
+    outColor = sampleVirtualTexture(pc.pageTable, fragUV);
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+// Sampling of VirtualTexture, given VirtualTexture::getPageTableIndex(). The
+// including shader declares `textures` at binding 2 and enables
+// GL_EXT_nonuniform_qualifier.
+//
+// Feedback is written for one pixel in four; the tiles it asks for are
+// loaded a few frames later, until then the finest resident ancestor is
+// sampled. Bilinear filtering at a tile edge may pick up texels of the
+// neighbouring tile, which is not guaranteed to be resident.
+
+layout(set = 0, binding = 1) buffer VirtualTexturePages {
+    uint words[];
+} vtPages[];
+
+// Header words, mirrored in virtual_texture.cpp.
+const uint VT_MODE = 0;
+const uint VT_WIDTH = 1;
+const uint VT_HEIGHT = 2;
+const uint VT_LEVEL_COUNT = 3;
+const uint VT_TAIL_LEVEL = 4;
+const uint VT_TILE_WIDTH = 5;
+const uint VT_TILE_HEIGHT = 6;
+const uint VT_IMAGE = 7;
+const uint VT_TAIL_IMAGE = 8;
+const uint VT_TAIL_BASE = 9;
+const uint VT_FEEDBACK = 10;
+const uint VT_CACHE_TILES_X = 11;
+const uint VT_LEVEL_OFFSETS = 12;
+
+const uint VT_MODE_SPARSE = 0;
+const uint VT_RESIDENT_BIT = 0x80000000u;
+
+uint vtWord(uint table, uint word)
+{
+    return vtPages[nonuniformEXT(table)].words[word];
+}
+
+// Entry word of the tile under `uv` on `level`.
+uint vtPageWord(uint table, vec2 uv, uint level, uvec2 size, uvec2 tile)
+{
+    uvec2 levelSize = max(size >> level, uvec2(1));
+    uvec2 pages = (levelSize + tile - 1) / tile;
+    uvec2 texel = uvec2(clamp(uv, 0.0, 1.0) * vec2(levelSize));
+    uvec2 page = min(texel / tile, pages - 1);
+
+    return vtWord(table, VT_LEVEL_OFFSETS + level) + page.y * pages.x + page.x;
+}
+
+vec4 sampleVirtualTexture(uint table, vec2 uv)
+{
+    uvec2 size = uvec2(vtWord(table, VT_WIDTH), vtWord(table, VT_HEIGHT));
+    uvec2 tile = uvec2(vtWord(table, VT_TILE_WIDTH), vtWord(table, VT_TILE_HEIGHT));
+    uint levelCount = vtWord(table, VT_LEVEL_COUNT);
+    uint tailLevel = vtWord(table, VT_TAIL_LEVEL);
+
+    vec2 texel = uv * vec2(size);
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0));
+    uint level = min(uint(lod), levelCount - 1);
+
+    if (level < tailLevel && all(equal(uvec2(gl_FragCoord.xy) & 1u, uvec2(0)))) {
+        uint feedback = vtWord(table, VT_FEEDBACK);
+        vtPages[nonuniformEXT(feedback)].words[vtPageWord(table, uv, level, size, tile)] = 1;
+    }
+
+    uint entry = 0;
+    while (level < tailLevel) {
+        entry = vtWord(table, vtPageWord(table, uv, level, size, tile));
+        if ((entry & VT_RESIDENT_BIT) != 0) {
+            break;
+        }
+        level++;
+    }
+
+    if (level < tailLevel && vtWord(table, VT_MODE) != VT_MODE_SPARSE) {
+        // Tile local texel, kept half a texel inside the tile so the
+        // filter does not reach into the neighbouring atlas slot.
+        uvec2 levelSize = max(size >> level, uvec2(1));
+        vec2 levelTexel = clamp(uv, 0.0, 1.0) * vec2(levelSize);
+        vec2 origin = vec2(min(uvec2(levelTexel) / tile, (levelSize - 1) / tile) * tile);
+        vec2 extent = min(vec2(tile), vec2(levelSize) - origin);
+        vec2 local = clamp(levelTexel - origin, vec2(0.5), extent - 0.5);
+
+        uint slot = entry & ~VT_RESIDENT_BIT;
+        uint cacheTilesX = vtWord(table, VT_CACHE_TILES_X);
+        vec2 slotOrigin = vec2(uvec2(slot % cacheTilesX, slot / cacheTilesX) * tile);
+
+        uint atlas = vtWord(table, VT_IMAGE);
+        vec2 atlasSize = vec2(textureSize(textures[nonuniformEXT(atlas)], 0));
+
+        return textureLod(textures[nonuniformEXT(atlas)], (slotOrigin + local) / atlasSize, 0.0);
+    }
+
+    if (level < tailLevel) {
+        return textureLod(textures[nonuniformEXT(vtWord(table, VT_IMAGE))], uv, float(level));
+    }
+
+    uint tailBase = vtWord(table, VT_TAIL_BASE);
+    uint tailImage = vtWord(table, VT_TAIL_IMAGE);
+
+    return textureLod(textures[nonuniformEXT(tailImage)], uv, float(level - tailBase));
+}
\ No newline at end of file